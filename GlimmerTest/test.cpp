@@ -34,7 +34,7 @@ void TestWindow(glimmer::UIConfig& config)
     int32_t widgets[TOTAL];
 
     auto lid = glimmer::GetNextId(glimmer::WT_Label);
-    auto& st = glimmer::GetWidgetConfig(lid).state.label;
+    auto& st = *glimmer::GetWidgetConfig(lid).state.label;
     st.text = svg;
     st.type = glimmer::TextType::SVG;
 
@@ -42,11 +42,11 @@ void TestWindow(glimmer::UIConfig& config)
     widgets[UPPER] = lid;
 
     lid = glimmer::GetNextId(glimmer::WT_Label);
-    glimmer::GetWidgetConfig(lid).state.label.text = "Left";
+    glimmer::GetWidgetConfig(lid).state.label->text = "Left";
     widgets[LEFT] = lid;
 
     lid = glimmer::GetNextId(glimmer::WT_Label);
-    glimmer::GetWidgetConfig(lid).state.label.text = "Left2";
+    glimmer::GetWidgetConfig(lid).state.label->text = "Left2";
     widgets[LEFT2] = lid;
 
     lid = glimmer::GetNextId(glimmer::WT_Splitter);
@@ -58,19 +58,19 @@ void TestWindow(glimmer::UIConfig& config)
     widgets[SPLIT2] = lid;
 
     lid = glimmer::GetNextId(glimmer::WT_Label);
-    glimmer::GetWidgetConfig(lid).state.label.text = "Content";
+    glimmer::GetWidgetConfig(lid).state.label->text = "Content";
     widgets[CONTENT] = lid;
 
     lid = glimmer::GetNextId(glimmer::WT_Label);
-    glimmer::GetWidgetConfig(lid).state.label.text = "Bottom";
+    glimmer::GetWidgetConfig(lid).state.label->text = "Bottom";
     widgets[BOTTOM] = lid;
 
     auto tid = glimmer::GetNextId(glimmer::WT_ToggleButton);
-    glimmer::GetWidgetConfig(tid).state.toggle.checked = false;
+    glimmer::GetWidgetConfig(tid).state.toggle->checked = false;
     widgets[TOGGLE] = tid;
 
     tid = glimmer::GetNextId(glimmer::WT_RadioButton);
-    glimmer::GetWidgetConfig(tid).state.radio.checked = false;
+    glimmer::GetWidgetConfig(tid).state.radio->checked = false;
     widgets[RADIO] = tid;
 
     tid = glimmer::GetNextId(glimmer::WT_Checkbox);
@@ -78,37 +78,37 @@ void TestWindow(glimmer::UIConfig& config)
     widgets[CHECKBOX] = tid;
 
     tid = glimmer::GetNextId(glimmer::WT_Spinner);
-    glimmer::GetWidgetConfig(tid).state.spinner.max = 100;
+    glimmer::GetWidgetConfig(tid).state.spinner->max = 100;
     widgets[SPINNER] = tid;
 
     tid = glimmer::GetNextId(glimmer::WT_TextInput);
-    auto& model = glimmer::GetWidgetConfig(tid).state.input;
+    auto& model = *glimmer::GetWidgetConfig(tid).state.input;
     model.placeholder = "This will be removed!";
     model.text.reserve(256);
     widgets[INPUT] = tid;
 
     tid = glimmer::GetNextId(glimmer::WT_Slider);
-    auto& slider = glimmer::GetWidgetConfig(tid).state.slider;
+    auto& slider = *glimmer::GetWidgetConfig(tid).state.slider;
     slider.max = 100.f;
     widgets[SLIDER] = tid;
 
     tid = glimmer::GetNextId(glimmer::WT_TabBar);
-    auto& tab = glimmer::GetWidgetConfig(tid).state.tab;
+    auto& tab = *glimmer::GetWidgetConfig(tid).state.tab;
     tab.sizing = glimmer::TabBarItemSizing::ResizeToFit;
     tab.expandTabs = true;
     widgets[TAB] = tid;
 
     tid = glimmer::GetNextId(glimmer::WT_DropDown);
-    auto& dd = glimmer::GetWidgetConfig(tid).state.dropdown;
+    auto& dd = *glimmer::GetWidgetConfig(tid).state.dropdown;
     dd.text = "DropDown";
     /*dd.ShowList = [](ImVec2, ImVec2 sz, glimmer::DropDownState&) {
         static int lid1 = glimmer::GetNextId(glimmer::WT_Label);
         static int lid2 = glimmer::GetNextId(glimmer::WT_Label);
 
-        glimmer::GetWidgetConfig(lid1).state.label.text = "First";
+        glimmer::GetWidgetConfig(lid1).state.label->text = "First";
         glimmer::Label(lid1);
         glimmer::Move(glimmer::FD_Vertical);
-        glimmer::GetWidgetConfig(lid2).state.label.text = "Second";
+        glimmer::GetWidgetConfig(lid2).state.label->text = "Second";
         glimmer::Label(lid2);
     };*/
     std::vector<std::pair<glimmer::WidgetType, std::string_view>> options;
@@ -120,13 +120,13 @@ void TestWindow(glimmer::UIConfig& config)
     widgets[ACCORDION] = glimmer::GetNextId(glimmer::WT_Accordion);
 
     auto gridid = glimmer::GetNextId(glimmer::WT_ItemGrid);
-    auto& grid = glimmer::GetWidgetConfig(gridid).state.grid;
+    auto& grid = *glimmer::GetWidgetConfig(gridid).state.grid;
     grid.celldata = [](std::pair<float, float>, int32_t row, int16_t col, int16_t) {
         static char buffer[128];
         auto sz = std::snprintf(buffer, 127, "Test-%d-%d", row, col);
 
         auto id = glimmer::GetNextId(glimmer::WT_Label);
-        glimmer::GetWidgetConfig(id).state.label.text = std::string_view{ buffer, (size_t)sz };
+        glimmer::GetWidgetConfig(id).state.label->text = std::string_view{ buffer, (size_t)sz };
         auto result = glimmer::Label(id);
 
         glimmer::Move(glimmer::FD_Horizontal);
@@ -148,17 +148,17 @@ void TestWindow(glimmer::UIConfig& config)
         auto id = glimmer::GetNextId(glimmer::WT_Label);
         if (level == 0)
         {
-            if (col == 0) glimmer::GetWidgetConfig(id).state.label.text = "Header#1";
-            else glimmer::GetWidgetConfig(id).state.label.text = "Header#2";
+            if (col == 0) glimmer::GetWidgetConfig(id).state.label->text = "Header#1";
+            else glimmer::GetWidgetConfig(id).state.label->text = "Header#2";
         }
         else
         {
             switch (col)
             {
-            case 0: glimmer::GetWidgetConfig(id).state.label.text = "Header#1.1"; break;
-            case 1: glimmer::GetWidgetConfig(id).state.label.text = "Header#1.2"; break;
-            case 2: glimmer::GetWidgetConfig(id).state.label.text = "Header#2.1"; break;
-            case 3: glimmer::GetWidgetConfig(id).state.label.text = "Header#2.2"; break;
+            case 0: glimmer::GetWidgetConfig(id).state.label->text = "Header#1.1"; break;
+            case 1: glimmer::GetWidgetConfig(id).state.label->text = "Header#1.2"; break;
+            case 2: glimmer::GetWidgetConfig(id).state.label->text = "Header#2.1"; break;
+            case 3: glimmer::GetWidgetConfig(id).state.label->text = "Header#2.2"; break;
             }
         }
         result = glimmer::Label(id);
@@ -299,6 +299,125 @@ void TestWindow(glimmer::UIConfig& config)
     }, data);
 }
 
+#ifdef GLIMMER_BENCHMARK_STREAMING
+#include <thread>
+#include <chrono>
+#include <cstdio>
+
+// Producers push 1M samples/sec each into their own series while the "UI" thread views
+// and trims every series at 60 Hz, reports delivered samples and drops per producer
+void BenchmarkStreamingSeries(int producers = 4, int seconds = 5)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int64_t SamplesPerSec = 1'000'000, Batch = 1000;
+    // A quarter second of history, well below the run length, so the ring wraps many times
+    // and drops only show up if the consumer actually falls behind
+    constexpr int64_t History = SamplesPerSec / 4;
+
+    std::vector<std::unique_ptr<glimmer::StreamingSeries>> series;
+    std::vector<std::thread> threads;
+    std::vector<int64_t> accepted(producers, 0);
+    std::atomic_bool done = false;
+    for (auto idx = 0; idx < producers; ++idx)
+        series.emplace_back(std::make_unique<glimmer::StreamingSeries>((int32_t)History));
+
+    auto start = Clock::now();
+    for (auto idx = 0; idx < producers; ++idx)
+    {
+        threads.emplace_back([&, idx] {
+            glimmer::SeriesSample batch[Batch];
+            int64_t total = 0, pushed = 0;
+
+            while (!done)
+            {
+                auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                while (total < (int64_t)(elapsed * SamplesPerSec))
+                {
+                    for (auto sample = 0; sample < Batch; ++sample)
+                        batch[sample] = { (double)(total + sample), (double)((total + sample) % 977) };
+                    pushed += series[idx]->Push(batch, (int32_t)Batch);
+                    total += Batch;
+                }
+                std::this_thread::yield();
+            }
+
+            accepted[idx] = pushed;
+        });
+    }
+
+    int64_t viewed = 0, frames = 0;
+    while (Clock::now() - start < std::chrono::seconds(seconds))
+    {
+        for (auto& entry : series)
+        {
+            entry->Trim();
+            auto view = entry->View();
+            viewed += view.size();
+        }
+
+        ++frames;
+        std::this_thread::sleep_for(std::chrono::microseconds(16667));
+    }
+
+    done = true;
+    for (auto& thread : threads) thread.join();
+
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto idx = 0; idx < producers; ++idx)
+    {
+        // Only samples the ring accepted count towards throughput, the last sample's x also
+        // counts the ones that were dropped while the ring was full
+        std::printf("producer %d: %.2fM samples/sec, %llu dropped\n", idx, (double)accepted[idx] / elapsed / 1e6,
+            (unsigned long long)series[idx]->dropped());
+    }
+    std::printf("%lld frames, %.1fM samples viewed per frame\n", (long long)frames, 
+        (double)viewed / (double)std::max<int64_t>(frames, 1) / 1e6);
+}
+#endif
+
+#ifdef GLIMMER_BENCHMARK_STARTUP
+#include <chrono>
+#include <cstdio>
+
+// Time to first frame, split into platform creation, window creation, font discovery/loading
+// and the first rendered frame. Run it twice to compare a cold font index to a warm one.
+void BenchmarkStartup()
+{
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now(), last = start;
+    auto report = [&](const char* phase) {
+        auto now = Clock::now();
+        std::printf("%-12s %8.2f ms (total %8.2f ms)\n", phase,
+            std::chrono::duration<double, std::milli>(now - last).count(),
+            std::chrono::duration<double, std::milli>(now - start).count());
+        last = now;
+    };
+
+    auto& config = glimmer::GetUIConfig();
+    config.platform = glimmer::GetPlatform();
+    report("platform");
+
+    if (!config.platform->CreateWindow({ .title = "Glimmer Startup" })) return;
+    report("window");
+
+    glimmer::FontDescriptor desc;
+    desc.flags = glimmer::FLT_Proportional | glimmer::FLT_Antialias | glimmer::FLT_Hinting;
+    desc.sizes.push_back(16.f);
+    glimmer::LoadDefaultFonts(&desc);
+    config.renderer = glimmer::CreateImGuiRenderer();
+    config.defaultFontSz = 16.f;
+    report("fonts");
+
+    int32_t label = glimmer::GetNextId(glimmer::WT_Label);
+    glimmer::GetWidgetConfig(label).state.label->text = "Startup";
+    config.platform->PollEvents([](ImVec2, glimmer::IPlatform&, void* data) {
+        glimmer::Label(*(int32_t*)data);
+        return false;
+    }, &label);
+    report("first frame");
+}
+#endif
+
 #if !defined(_DEBUG) && defined(WIN32)
 int CALLBACK WinMain(
     HINSTANCE   hInstance,
@@ -310,6 +429,16 @@ int CALLBACK WinMain(
 int main(int argc, char** argv)
 #endif
 {
+#ifdef GLIMMER_BENCHMARK_STREAMING
+    BenchmarkStreamingSeries();
+    return 0;
+#endif
+
+#ifdef GLIMMER_BENCHMARK_STARTUP
+    BenchmarkStartup();
+    return 0;
+#endif
+
     auto& config = glimmer::GetUIConfig();
     config.platform = glimmer::GetPlatform();
     
@@ -0,0 +1,207 @@
+#include "allocator.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace glimmer
+{
+    static constexpr size_t ArenaAlignment = 16;
+
+    static size_t AlignUp(size_t amount)
+    {
+        return (amount + ArenaAlignment - 1) & ~(ArenaAlignment - 1);
+    }
+
+#pragma region CountingAllocator
+
+    CountingAllocator::CountingAllocator(IAllocator* upstream_)
+        : upstream{ upstream_ }
+    {}
+
+    void CountingAllocator::UpdatePeak(AtomicCounters& counter, int64_t live)
+    {
+        auto peak = counter.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !counter.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+    }
+
+    void* CountingAllocator::Allocate(size_t amount, AllocationTag tag)
+    {
+        auto& counter = counters[tag];
+        counter.allocations.fetch_add(1, std::memory_order_relaxed);
+        auto live = counter.liveBytes.fetch_add((int64_t)amount, std::memory_order_relaxed) + (int64_t)amount;
+        UpdatePeak(counter, live);
+        return upstream->Allocate(amount, tag);
+    }
+
+    void* CountingAllocator::Reallocate(void* ptr, size_t oldsz, size_t amount, AllocationTag tag)
+    {
+        auto& counter = counters[tag];
+        auto delta = (int64_t)amount - (int64_t)oldsz;
+        counter.reallocations.fetch_add(1, std::memory_order_relaxed);
+        auto live = counter.liveBytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+        UpdatePeak(counter, live);
+        return upstream->Reallocate(ptr, oldsz, amount, tag);
+    }
+
+    void CountingAllocator::Deallocate(void* ptr, size_t amount, AllocationTag tag)
+    {
+        auto& counter = counters[tag];
+        counter.deallocations.fetch_add(1, std::memory_order_relaxed);
+        counter.liveBytes.fetch_sub((int64_t)amount, std::memory_order_relaxed);
+        upstream->Deallocate(ptr, amount, tag);
+    }
+
+    CountingAllocator::Counters CountingAllocator::Total(AllocationTag tag) const
+    {
+        Counters result;
+        auto from = tag == AT_Total ? 0 : (int)tag;
+        auto to = tag == AT_Total ? (int)AT_Total : (int)tag + 1;
+
+        for (auto idx = from; idx < to; ++idx)
+        {
+            result.allocations += counters[idx].allocations.load(std::memory_order_relaxed);
+            result.reallocations += counters[idx].reallocations.load(std::memory_order_relaxed);
+            result.deallocations += counters[idx].deallocations.load(std::memory_order_relaxed);
+            result.liveBytes += counters[idx].liveBytes.load(std::memory_order_relaxed);
+            result.peakBytes += counters[idx].peakBytes.load(std::memory_order_relaxed);
+        }
+
+        return result;
+    }
+
+    int64_t CountingAllocator::FrameAllocations(AllocationTag tag) const
+    {
+        int64_t result = 0;
+        auto from = tag == AT_Total ? 0 : (int)tag;
+        auto to = tag == AT_Total ? (int)AT_Total : (int)tag + 1;
+
+        for (auto idx = from; idx < to; ++idx)
+        {
+            result += counters[idx].allocations.load(std::memory_order_relaxed) +
+                counters[idx].reallocations.load(std::memory_order_relaxed) -
+                counters[idx].frameStart.load(std::memory_order_relaxed);
+        }
+
+        return result;
+    }
+
+    void CountingAllocator::MarkFrame()
+    {
+        for (auto idx = 0; idx < AT_Total; ++idx)
+        {
+            counters[idx].frameStart.store(counters[idx].allocations.load(std::memory_order_relaxed) +
+                counters[idx].reallocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+#pragma endregion
+
+#pragma region FrameArenaAllocator
+
+    FrameArenaAllocator::FrameArenaAllocator(size_t chunksz_, IAllocator* upstream_)
+        : upstream{ upstream_ }, chunksz{ AlignUp(chunksz_) }
+    {}
+
+    FrameArenaAllocator::~FrameArenaAllocator()
+    {
+        while (head != nullptr)
+        {
+            auto next = head->next;
+            upstream->Deallocate(head, sizeof(Chunk) + head->size, AT_General);
+            head = next;
+        }
+    }
+
+    FrameArenaAllocator::Chunk* FrameArenaAllocator::AddChunk(size_t minsz)
+    {
+        auto size = std::max(chunksz, AlignUp(minsz));
+        auto chunk = (Chunk*)upstream->Allocate(sizeof(Chunk) + size, AT_General);
+        chunk->next = head;
+        chunk->size = size;
+        chunk->used = 0;
+        if (head != nullptr) usedInFullChunks += head->used;
+        head = chunk;
+        return chunk;
+    }
+
+    void* FrameArenaAllocator::Allocate(size_t amount, AllocationTag)
+    {
+        amount = AlignUp(std::max(amount, (size_t)1));
+        auto chunk = head;
+
+        if (chunk == nullptr || (chunk->size - chunk->used) < amount)
+            chunk = AddChunk(amount);
+
+        auto ptr = (char*)(chunk + 1) + chunk->used;
+        chunk->used += amount;
+        last = ptr;
+        return ptr;
+    }
+
+    void* FrameArenaAllocator::Reallocate(void* ptr, size_t oldsz, size_t amount, AllocationTag tag)
+    {
+        if (ptr == nullptr) return Allocate(amount, tag);
+
+        // Grow/shrink in place if this is the most recent allocation
+        if (ptr == last)
+        {
+            auto offset = (size_t)((char*)ptr - (char*)(head + 1));
+            auto required = AlignUp(std::max(amount, (size_t)1));
+
+            if (offset + required <= head->size)
+            {
+                head->used = offset + required;
+                return ptr;
+            }
+        }
+
+        auto result = Allocate(amount, tag);
+        std::memcpy(result, ptr, std::min(oldsz, amount));
+        return result;
+    }
+
+    void FrameArenaAllocator::Deallocate(void* ptr, size_t, AllocationTag)
+    {
+        if (ptr != nullptr && ptr == last)
+        {
+            head->used = (size_t)((char*)ptr - (char*)(head + 1));
+            last = nullptr;
+        }
+    }
+
+    void FrameArenaAllocator::Reset()
+    {
+        if (head != nullptr && head->next != nullptr)
+        {
+            auto total = Capacity();
+
+            while (head != nullptr)
+            {
+                auto next = head->next;
+                upstream->Deallocate(head, sizeof(Chunk) + head->size, AT_General);
+                head = next;
+            }
+
+            usedInFullChunks = 0;
+            AddChunk(total);
+        }
+
+        if (head != nullptr) head->used = 0;
+        usedInFullChunks = 0;
+        last = nullptr;
+    }
+
+    size_t FrameArenaAllocator::Used() const
+    {
+        return usedInFullChunks + (head != nullptr ? head->used : 0);
+    }
+
+    size_t FrameArenaAllocator::Capacity() const
+    {
+        size_t total = 0;
+        for (auto chunk = head; chunk != nullptr; chunk = chunk->next) total += chunk->size;
+        return total;
+    }
+
+#pragma endregion
+}
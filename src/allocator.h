@@ -0,0 +1,93 @@
+#pragma once
+
+#include "utils.h"
+
+#include <atomic>
+
+#ifndef GLIMMER_FRAME_ARENA_CHUNKSZ
+#define GLIMMER_FRAME_ARENA_CHUNKSZ (64 * 1024)
+#endif
+
+namespace glimmer
+{
+    // Counts allocations per subsystem, counters are atomics so that it can be
+    // shared across threads without locking. Memory is obtained from upstream allocator.
+    struct CountingAllocator final : public IAllocator
+    {
+        struct Counters
+        {
+            int64_t allocations = 0;
+            int64_t reallocations = 0;
+            int64_t deallocations = 0;
+            int64_t liveBytes = 0;
+            int64_t peakBytes = 0;
+        };
+
+        explicit CountingAllocator(IAllocator* upstream = &DefaultAllocator);
+
+        void* Allocate(size_t amount, AllocationTag tag) override;
+        void* Reallocate(void* ptr, size_t oldsz, size_t amount, AllocationTag tag) override;
+        void Deallocate(void* ptr, size_t amount, AllocationTag tag) override;
+
+        // Totals since creation, tag = AT_Total returns sum over all tags
+        Counters Total(AllocationTag tag = AT_Total) const;
+
+        // Allocations + reallocations since last call to MarkFrame, useful to verify
+        // zero steady-state allocations per frame
+        int64_t FrameAllocations(AllocationTag tag = AT_Total) const;
+        void MarkFrame();
+
+    private:
+
+        struct AtomicCounters
+        {
+            std::atomic<int64_t> allocations{ 0 };
+            std::atomic<int64_t> reallocations{ 0 };
+            std::atomic<int64_t> deallocations{ 0 };
+            std::atomic<int64_t> liveBytes{ 0 };
+            std::atomic<int64_t> peakBytes{ 0 };
+            std::atomic<int64_t> frameStart{ 0 };
+        };
+
+        void UpdatePeak(AtomicCounters& counters, int64_t live);
+
+        IAllocator* upstream = nullptr;
+        AtomicCounters counters[AT_Total];
+    };
+
+    // Bump allocator for transient data, individual deallocations are no-ops (except
+    // for the most recent allocation), all memory is recycled by Reset()
+    struct FrameArenaAllocator final : public IAllocator
+    {
+        explicit FrameArenaAllocator(size_t chunksz = GLIMMER_FRAME_ARENA_CHUNKSZ, IAllocator* upstream = &DefaultAllocator);
+        ~FrameArenaAllocator();
+
+        void* Allocate(size_t amount, AllocationTag tag) override;
+        void* Reallocate(void* ptr, size_t oldsz, size_t amount, AllocationTag tag) override;
+        void Deallocate(void* ptr, size_t amount, AllocationTag tag) override;
+
+        // O(1) unless more than one chunk was used in the last frame, in which case
+        // the chunks are coalesced into one, so that steady state uses a single chunk
+        void Reset();
+
+        size_t Used() const;
+        size_t Capacity() const;
+
+    private:
+
+        struct Chunk
+        {
+            Chunk* next = nullptr;
+            size_t size = 0;
+            size_t used = 0;
+        };
+
+        Chunk* AddChunk(size_t minsz);
+
+        IAllocator* upstream = nullptr;
+        Chunk* head = nullptr; // Current chunk, older chunks are linked through next
+        void* last = nullptr; // Most recent allocation, can be grown/freed in place
+        size_t chunksz = 0;
+        size_t usedInFullChunks = 0;
+    };
+}
@@ -1,8 +1,13 @@
 #include "context.h"
 #include "im_font_manager.h"
 #include "renderer.h"
+#include "richtext.h"
+#include "profiler.h"
 #include "libs/inc/implot/implot.h"
 #include <list>
+#include <mutex>
+#include <cctype>
+#include <algorithm>
 
 #ifndef GLIMMER_MAX_OVERLAYS
 #define GLIMMER_MAX_OVERLAYS 32
@@ -14,11 +19,13 @@
 
 namespace glimmer
 {
-    static std::list<WidgetContextData> WidgetContexts;
-    static WidgetContextData* CurrentContext = nullptr;
+    // Context trees are per thread, independent UI trees can be built concurrently on
+    // separate threads. ImPlot (like ImGui) has a single process wide context.
+    static thread_local std::list<WidgetContextData> WidgetContexts;
+    static thread_local WidgetContextData* CurrentContext = nullptr;
+    static thread_local bool StartedRendering = false;
     static ImPlotContext* ChartsContext = nullptr;
-    static bool StartedRendering = false;
-    static bool HasImPlotContext = false;
+    static std::once_flag ImPlotInitialized;
 
     void CopyStyle(const StyleDescriptor& src, StyleDescriptor& dest);
 
@@ -60,11 +67,11 @@ namespace glimmer
             styles[idx].clear(false);
         }
 
-        itemIndexes.clear(true);
+        itemIndexes.clear(false);
         tabbars.clear(false);
         containerStack.clear(true);
-        rows.clear(true);
-        cols.clear(true);
+        rows.clear(false);
+        cols.clear(false);
     }
 
     void TabBarDescriptor::reset()
@@ -96,7 +103,9 @@ namespace glimmer
                 headers[idx][hidx].content = headers[idx][hidx].extent = ImRect{};
                 headers[idx][hidx].range = RendererEventIndexRange{};
                 headers[idx][hidx].alignment = TextAlignCenter;
-                headers[idx][hidx].offset = ImVec2{};
+                headers[idx][hidx].offset = headers[idx][hidx].shift = ImVec2{};
+                headers[idx][hidx].source = nullptr;
+                headers[idx][hidx].frozen = false;
                 headers[idx][hidx].parent = -1;
                 headers[idx][hidx].props = 0;
             }
@@ -105,9 +114,10 @@ namespace glimmer
         }
 
         headerHeights[0] = headerHeights[1] = headerHeights[2] = headerHeights[3] = headerHeight = 0.f;
+        pinnedRight = pinnedBottom = 0.f;
         currRow = currCol = 0;
         event = WidgetDrawResult{};
-        inRow = contentInteracted = addedBounds = false;
+        inRow = inPinnedRow = contentInteracted = addedBounds = false;
     }
 
     void AccordionBuilder::reset()
@@ -216,7 +226,7 @@ namespace glimmer
             }
             else if (type == WT_Scrollable && !layout.addedOffset)
             {
-                offset = states[type][index].state.scroll.state.pos;
+                offset = states.scrolls[index].state.pos;
             }
         }
 
@@ -251,19 +261,22 @@ namespace glimmer
     {
         StartedRendering = true;
 
-        if (!HasImPlotContext)
-        {
-            HasImPlotContext = true;
+        std::call_once(ImPlotInitialized, [] {
             ChartsContext = ImPlot::CreateContext();
             auto& style = ImPlot::GetStyle();
             style.PlotPadding = { 0.f, 0.f };
-        }
+        });
+
+        auto io = Config.platform->CurrentIO();
 
         for (auto it = WidgetContexts.rbegin(); it != WidgetContexts.rend(); ++it)
         {
             auto& context = *it;
             context.InsideFrame = true;
             context.adhocLayout.push();
+
+            // Content moves when scrolled, so the previous frame's geometry is stale
+            context.hitTest.Resolve(io.mousepos, io.mouseWheel != 0.f);
         }
 
         for (auto idx = 0; idx < WSI_Total; ++idx)
@@ -275,7 +288,7 @@ namespace glimmer
         for (auto& context : WidgetContexts)
         {
             context.InsideFrame = false;
-            context.adhocLayout.clear(true);
+            context.adhocLayout.clear(false);
 
             for (auto idx = 0; idx < WT_TotalTypes; ++idx)
             {
@@ -286,12 +299,15 @@ namespace glimmer
             context.maxids[WT_SplitterRegion] = 0;
             context.maxids[WT_Layout] = 0;
             context.maxids[WT_Charts] = 0;
+            context.hitTest.Build(context.activePopUpRegion);
             context.activePopUpRegion = ImRect{};
 
             assert(context.layouts.empty());
+            context.ResetFrameArena();
         }
 
         CurrentContext = &(*(WidgetContexts.begin()));
+        EndRichTextFrame();
 
         for (auto idx = 0; idx < WSI_Total; ++idx)
         {
@@ -302,6 +318,7 @@ namespace glimmer
 
     StyleDescriptor WidgetContextData::GetStyle(int32_t state)
     {
+        GLIMMER_PROFILE_SCOPE(PP_StyleResolution);
         auto style = log2((unsigned)state);
         auto res = StyleStack[style].top();
         AddFontPtr(res.font);
@@ -352,7 +369,11 @@ namespace glimmer
         auto wtype = (WidgetType)(id >> 16);
 
         if (wtype == WT_SplitterRegion)
+        {
+            if (index >= (int)splitterScrollPaneParentIds.size())
+                splitterScrollPaneParentIds.resize(index + 1, -1);
             splitterScrollPaneParentIds[index] = parentId;
+        }
 
         containerStack.push() = id;
     }
@@ -394,6 +415,8 @@ namespace glimmer
 
         itemGeometries[wtype][index] = geometry;
         adhocLayout.top().lastItemId = id;
+        auto itemid = id;
+        auto hitrect = geometry;
 
         if (!containerStack.empty() && !ignoreParent)
         {
@@ -403,7 +426,8 @@ namespace glimmer
             if (wtype == WT_Scrollable)
             {
                 index = id & 0xffff;
-                auto& region = states[wtype][index].state.scroll;
+                auto& region = states.scrolls[index];
+                hitrect.ClipWith(region.viewport);
                 region.content.x = std::max(region.content.x, geometry.Max.x);
                 region.content.y = std::max(region.content.y, geometry.Max.y);
             }
@@ -415,6 +439,9 @@ namespace glimmer
             }
         }
 
+        // Geometry in deferred mode is relative to deferred origin, hence not indexed
+        if (!usingDeferred) hitTest.Record(itemid, hitrect);
+
         /*if (currSpanDepth > 0 && spans[currSpanDepth].popWhenUsed)
         {
             spans[currSpanDepth] = ElementSpan{};
@@ -422,6 +449,155 @@ namespace glimmer
         }*/
     }
 
+    bool WidgetContextData::IsHovered(int32_t id, const ImRect& rect, ImVec2 mousepos) const
+    {
+        // Index rejects widgets not under pointer (or occluded), exact test is against the
+        // widget specific rect, as recorded geometry includes margins
+        if (hitTest.occluder.Contains(mousepos)) return false;
+        if (hitTest.IsIndexed(id) && !hitTest.IsHit(id)) return false;
+        return rect.Contains(mousepos);
+    }
+
+#pragma region Hit testing
+
+    void HitTestGrid::Record(int32_t id, const ImRect& rect)
+    {
+        // Widgets which moved (layout or content changes) are no longer indexed for this frame
+        auto wtype = id >> 16, index = id & 0xffff;
+        if (index < stamps[wtype].size() && stamps[wtype][index] == frame)
+        {
+            const auto& indexed = entries[slots[wtype][index]].rect;
+            if (indexed.Min.x != rect.Min.x || indexed.Min.y != rect.Min.y ||
+                indexed.Max.x != rect.Max.x || indexed.Max.y != rect.Max.y)
+                stamps[wtype][index] = 0;
+        }
+
+        if (rect.GetWidth() <= 0.f || rect.GetHeight() <= 0.f) return;
+        auto& entry = records.emplace_back();
+        entry.rect = rect;
+        entry.id = id;
+    }
+
+    void HitTestGrid::Build(const ImRect& popup)
+    {
+        // Previous frame's entries are replaced by current frame's records
+        entries.clear(false);
+        for (auto idx = 0; idx < records.size(); ++idx) entries.emplace_back(records[idx]);
+        records.clear(false);
+        occluder = popup;
+        ++frame;
+
+        bounds = entries.empty() ? ImRect{} : entries[0].rect;
+        for (auto idx = 0; idx < entries.size(); ++idx)
+        {
+            bounds.Add(entries[idx].rect);
+
+            auto id = entries[idx].id;
+            auto wtype = id >> 16, index = id & 0xffff;
+            auto& stamp = stamps[wtype];
+            if (index >= stamp.size()) stamp.expand(index + 1 - stamp.size(), true);
+            if (index >= slots[wtype].size()) slots[wtype].expand(index + 1 - slots[wtype].size(), true);
+            stamp[index] = frame;
+            slots[wtype][index] = idx;
+        }
+
+        cols = std::min((int32_t)std::ceil(bounds.GetWidth() / GLIMMER_HITTEST_CELLSZ), GLIMMER_HITTEST_MAX_CELLS);
+        rows = std::min((int32_t)std::ceil(bounds.GetHeight() / GLIMMER_HITTEST_CELLSZ), GLIMMER_HITTEST_MAX_CELLS);
+        cols = std::max(cols, 1); rows = std::max(rows, 1);
+        cellsz = ImVec2{ bounds.GetWidth() / (float)cols, bounds.GetHeight() / (float)rows };
+
+        // Counting sort of entries into cells, entries which span more than a quarter
+        // of the cells (i.e. containers) are tested linearly instead
+        constexpr int32_t MaxSpan = (GLIMMER_HITTEST_MAX_CELLS * GLIMMER_HITTEST_MAX_CELLS) / 4;
+        auto totalCells = cols * rows;
+        cellStart.clear(false);
+        cellStart.expand(totalCells + 1, false);
+        for (auto idx = 0; idx <= totalCells; ++idx) cellStart[idx] = 0;
+        oversized.clear(false);
+
+        auto cellRange = [this](const ImRect& rect, int32_t& c0, int32_t& c1, int32_t& r0, int32_t& r1) {
+            c0 = std::clamp((int32_t)((rect.Min.x - bounds.Min.x) / cellsz.x), 0, cols - 1);
+            c1 = std::clamp((int32_t)((rect.Max.x - bounds.Min.x) / cellsz.x), 0, cols - 1);
+            r0 = std::clamp((int32_t)((rect.Min.y - bounds.Min.y) / cellsz.y), 0, rows - 1);
+            r1 = std::clamp((int32_t)((rect.Max.y - bounds.Min.y) / cellsz.y), 0, rows - 1);
+        };
+
+        int32_t total = 0;
+        for (auto idx = 0; idx < entries.size(); ++idx)
+        {
+            int32_t c0, c1, r0, r1;
+            cellRange(entries[idx].rect, c0, c1, r0, r1);
+            if ((c1 - c0 + 1) * (r1 - r0 + 1) > MaxSpan) continue;
+
+            for (auto row = r0; row <= r1; ++row)
+                for (auto col = c0; col <= c1; ++col)
+                    cellStart[row * cols + col + 1]++;
+        }
+
+        for (auto idx = 0; idx < totalCells; ++idx) cellStart[idx + 1] += cellStart[idx];
+        total = cellStart[totalCells];
+        cellEntries.clear(false);
+        if (total > 0) cellEntries.expand(total, false);
+
+        // cellStart[cell] is used as insertion cursor and restored afterwards
+        for (auto idx = 0; idx < entries.size(); ++idx)
+        {
+            int32_t c0, c1, r0, r1;
+            cellRange(entries[idx].rect, c0, c1, r0, r1);
+
+            if ((c1 - c0 + 1) * (r1 - r0 + 1) > MaxSpan)
+            {
+                oversized.push_back(idx);
+                continue;
+            }
+
+            for (auto row = r0; row <= r1; ++row)
+                for (auto col = c0; col <= c1; ++col)
+                    cellEntries[cellStart[row * cols + col]++] = idx;
+        }
+
+        for (auto idx = totalCells; idx > 0; --idx) cellStart[idx] = cellStart[idx - 1];
+        cellStart[0] = 0;
+    }
+
+    void HitTestGrid::Resolve(ImVec2 pos, bool invalidate)
+    {
+        hits.clear(false);
+        valid = !invalidate && !entries.empty();
+        if (!valid || !bounds.Contains(pos)) return;
+
+        auto col = std::clamp((int32_t)((pos.x - bounds.Min.x) / cellsz.x), 0, cols - 1);
+        auto row = std::clamp((int32_t)((pos.y - bounds.Min.y) / cellsz.y), 0, rows - 1);
+        auto cell = row * cols + col;
+
+        for (auto idx = cellStart[cell]; idx < cellStart[cell + 1]; ++idx)
+        {
+            const auto& entry = entries[cellEntries[idx]];
+            if (entry.rect.Contains(pos)) hits.push_back(entry.id);
+        }
+
+        for (auto idx = 0; idx < oversized.size(); ++idx)
+        {
+            const auto& entry = entries[oversized[idx]];
+            if (entry.rect.Contains(pos)) hits.push_back(entry.id);
+        }
+    }
+
+    bool HitTestGrid::IsIndexed(int32_t id) const
+    {
+        auto wtype = id >> 16, index = id & 0xffff;
+        return valid && index < stamps[wtype].size() && stamps[wtype][index] == frame;
+    }
+
+    bool HitTestGrid::IsHit(int32_t id) const
+    {
+        for (auto idx = 0; idx < hits.size(); ++idx)
+            if (hits[idx] == id) return true;
+        return false;
+    }
+
+#pragma endregion
+
     void HandleLabelEvent(int32_t id, const ImRect& margin, const ImRect& border, const ImRect& padding,
         const ImRect& content, const ImRect& text, IRenderer& renderer, const IODescriptor& io, WidgetDrawResult& result);
     void HandleButtonEvent(int32_t id, const ImRect& margin, const ImRect& border, const ImRect& padding,
@@ -447,6 +623,7 @@ namespace glimmer
 
     WidgetDrawResult WidgetContextData::HandleEvents(ImVec2 origin, int from, int to)
     {
+        GLIMMER_PROFILE_SCOPE(PP_EventHandling);
         auto io = Config.platform->CurrentIO();
         auto& renderer = usingDeferred ? *deferedRenderer : *Config.renderer;
         WidgetDrawResult result;
@@ -459,23 +636,31 @@ namespace glimmer
             switch (ev.type)
             {
             case WT_Label: 
+                // Events of widgets not under the pointer are no-ops unless they have hover
+                // states to reset, skipping them matters for grids with many cells
+                ev.padding.Translate(origin); 
+                hitTest.Record(ev.id, ev.padding);
+                if (!IsHovered(ev.id, ev.padding, io.mousepos)) break;
                 ev.margin.Translate(origin);
                 ev.border.Translate(origin); 
-                ev.padding.Translate(origin); 
                 ev.content.Translate(origin); 
                 ev.text.Translate(origin);
                 HandleLabelEvent(ev.id, ev.margin, ev.border, ev.padding, ev.content, ev.text, renderer, io, result);
                 break;
             case WT_Button:
+                ev.padding.Translate(origin);
+                hitTest.Record(ev.id, ev.padding);
+                if (states.flags(ev.id) == WS_Default && !IsHovered(ev.id, ev.padding, io.mousepos)) break;
                 ev.margin.Translate(origin);
                 ev.border.Translate(origin);
-                ev.padding.Translate(origin);
                 ev.content.Translate(origin);
                 ev.text.Translate(origin);
                 HandleButtonEvent(ev.id, ev.margin, ev.border, ev.padding, ev.content, ev.text, renderer, io, result);
                 break;
             case WT_Checkbox:
                 ev.extent.Translate(origin);
+                hitTest.Record(ev.id, ev.extent);
+                if (!(states.flags(ev.id) & WS_Hovered) && !IsHovered(ev.id, ev.extent, io.mousepos)) break;
                 HandleCheckboxEvent(ev.id, ev.extent, io, result);
                 break;
             case WT_RadioButton:
@@ -527,7 +712,7 @@ namespace glimmer
             }
         }
 
-        if (to == -1) deferedEvents.clear(true);
+        if (to == -1) deferedEvents.clear(false);
         return result;
     }
 
@@ -537,7 +722,25 @@ namespace glimmer
             layouts[lidx].reset();
 
         layouts.clear(false);
-        layoutItems.clear(true);
+        layoutItems.clear(false);
+    }
+
+    void WidgetContextData::ResetFrameArena()
+    {
+        frameArena.Reset();
+
+        layoutItems.rebind(&frameArena);
+        deferedEvents.rebind(&frameArena);
+        adhocLayout.rebind(&frameArena);
+
+        // Only layout slots which were used are moved to arena
+        for (auto lidx = 0; lidx < layouts.constructed(); ++lidx)
+        {
+            auto& layout = layouts[lidx];
+            layout.itemIndexes.rebind(&frameArena);
+            layout.rows.rebind(&frameArena);
+            layout.cols.rebind(&frameArena);
+        }
     }
 
     const ImRect& WidgetContextData::GetGeometry(int32_t id) const
@@ -569,9 +772,7 @@ namespace glimmer
             }
             else if (wtype == WT_Scrollable)
             {
-                auto index = id & 0xffff;
-                auto type = id >> 16;
-                auto& region = states[type][index].state.scroll;
+                auto& region = ScrollRegion(id);
                 auto sz = ImVec2{ (region.type & ST_Horizontal) ? region.extent.x : region.viewport.GetWidth(),
                     (region.type & ST_Vertical) ? region.extent.y : region.viewport.GetHeight() };
                 return sz;
@@ -607,15 +808,13 @@ namespace glimmer
             if (wtype == WT_ItemGrid)
             {
                 auto& grid = CurrentItemGridContext->itemGrids.top();
-                const auto& config = CurrentItemGridContext->GetState(id).state.grid;
+                const auto& config = *CurrentItemGridContext->GetState(id).state.grid;
                 auto max = grid.headers[grid.currlevel][grid.currCol].extent.Max - config.cellpadding;
                 return max;
             }
             else if (wtype == WT_Scrollable)
             {
-                auto index = id & 0xffff;
-                auto type = id >> 16;
-                auto& region = states[type][index].state.scroll;
+                auto& region = ScrollRegion(id);
                 auto sz = ImVec2{ (region.type & ST_Horizontal) ? region.extent.x + region.viewport.Min.x : region.viewport.Max.x,
                     (region.type & ST_Vertical) ? region.extent.y + region.viewport.Min.y : region.viewport.Max.y };
                 return sz;
@@ -647,7 +846,70 @@ namespace glimmer
         auto ispopup = popupOrigin.x != -1.f;
         return ispopup ? popupSize : rect.GetSize();
     }
-    
+
+    template <typename FuncT>
+    static void VisitStates(WidgetStateStorage& storage, WidgetType type, FuncT&& func)
+    {
+        switch (type)
+        {
+        case WT_Label: func(storage.labels); break;
+        case WT_Button: func(storage.buttons); break;
+        case WT_ToggleButton: func(storage.toggles); break;
+        case WT_RadioButton: func(storage.radios); break;
+        case WT_Checkbox: func(storage.checkboxes); break;
+        case WT_Spinner: func(storage.spinners); break;
+        case WT_Slider: func(storage.sliders); break;
+        case WT_TextInput: func(storage.inputs); break;
+        case WT_DropDown: func(storage.dropdowns); break;
+        case WT_ItemGrid: func(storage.grids); break;
+        case WT_TabBar: func(storage.tabs); break;
+        case WT_Scrollable: func(storage.scrolls); break;
+        case WT_SplitterRegion: func(storage.regions); break;
+        default: break;
+        }
+    }
+
+    int32_t WidgetStateStorage::size(WidgetType type) const
+    {
+        return (int32_t)common[type].size();
+    }
+
+    void WidgetStateStorage::resize(WidgetType type, int32_t count)
+    {
+        VisitStates(*this, type, [count](auto& states) { states.resize(count); });
+        stateflags[type].resize(count, WS_Default);
+        common[type].resize(count);
+    }
+
+    WidgetConfigData WidgetStateStorage::get(int32_t id)
+    {
+        auto index = id & 0xffff;
+        WidgetConfigData config;
+        config.type = (WidgetType)(id >> 16);
+        config.flags = &stateflags[config.type][index];
+        config.data = &common[config.type][index];
+
+        switch (config.type)
+        {
+        case WT_Label: config.state.label = &labels[index]; break;
+        case WT_Button: config.state.button = &buttons[index]; break;
+        case WT_ToggleButton: config.state.toggle = &toggles[index]; break;
+        case WT_RadioButton: config.state.radio = &radios[index]; break;
+        case WT_Checkbox: config.state.checkbox = &checkboxes[index]; break;
+        case WT_Spinner: config.state.spinner = &spinners[index]; break;
+        case WT_Slider: config.state.slider = &sliders[index]; break;
+        case WT_TextInput: config.state.input = &inputs[index]; break;
+        case WT_DropDown: config.state.dropdown = &dropdowns[index]; break;
+        case WT_ItemGrid: config.state.grid = &grids[index]; break;
+        case WT_TabBar: config.state.tab = &tabs[index]; break;
+        case WT_Scrollable: config.state.scroll = &scrolls[index]; break;
+        case WT_SplitterRegion: config.state.scroll = &regions[index]; break;
+        default: break;
+        }
+
+        return config;
+    }
+
     WidgetContextData::WidgetContextData()
     {
         memset(maxids, 0, WT_TotalTypes);
@@ -663,27 +925,107 @@ namespace glimmer
         spinnerStates.resize(Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(WT_Spinner) : 8);
         tabBarStates.resize(Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(WT_TabBar) : 4);
         accordionStates.resize(Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(WT_Accordion) : 4);
-        splitterScrollPaneParentIds.resize((Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(WT_SplitterRegion) : 32) 
-            * GLIMMER_MAX_SPLITTER_REGIONS, -1);
-        dropDownOptions.resize(Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(WT_DropDown) : 16);
+        splitterScrollPaneParentIds.resize(Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(WT_SplitterRegion) : 32, -1);
+        dropDownLists.resize(Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(WT_DropDown) : 16);
 
         for (auto idx = 0; idx < WT_TotalTypes; ++idx)
         {
             maxids[idx] = 0;
-            states[idx].resize(Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount((WidgetType)idx) : 32, 
-                WidgetConfigData{ (WidgetType)idx });
+            states.resize((WidgetType)idx, Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount((WidgetType)idx) : 32);
         }
     }
     
-    SplitterInternalState::SplitterInternalState()
+    static uint32_t Trigram(const char* text)
     {
-        for (auto idx = 0; idx < GLIMMER_MAX_SPLITTER_REGIONS; ++idx)
+        return ((uint32_t)(uint8_t)std::tolower((unsigned char)text[0]) << 16) |
+            ((uint32_t)(uint8_t)std::tolower((unsigned char)text[1]) << 8) |
+            (uint32_t)(uint8_t)std::tolower((unsigned char)text[2]);
+    }
+
+    // query is expected to be lower case
+    static bool ContainsNoCase(std::string_view text, std::string_view query)
+    {
+        if (query.size() > text.size()) return false;
+
+        for (size_t start = 0; start + query.size() <= text.size(); ++start)
         {
-            states[idx] = WS_Default;
-            containers[idx] = -1;
-            isdragged[idx] = false;
-            dragstart[idx] = 0.f;
+            auto idx = 0u;
+            while (idx < query.size() && (char)std::tolower((unsigned char)text[start + idx]) == query[idx]) idx++;
+            if (idx == query.size()) return true;
         }
+
+        return false;
+    }
+
+    void DropDownFilterIndex::Build(OptionsT options)
+    {
+        source = options.data();
+        count = (int32_t)options.size();
+        trigrams.clear();
+        query.clear();
+        matches.clear();
+        all = true;
+
+        for (auto optidx = 0; optidx < count; ++optidx)
+        {
+            auto text = options[optidx].second;
+            for (auto idx = 0; idx + 2 < (int)text.size(); ++idx)
+            {
+                auto& postings = trigrams[Trigram(text.data() + idx)];
+                if (postings.empty() || postings.back() != optidx) postings.push_back(optidx);
+            }
+        }
+    }
+
+    void DropDownFilterIndex::Filter(OptionsT options, std::string_view text)
+    {
+        if (source != options.data() || count != (int32_t)options.size())
+            Build(options);
+
+        std::string lowered{ text };
+        for (auto& ch : lowered) ch = (char)std::tolower((unsigned char)ch);
+        if (!all && lowered == query) return;
+
+        if (lowered.empty())
+        {
+            all = true;
+            matches.clear();
+            query.clear();
+            return;
+        }
+
+        auto verify = [&](int32_t optidx) { return !ContainsNoCase(options[optidx].second, lowered); };
+
+        if (!all && !query.empty() && lowered.starts_with(query))
+        {
+            // Typing narrows down the current matches
+            matches.erase(std::remove_if(matches.begin(), matches.end(), verify), matches.end());
+        }
+        else if (lowered.size() >= 3u)
+        {
+            const std::vector<int32_t>* rarest = nullptr;
+
+            for (auto idx = 0; idx + 2 < (int)lowered.size(); ++idx)
+            {
+                auto it = trigrams.find(Trigram(lowered.data() + idx));
+                if (it == trigrams.end()) { rarest = nullptr; break; }
+                if (rarest == nullptr || it->second.size() < rarest->size()) rarest = &it->second;
+            }
+
+            matches.clear();
+            if (rarest != nullptr)
+                for (auto optidx : *rarest)
+                    if (!verify(optidx)) matches.push_back(optidx);
+        }
+        else
+        {
+            matches.clear();
+            for (auto optidx = 0; optidx < count; ++optidx)
+                if (!verify(optidx)) matches.push_back(optidx);
+        }
+
+        query = lowered;
+        all = false;
     }
 
     WidgetContextData& GetContext()
@@ -733,6 +1075,7 @@ namespace glimmer
 
     WidgetContextData& PushContext(int32_t id)
     {
+        AllocationTagScope tag{ AT_WidgetState };
         if (id < 0)
         {
             if (CurrentContext == nullptr)
@@ -777,14 +1120,15 @@ namespace glimmer
 
     void Cleanup()
     {
-        ImPlot::DestroyContext(ChartsContext);
+        if (ChartsContext != nullptr) ImPlot::DestroyContext(ChartsContext);
+        ChartsContext = nullptr;
     }
 
-    StyleStackT WidgetContextData::StyleStack[WSI_Total];
-    WidgetContextData* WidgetContextData::CurrentItemGridContext = nullptr;
-    DynamicStack<ToggleButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::toggleButtonStyles[WSI_Total];
-    DynamicStack<RadioButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES>  WidgetContextData::radioButtonStyles[WSI_Total];
-    DynamicStack<SliderStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::sliderStyles[WSI_Total];
-    DynamicStack<SpinnerStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::spinnerStyles[WSI_Total];
-    DynamicStack<TabBarStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::tabBarStyles[WSI_Total];
+    thread_local StyleStackT WidgetContextData::StyleStack[WSI_Total];
+    thread_local WidgetContextData* WidgetContextData::CurrentItemGridContext = nullptr;
+    thread_local DynamicStack<ToggleButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::toggleButtonStyles[WSI_Total];
+    thread_local DynamicStack<RadioButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES>  WidgetContextData::radioButtonStyles[WSI_Total];
+    thread_local DynamicStack<SliderStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::sliderStyles[WSI_Total];
+    thread_local DynamicStack<SpinnerStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::spinnerStyles[WSI_Total];
+    thread_local DynamicStack<TabBarStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::tabBarStyles[WSI_Total];
 }
\ No newline at end of file
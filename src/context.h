@@ -2,28 +2,68 @@
 
 #include "types.h"
 #include "style.h"
+#include "allocator.h"
 
 #include <bit>
-
-#ifndef GLIMMER_MAX_SPLITTER_REGIONS
-#define GLIMMER_MAX_SPLITTER_REGIONS 4
+#include <unordered_map>
+#include <memory>
+
+// Style stacks grow by this many entries at a time, GLLIMMER_MAX_STYLE_STACKSZ is the older spelling
+#ifndef GLIMMER_STYLE_STACK_BLOCKSZ
+#ifdef GLLIMMER_MAX_STYLE_STACKSZ
+#define GLIMMER_STYLE_STACK_BLOCKSZ GLLIMMER_MAX_STYLE_STACKSZ
+#else
+#define GLIMMER_STYLE_STACK_BLOCKSZ 16
 #endif
-
-#ifndef GLLIMMER_MAX_STYLE_STACKSZ
-#define GLLIMMER_MAX_STYLE_STACKSZ 16
 #endif
 
 #ifndef GLIMMER_MAX_WIDGET_SPECIFIC_STYLES
 #define GLIMMER_MAX_WIDGET_SPECIFIC_STYLES 4
 #endif
 
+#ifndef GLIMMER_HITTEST_CELLSZ
+#define GLIMMER_HITTEST_CELLSZ 64.f
+#endif
+
+#ifndef GLIMMER_HITTEST_MAX_CELLS
+#define GLIMMER_HITTEST_MAX_CELLS 64 // per dimension
+#endif
+
+#ifndef GLIMMER_MAX_GRID_SORT_COLUMNS
+#define GLIMMER_MAX_GRID_SORT_COLUMNS 4
+#endif
+
+// Row count from which item grid rows are sorted on multiple threads
+#ifndef GLIMMER_PARALLEL_SORT_MIN
+#define GLIMMER_PARALLEL_SORT_MIN 32768
+#endif
+
+#ifndef GLIMMER_MAX_SORT_THREADS
+#define GLIMMER_MAX_SORT_THREADS 16
+#endif
+
+// Changed rows beyond which the item grid re-sorts all rows instead of re-inserting changed ones
+#ifndef GLIMMER_INCREMENTAL_SORT_MAX
+#define GLIMMER_INCREMENTAL_SORT_MAX 64
+#endif
+
+// Top-level rows whose contents are requested at once from an item grid's columnar source
+#ifndef GLIMMER_GRID_FETCH_ROWS
+#define GLIMMER_GRID_FETCH_ROWS 64
+#endif
+
+#ifndef GLIMMER_DROPDOWN_MAX_ROWS
+#define GLIMMER_DROPDOWN_MAX_ROWS 12
+#endif
+
 namespace glimmer
 {
     // =============================================================================================
     // STATIC DATA
     // =============================================================================================
 
-    inline UIConfig Config{};
+    // Each thread builds its own UI tree against its own configuration (renderer, platform, scaling...)
+    inline thread_local UIConfig Config{};
 
     struct AnimationData
     {
@@ -49,8 +89,9 @@ namespace glimmer
         uint32_t gridcolor = IM_COL32(100, 100, 100, 255);
     };
 
-#ifndef GLIMMER_MAX_LAYOUT_NESTING 
-#define GLIMMER_MAX_LAYOUT_NESTING 8
+// Nesting stacks (layouts, splitters, accordions, item grids) allocate this many levels at a time
+#ifndef GLIMMER_NESTING_CHUNKSZ
+#define GLIMMER_NESTING_CHUNKSZ 4
 #endif
 
     enum WidgetStateIndex
@@ -65,6 +106,14 @@ namespace glimmer
         Default, ResizingColumns, ReorderingColumns
     };
 
+    struct EventDeferInfo;
+
+    struct RendererEventIndexRange
+    {
+        std::pair<int, int> primitives{ -1, -1 };
+        std::pair<int, int> events{ -1, -1 };
+    };
+
     struct ItemGridInternalState
     {
         struct HeaderCellResizeState
@@ -88,10 +137,152 @@ namespace glimmer
         {
             Vector<int16_t, int16_t> ltov{ 128, -1 };
             Vector<int16_t, int16_t> vtol{ 128, -1 };
+
+            // Unmapped columns are -1 and are mapped to themselves when first laid out
+            void ensure(int16_t count)
+            {
+                if (ltov.size() >= count) return;
+                ltov.resize(count, (int16_t)-1);
+                vtol.resize(count, (int16_t)-1);
+            }
+        };
+
+        // Filter of a column, keeps a bitmap of the rows it accepts so that editing one column's
+        // filter only re-evaluates that column
+        struct ColumnFilter
+        {
+            ItemGridFilterType type = ItemGridFilterType::None;
+            int16_t col = -1;
+            bool caseSensitive = false;
+            bool dirty = true;
+            double min = -DBL_MAX, max = DBL_MAX;
+            std::string text;
+            std::vector<std::string> texts; // sorted, for OneOf
+            std::vector<double> numbers;    // sorted, for OneOf
+            std::vector<uint64_t> bits;
+        };
+
+        // Display order of top-level rows, vtol maps display to logical rows and ltov maps back.
+        // Both are empty while the grid is unsorted, i.e. display and logical rows are the same.
+        // With filters, visible lists the logical rows which pass them in display order.
+        struct RowPermutation
+        {
+            std::vector<int32_t> vtol, ltov;
+            std::vector<int32_t> visible;
+            std::vector<int32_t> changed; // logical rows whose keys changed since last update
+            std::vector<ColumnFilter> filters;
+            ItemGridSortColumn sortcols[GLIMMER_MAX_GRID_SORT_COLUMNS];
+            int32_t rows = 0;
+            int16_t totalSortCols = 0;
+            bool dirty = false;    // sort columns changed, all rows are re-sorted
+            bool refilter = false; // filters were removed or combined differently
+            bool matchAny = false; // rows pass if they match any filter instead of all of them
+
+            bool filtered() const { return !filters.empty(); }
+            int32_t displayed(int32_t total) const { return filtered() ? (int32_t)visible.size() : total; }
+            int32_t logical(int32_t row) const 
+            { 
+                return filtered() ? visible[row] : row < (int32_t)vtol.size() ? vtol[row] : row; 
+            }
+        };
+
+        // Cell of a pinned row or column as it was last recorded, it is replayed translated by the
+        // difference between its current and recorded origin as long as its width is the same
+        struct CachedCell
+        {
+            ImVec2 origin;
+            float width = 0.f;
+            float bottom = 0.f; // extent of the cell's content below its origin
+            RendererEventIndexRange range; // into the cache's renderer and events
+            uint32_t used = 0; // last draw of the grid which recorded or replayed the cell
+        };
+
+        // Commands and events of pinned cells recorded across frames, keyed by logical row and column.
+        // Only cells drawn in the grid's last draw are kept. Dropped cells leave their commands behind,
+        // these are reclaimed by clearing the whole cache.
+        struct PinnedCellCache
+        {
+            std::shared_ptr<IRenderer> renderer;
+            std::vector<EventDeferInfo> events;
+            std::unordered_map<int64_t, CachedCell> cells;
+            int64_t hovered = -1; // cell drawn live while the pointer is over it
+            int32_t stale = 0;
+            uint32_t frame = 0;
+
+            static int64_t key(int32_t row, int16_t col) { return ((int64_t)row << 16) | (uint16_t)col; }
+
+            auto drop(std::unordered_map<int64_t, CachedCell>::iterator it) { ++stale; return cells.erase(it); }
         };
 
         Vector<HeaderCellResizeState, int16_t> cols[4];
         BiDirMap colmap[8];
+        RowPermutation rowmap;
+        // Contents of top-level rows [from, from + count) fetched from ItemGridState::columndata,
+        // texts and numbers hold GLIMMER_GRID_FETCH_ROWS entries per leaf column
+        struct ColumnBlock
+        {
+            std::vector<ItemGridColumnData> cols;
+            std::vector<std::string_view> texts;
+            std::vector<double> numbers;
+            std::vector<char> digits; // formatted numbers
+            std::vector<int32_t> rows; // logical rows of the block
+            int32_t from = 0, count = 0;
+            bool plainOnly = false; // every visible column is Text or Number, as of the last fetch
+
+            const ItemGridColumnData* plain(int16_t col) const
+            {
+                return cols[col].kind != ItemGridCellKind::Widget ? &cols[col] : nullptr;
+            }
+        };
+
+        // Nodes of a tree grid (ItemGridState::nodechildren) loaded so far, children of a node are
+        // loaded together when it is first expanded and are contiguous in nodes. visible is the
+        // flattened list of nodes in display order, updated in place on expand and collapse.
+        struct TreeRows
+        {
+            struct Node
+            {
+                int32_t id = -1;
+                int32_t parent = -1;     // index in nodes
+                int32_t firstChild = -1; // index in nodes
+                int32_t childCount = 0;
+                int16_t depth = 0;
+                bool expandable = true;
+                bool expanded = false;
+                bool loaded = false;
+            };
+
+            std::vector<Node> nodes;
+            std::vector<int32_t> visible;
+            std::vector<int32_t> ids; // scratch for loading children
+            int32_t roots = 0;
+            int32_t toggled = -1; // display row whose node is toggled on the next frame
+            bool loaded = false;
+
+            int32_t id(int32_t row) const { return nodes[visible[row]].id; }
+        };
+
+        // Heights of top-level rows (keyed by logical row) which were last drawn taller than a plain
+        // row, and the column which made them so. Only visible columns are measured, the height is
+        // kept while that column is scrolled out of view so rows do not change height as the grid
+        // scrolls horizontally, and is used to place rows which are skipped while out of view.
+        struct RowHeights
+        {
+            struct Entry
+            {
+                float height = 0.f;
+                int16_t col = -1;
+            };
+
+            std::unordered_map<int32_t, Entry> heights;
+            float widths = 0.f; // total width of leaf columns the heights were measured at
+            int32_t rows = -1;  // total top-level rows the heights were measured with
+        };
+
+        PinnedCellCache pinned;
+        RowHeights rowheights;
+        ColumnBlock block;
+        TreeRows tree;
         HeaderCellDragState drag;
         ScrollableRegion scroll;
         ImVec2 totalsz;
@@ -103,6 +294,14 @@ namespace glimmer
             int32_t state = WS_Default;
         } cellstate;
 
+        // Grows column maps and resize states of a header level to hold `count` columns
+        void ensureColumns(int level, int16_t count)
+        {
+            colmap[level].ensure(count);
+            if (cols[level].empty()) cols[level].fill(HeaderCellResizeState{});
+            if (cols[level].size() < count) cols[level].resize(count, HeaderCellResizeState{});
+        }
+
         template <typename ContainerT>
         void swapColumns(int16_t from, int16_t to, Span<ContainerT> headers, int level)
         {
@@ -220,12 +419,6 @@ namespace glimmer
     void RecordPopupBegin(ItemGridUIOperation& el, int32_t id, ImVec2 origin);
     void RecordPopupEnd(ItemGridUIOperation& el);
 
-    struct RendererEventIndexRange
-    {
-        std::pair<int, int> primitives{ -1, -1 };
-        std::pair<int, int> events{ -1, -1 };
-    };
-
     struct ColumnProps : public ItemGridState::ColumnConfig
     {
         ImVec2 offset;
@@ -233,6 +426,9 @@ namespace glimmer
         Vector<StyleDescriptor, int16_t, 2> styles{ false };
         RendererEventIndexRange range;
         int32_t alignment = TextAlignCenter;
+        IRenderer* source = nullptr; // renderer holding range's commands, cached cells only
+        ImVec2 shift; // translation of cached commands and events to the cell's current origin
+        bool frozen = false; // pinned column which does not scroll horizontally
     };
 
     struct CurrentItemGridState
@@ -253,6 +449,8 @@ namespace glimmer
         ImVec2 totalsz;
         float cellIndent = 0.f;
         float headerHeight = 0.f;
+        float pinnedRight = 0.f;  // scrolled columns are clipped to the right of this
+        float pinnedBottom = 0.f; // scrolled rows are clipped below this
         NeighborWidgets neighbors;
         ItemGridConstructPhase phase = ItemGridConstructPhase::None;
         Vector<ColumnProps, int16_t, 32> headers[4 + 1] = {
@@ -266,6 +464,7 @@ namespace glimmer
         int32_t currRow = 0, currCol = 0;
         WidgetDrawResult event;
         bool inRow = true;
+        bool inPinnedRow = false;
         bool contentInteracted = false;
         bool addedBounds = false;
 
@@ -351,15 +550,18 @@ namespace glimmer
             float curr = -1.f;
         };
 
-        int current = 0;
-        SplitRange spacing[GLIMMER_MAX_SPLITTER_REGIONS]; // spacing from (i-1)th to ith splitter
-        int32_t states[GLIMMER_MAX_SPLITTER_REGIONS]; // ith splitter's state
-        int32_t containers[GLIMMER_MAX_SPLITTER_REGIONS]; // id of ith container
-        ImRect viewport[GLIMMER_MAX_SPLITTER_REGIONS]; // ith non-scroll region geometry
-        bool isdragged[GLIMMER_MAX_SPLITTER_REGIONS]; // ith drag state
-        float dragstart[GLIMMER_MAX_SPLITTER_REGIONS]; // ith drag state
+        struct Region
+        {
+            SplitRange spacing; // spacing from (i-1)th to ith splitter
+            int32_t state = WS_Default; // ith splitter's state
+            int32_t container = -1; // id of ith container
+            ImRect viewport; // ith non-scroll region geometry
+            bool isdragged = false; // ith drag state
+            float dragstart = 0.f; // ith drag state
+        };
 
-        SplitterInternalState();
+        int current = 0;
+        std::vector<Region> regions; // grown to the number of splits on first use
     };
 
     struct SpinnerInternalState
@@ -385,7 +587,7 @@ namespace glimmer
 
     enum class LayoutOps { PushStyle, PopStyle, SetStyle, AddWidget };
 
-    using StyleStackT = DynamicStack<StyleDescriptor, int16_t, GLLIMMER_MAX_STYLE_STACKSZ>;
+    using StyleStackT = DynamicStack<StyleDescriptor, int16_t, GLIMMER_STYLE_STACK_BLOCKSZ>;
 
     struct TabItemDescriptor
     {
@@ -463,6 +665,13 @@ namespace glimmer
             ImRect extent, close, pin, text;
             bool pinned = false;
             TabItemDescriptor descriptor;
+
+            // Measured name extent, reused until the name, its type or the font changes
+            ImVec2 textsz;
+            std::size_t nameHash = 0;
+            void* font = nullptr;
+            float fontsz = -1.f;
+            TextType nameType = TextType::PlainText;
         };
 
         int16_t current = InvalidTabIndex;
@@ -511,6 +720,43 @@ namespace glimmer
         void reset();
     };
 
+    // Trigram index over drop-down options for case-insensitive substring filtering. Queries that
+    // extend the previous one only re-check the previous matches, others start from the rarest trigram.
+    struct DropDownFilterIndex
+    {
+        using OptionsT = std::span<std::pair<WidgetType, std::string_view>>;
+
+        const void* source = nullptr;
+        int32_t count = 0;
+        std::unordered_map<uint32_t, std::vector<int32_t>> trigrams;
+        std::string query;
+        std::vector<int32_t> matches;
+        bool all = true;
+
+        void Build(OptionsT options);
+        void Filter(OptionsT options, std::string_view text);
+
+        int32_t size() const { return all ? count : (int32_t)matches.size(); }
+        int32_t operator[](int32_t idx) const { return all ? idx : matches[idx]; }
+    };
+
+    // Built-in drop-down popup list, only visible rows are backed by widgets which are
+    // rebound to the options under them as the list scrolls
+    struct DropDownListState
+    {
+        struct RowWidgets
+        {
+            int32_t label = -1, checkbox = -1, toggle = -1;
+        };
+
+        DropDownFilterIndex filter;
+        std::vector<RowWidgets> rows;
+        std::vector<std::pair<int32_t, ImRect>> visible; // option index and popup relative geometry
+        ImRect region; // Popup region of the last frame in parent coordinates
+        int32_t first = 0;
+        float rowHeight = 0.f;
+    };
+
     struct AccordionInternalState
     {
         int16_t opened = -1;
@@ -584,12 +830,76 @@ namespace glimmer
         NestedContextSourceType source = NestedContextSourceType::None;
     };
 
+    // Dense per-type widget state arrays indexed by (id & 0xffff), so that each widget only
+    // occupies the size of its own state and same typed widgets are contiguous
+    struct WidgetStateStorage
+    {
+        std::vector<LabelState> labels;
+        std::vector<ButtonState> buttons;
+        std::vector<ToggleButtonState> toggles;
+        std::vector<RadioButtonState> radios;
+        std::vector<CheckboxState> checkboxes;
+        std::vector<SpinnerState> spinners;
+        std::vector<SliderState> sliders;
+        std::vector<TextInputState> inputs;
+        std::vector<DropDownState> dropdowns;
+        std::vector<TabBarState> tabs;
+        std::vector<ItemGridState> grids;
+        std::vector<ScrollableRegion> scrolls;
+        std::vector<ScrollableRegion> regions;
+
+        // Common widget data is split by access frequency: state flags of all widgets of a type
+        // are contiguous, as every widget reads them in every frame, tooltips etc. are kept apart
+        std::vector<int32_t> stateflags[WT_TotalTypes];
+        std::vector<CommonWidgetData> common[WT_TotalTypes];
+
+        int32_t& flags(int32_t id) { return stateflags[id >> 16][id & 0xffff]; }
+
+        int32_t size(WidgetType type) const;
+        void resize(WidgetType type, int32_t count);
+        WidgetConfigData get(int32_t id);
+    };
+
+    // Uniform grid over widget geometry recorded in the previous frame, the widgets under the
+    // pointer are resolved once per frame. Widgets rendered in deferred mode (e.g. item grid cells)
+    // are recorded when their events are replayed. Widgets which were not recorded, or whose
+    // geometry differs from the indexed one, have to be hit-tested individually.
+    struct HitTestGrid
+    {
+        struct Entry
+        {
+            ImRect rect;
+            int32_t id = -1;
+        };
+
+        Vector<Entry, int32_t> records{ false }; // Geometry recorded in current frame
+        Vector<Entry, int32_t> entries{ false }; // Geometry of previous frame, indexed by cells
+        Vector<int32_t, int32_t> cellStart{ false };
+        Vector<int32_t, int32_t> cellEntries{ false };
+        Vector<int32_t, int32_t> oversized{ false }; // Entries spanning too many cells
+        Vector<int32_t, int16_t> hits{ false }; // Ids under pointer in current frame
+        Vector<uint32_t, int16_t> stamps[WT_TotalTypes]; // Frame in which id was indexed
+        Vector<int32_t, int16_t> slots[WT_TotalTypes]; // Entry of id when it was indexed
+        ImRect bounds;
+        ImRect occluder; // Popup region over this context in previous frame
+        ImVec2 cellsz{ GLIMMER_HITTEST_CELLSZ, GLIMMER_HITTEST_CELLSZ };
+        int32_t cols = 0, rows = 0;
+        uint32_t frame = 1;
+        bool valid = false;
+
+        void Record(int32_t id, const ImRect& rect);
+        void Build(const ImRect& popup);
+        void Resolve(ImVec2 pos, bool invalidate);
+        bool IsIndexed(int32_t id) const;
+        bool IsHit(int32_t id) const;
+    };
+
     // Captures widget states, is stored as a linked-list, each context representing
     // a window or overlay, this enables serialized Id's for nested overlays as well
     struct WidgetContextData
     {
         // This is quasi-persistent
-        std::vector<WidgetConfigData> states[WT_TotalTypes];
+        WidgetStateStorage states;
         std::vector<ItemGridInternalState> gridStates;
         std::vector<TabBarInternalState> tabStates;
         std::vector<ToggleButtonInternalState> toggleStates;
@@ -601,32 +911,35 @@ namespace glimmer
         std::vector<TabBarInternalState> tabBarStates;
         std::vector<AccordionInternalState> accordionStates;
         std::vector<int32_t> splitterScrollPaneParentIds;
-        std::vector<std::vector<std::pair<int32_t, int32_t>>> dropDownOptions;
+        std::vector<DropDownListState> dropDownLists;
         
         // Tab bars are not nested
         TabBarDescriptor currentTab;
 
         // Stack of current item grids
-        DynamicStack<CurrentItemGridState, int16_t, 4> itemGrids{ false };
+        PooledStack<CurrentItemGridState, GLIMMER_NESTING_CHUNKSZ> itemGrids;
         DynamicStack<NestedContextSource, int16_t, 16> nestedContextStack{ false };
-        static WidgetContextData* CurrentItemGridContext;
+        static thread_local WidgetContextData* CurrentItemGridContext;
 
         std::vector<WidgetContextData*> nestedContexts[WT_TotalTypes];
         WidgetContextData* parentContext = nullptr;
 
         // Styling data is static as it is persisted across contexts
-        static StyleStackT StyleStack[WSI_Total];
+        static thread_local StyleStackT StyleStack[WSI_Total];
 
         // Per widget specific style objects
-        static DynamicStack<ToggleButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> toggleButtonStyles[WSI_Total];
-        static DynamicStack<RadioButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> radioButtonStyles[WSI_Total];
-        static DynamicStack<SliderStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> sliderStyles[WSI_Total];
-        static DynamicStack<SpinnerStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> spinnerStyles[WSI_Total];
-        static DynamicStack<TabBarStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> tabBarStyles[WSI_Total];
+        static thread_local DynamicStack<ToggleButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> toggleButtonStyles[WSI_Total];
+        static thread_local DynamicStack<RadioButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> radioButtonStyles[WSI_Total];
+        static thread_local DynamicStack<SliderStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> sliderStyles[WSI_Total];
+        static thread_local DynamicStack<SpinnerStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> spinnerStyles[WSI_Total];
+        static thread_local DynamicStack<TabBarStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> tabBarStyles[WSI_Total];
 
         // This has to persistent
         std::vector<AnimationData> animations{ AnimationsPreallocSz, AnimationData{} };
 
+        // Transient per-frame containers are allocated from this, reset in ResetFrameData
+        FrameArenaAllocator frameArena{ GLIMMER_FRAME_ARENA_CHUNKSZ, GlobalAllocator };
+
         // Layout related members
         Vector<LayoutItemDescriptor, int16_t> layoutItems{ 128 };
         Vector<ImRect, int16_t> itemGeometries[WT_TotalTypes]{
@@ -649,11 +962,11 @@ namespace glimmer
             Vector<ImRect, int16_t>{ true } 
         };
         DynamicStack<int32_t, int16_t> containerStack{ 16 };
-        FixedSizeStack<SplitterContainerState, 16> splitterStack;
-        FixedSizeStack<LayoutDescriptor, GLIMMER_MAX_LAYOUT_NESTING> layouts;
-        FixedSizeStack<AccordionBuilder, 4> accordions;
-        FixedSizeStack<Sizing, GLIMMER_MAX_LAYOUT_NESTING> sizing;
-        FixedSizeStack<int32_t, GLIMMER_MAX_LAYOUT_NESTING> spans;
+        PooledStack<SplitterContainerState, GLIMMER_NESTING_CHUNKSZ> splitterStack;
+        PooledStack<LayoutDescriptor, GLIMMER_NESTING_CHUNKSZ> layouts;
+        PooledStack<AccordionBuilder, GLIMMER_NESTING_CHUNKSZ> accordions;
+        PooledStack<Sizing, GLIMMER_NESTING_CHUNKSZ> sizing;
+        PooledStack<int32_t, GLIMMER_NESTING_CHUNKSZ> spans;
         DynamicStack<AdHocLayoutState, int16_t, 4> adhocLayout;
 
         // Keep track of widget IDs
@@ -671,19 +984,11 @@ namespace glimmer
         int32_t popupTarget = -1;
         ImRect activePopUpRegion;
         RendererEventIndexRange popupRange;
+        HitTestGrid hitTest;
 
-        WidgetConfigData& GetState(int32_t id)
-        {
-            auto index = id & 0xffff;
-            auto wtype = (WidgetType)(id >> 16);
-            return states[wtype][index];
-        }
-
-        WidgetConfigData const& GetState(int32_t id) const
+        WidgetConfigData GetState(int32_t id)
         {
-            auto index = id & 0xffff;
-            auto wtype = (WidgetType)(id >> 16);
-            return states[wtype][index];
+            return states.get(id);
         }
 
         ItemGridInternalState& GridState(int32_t id)
@@ -756,14 +1061,14 @@ namespace glimmer
         {
             auto index = id & 0xffff;
             auto type = id >> 16;
-            return states[type][index].state.scroll;
+            return type == WT_SplitterRegion ? states.regions[index] : states.scrolls[index];
         }
 
         ScrollableRegion const& ScrollRegion(int32_t id) const
         {
             auto index = id & 0xffff;
             auto type = id >> 16;
-            return states[type][index].state.scroll;
+            return type == WT_SplitterRegion ? states.regions[index] : states.scrolls[index];
         }
 
         static StyleDescriptor GetStyle(int32_t state);
@@ -773,9 +1078,11 @@ namespace glimmer
         void PushContainer(int32_t parentId, int32_t id);
         void PopContainer(int32_t id);
         void AddItemGeometry(int id, const ImRect& geometry, bool ignoreParent = false);
+        bool IsHovered(int32_t id, const ImRect& rect, ImVec2 mousepos) const;
         WidgetDrawResult HandleEvents(ImVec2 origin, int from = 0, int to = -1);
 
         void ResetLayoutData();
+        void ResetFrameArena();
 
         const ImRect& GetGeometry(int32_t id) const;
         ImRect GetLayoutSize() const;
@@ -1,6 +1,7 @@
 #include "draw.h"
 #include "context.h"
 #include "style.h"
+#include "richtext.h"
 
 namespace glimmer
 {
@@ -281,6 +282,8 @@ namespace glimmer
 
             renderer.ResetFont();
         }
+        else if (flags & TextIsRichText)
+            DrawRichText(text, textrect.Min, textrect.GetWidth(), style.font, style.fgcolor, renderer);
         
         renderer.ResetClipRect();
     }
@@ -5,5 +5,9 @@
 #include "style.h"
 #include "layout.h"
 #include "widgets.h"
+#include "profiler.h"
+#include "allocator.h"
+#include "richtext.h"
+#include "timeseries.h"
 #include "libs/inc/implot/implot.h"
 #include "libs/inc/implot/implot_internal.h"
@@ -82,10 +82,12 @@
     "/usr/share/fonts/TTF/Hack-Italic.ttf",\
     "/usr/share/fonts/TTF/Hack-BoldItalic.ttf",
 
-#include <sstream>
 #include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <chrono>
+#include <charconv>
 #include <memory>
-#include <array>
 
 #endif
 
@@ -117,10 +119,19 @@ namespace glimmer
         std::unordered_map<std::string_view, int> ProportionalFontFamilies;
         std::unordered_map<std::string_view, int> MonospaceFontFamilies;
         std::unordered_set<void*> MonospaceFonts;
-        std::unordered_set<std::string_view> LookupPaths;
+        std::unordered_set<std::string> LookupPaths; // directories which were already scanned
 
         void Register(const std::string& family, const std::string& filepath, FontType ft, bool isMono, bool serif)
         {
+            // Files of a family share one entry, the first file found for a font type is kept
+            auto& families = !isMono ? ProportionalFontFamilies : MonospaceFontFamilies;
+            if (auto it = families.find(family); it != families.end())
+            {
+                auto& existing = info[it->second];
+                if (existing.files[ft].empty()) existing.files[ft] = filepath;
+                return;
+            }
+
             auto& lookup = info.emplace_back();
             lookup.files[ft] = filepath;
             lookup.serif = serif;
@@ -523,7 +534,27 @@ namespace glimmer
         return result;
     }
 
-    // Extract font information from a TTF file
+    // Reads `length` bytes at `offset` of the font file, fails if the file is shorter
+    // Table offsets/lengths come from the file itself, ranges past the end of the file are
+    // rejected before allocating, and the stream is reset so a failed read does not fail
+    // every following one
+    static bool ReadFontBytes(std::ifstream& file, uint32_t offset, uint32_t length, std::vector<unsigned char>& buffer)
+    {
+        file.clear();
+        file.seekg(0, std::ios::end);
+        auto size = (uint64_t)file.tellg();
+        if (!file.good() || (uint64_t)offset + (uint64_t)length > size) { file.clear(); return false; }
+
+        buffer.resize(length);
+        file.seekg(offset, std::ios::beg);
+        file.read(reinterpret_cast<char*>(buffer.data()), length);
+        auto success = file.good() && (size_t)file.gcount() == length;
+        if (!success) file.clear();
+        return success;
+    }
+
+    // Extract font information from a TTF file, only the table directory and the
+    // 'name' and 'OS/2' tables are read instead of the entire file
     FontInfo ExtractFontInfo(const std::string& filename)
     {
         FontInfo info;
@@ -537,48 +568,46 @@ namespace glimmer
             return info;
         }
 
-        // Get file size
-        file.seekg(0, std::ios::end);
-        size_t fileSize = file.tellg();
-        file.seekg(0, std::ios::beg);
-
-        // Read the entire file into memory
-        std::vector<unsigned char> buffer(fileSize);
-        file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
-        file.close();
+        // Offset table i.e. sfnt version and number of tables
+        std::vector<unsigned char> buffer;
+        if (!ReadFontBytes(file, 0, 12, buffer)) return info;
 
-        // Check if this is a valid TTF file (signature should be 0x00010000 for TTF)
+        // sfnt version is 0x00010000 or 'true' for TrueType outlines and 'OTTO' for CFF based
+        // OpenType fonts, both have the same table directory and 'name'/'OS/2' tables
         uint32_t sfntVersion = ReadUInt32(buffer.data(), 0);
-        if (sfntVersion != 0x00010000 && sfntVersion != 0x4F54544F)
-        { // TTF or OTF
+        if (sfntVersion != 0x00010000 && sfntVersion != 0x74727565 && sfntVersion != 0x4F54544F)
+        {
 #ifdef _DEBUG
             std::cerr << "Error: Not a valid TTF/OTF file" << std::endl;
 #endif
             return info;
         }
 
-        // Parse the table directory
+        // Parse the table directory, which starts at offset 12
         uint16_t numTables = ReadUInt16(buffer.data(), 4);
+        if (!ReadFontBytes(file, 12, (uint32_t)numTables * 16u, buffer)) return info;
+
         bool foundName = false;
         bool foundOS2 = false;
-        uint32_t nameTableOffset = 0;
-        uint32_t os2TableOffset = 0;
+        uint32_t nameTableOffset = 0, nameTableLength = 0;
+        uint32_t os2TableOffset = 0, os2TableLength = 0;
 
-        // Table directory starts at offset 12
         for (int i = 0; i < numTables; i++)
         {
-            size_t entryOffset = 12 + i * 16;
+            size_t entryOffset = i * 16;
             char tag[5] = { 0 };
             memcpy(tag, buffer.data() + entryOffset, 4);
 
             if (strcmp(tag, "name") == 0)
             {
                 nameTableOffset = ReadUInt32(buffer.data(), entryOffset + 8);
+                nameTableLength = ReadUInt32(buffer.data(), entryOffset + 12);
                 foundName = true;
             }
             else if (strcmp(tag, "OS/2") == 0)
             {
                 os2TableOffset = ReadUInt32(buffer.data(), entryOffset + 8);
+                os2TableLength = ReadUInt32(buffer.data(), entryOffset + 12);
                 foundOS2 = true;
             }
 
@@ -587,22 +616,26 @@ namespace glimmer
 
         // Process the 'name' table if found
         // Docs: https://learn.microsoft.com/en-us/typography/opentype/spec/name
-        if (foundName)
+        if (foundName && nameTableLength >= 6 && ReadFontBytes(file, nameTableOffset, nameTableLength, buffer))
         {
-            uint16_t nameCount = ReadUInt16(buffer.data(), nameTableOffset + 2);
-            uint16_t storageOffset = ReadUInt16(buffer.data(), nameTableOffset + 4);
+            uint16_t nameCount = ReadUInt16(buffer.data(), 2);
+            uint16_t storageOffset = ReadUInt16(buffer.data(), 4);
             uint16_t familyNameID = 1;  // Font Family name
             uint16_t subfamilyNameID = 2;  // Font Subfamily name
 
             for (int i = 0; i < nameCount; i++)
             {
-                size_t recordOffset = nameTableOffset + 6 + i * 12;
+                size_t recordOffset = 6 + i * 12;
+                if (recordOffset + 12 > nameTableLength) break;
+
                 uint16_t platformID = ReadUInt16(buffer.data(), recordOffset);
                 uint16_t encodingID = ReadUInt16(buffer.data(), recordOffset + 2);
                 uint16_t languageID = ReadUInt16(buffer.data(), recordOffset + 4);
                 uint16_t nameID = ReadUInt16(buffer.data(), recordOffset + 6);
                 uint16_t length = ReadUInt16(buffer.data(), recordOffset + 8);
                 uint16_t stringOffset = ReadUInt16(buffer.data(), recordOffset + 10);
+                size_t stringStart = (size_t)storageOffset + stringOffset;
+                if (stringStart + length > nameTableLength) continue;
 
                 // We prefer English Windows (platformID=3, encodingID=1, languageID=0x0409)
                 bool isEnglish = (platformID == 3 && encodingID == 1 && (languageID == 0x0409 || languageID == 0));
@@ -616,9 +649,9 @@ namespace glimmer
                     {
                         // Convert UTF-16BE to ASCII for simplicity
                         std::string name;
-                        for (int j = 0; j < length; j += 2)
+                        for (int j = 0; j + 1 < length; j += 2)
                         {
-                            char c = buffer[nameTableOffset + storageOffset + stringOffset + j + 1];
+                            char c = buffer[stringStart + j + 1];
                             if (c) name.push_back(c);
                         }
                         info.fontFamily = name;
@@ -627,9 +660,9 @@ namespace glimmer
                     {
                         // Convert UTF-16BE to ASCII for simplicity
                         std::string name;
-                        for (int j = 0; j < length; j += 2)
+                        for (int j = 0; j + 1 < length; j += 2)
                         {
-                            char c = buffer[nameTableOffset + storageOffset + stringOffset + j + 1];
+                            char c = buffer[stringStart + j + 1];
                             if (c) name.push_back(c);
                         }
 
@@ -646,18 +679,18 @@ namespace glimmer
 
         // Process the 'OS/2' table if found
         // Docs: https://learn.microsoft.com/en-us/typography/opentype/spec/os2
-        if (foundOS2)
+        if (foundOS2 && os2TableLength >= 64 && ReadFontBytes(file, os2TableOffset, os2TableLength, buffer))
         {
             // Weight is at offset 4 in the OS/2 table
-            info.weight = ReadUInt16(buffer.data(), os2TableOffset + 4);
+            info.weight = ReadUInt16(buffer.data(), 4);
 
             // Check fsSelection bit field for italic flag (bit 0)
-            uint16_t fsSelection = ReadUInt16(buffer.data(), os2TableOffset + 62);
+            uint16_t fsSelection = ReadUInt16(buffer.data(), 62);
             if ((fsSelection & 0x01) || (fsSelection & 0x100)) info.isItalic = true;
             if (fsSelection & 0x10) info.isBold = true;
 
             uint8_t panose[10];
-            memcpy(panose, buffer.data() + os2TableOffset + 32, 10);
+            memcpy(panose, buffer.data() + 32, 10);
 
             // Refer to this: https://monotype.github.io/panose/pan2.htm for PANOSE docs
             if (panose[0] == 2 && panose[3] == 9) info.isMono = true;
@@ -668,124 +701,203 @@ namespace glimmer
         return info;
     }
 
+    static void RegisterFontFile(const std::string& fpath, const FontInfo& info)
+    {
+        auto isBold = info.isBold || (info.weight >= 600);
+        auto ftype = isBold && info.isItalic ? FT_BoldItalics :
+            isBold ? FT_Bold : info.isItalic ? FT_Italics :
+            (info.weight < 400) || info.isLight ? FT_Light : FT_Normal;
+        FontLookup.Register(info.fontFamily, fpath, ftype, info.isMono, info.isSerif);
+    }
+
 #if __linux__
-    struct FontFamilyInfo
+    // Font files found by scanning the font directories are kept in an index on disk, keyed by
+    // path and validated by size and modification time, so that later runs only parse the
+    // headers of files which were added or changed since
+    struct FontIndexEntry
     {
-        std::string filename;
-        std::string fontName;
-        std::string style;
+        std::string path;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        FontInfo info;
     };
 
-    // Function to execute a command and return the output
-    static std::string ExecCommand(const char* cmd)
+    enum FontIndexFlags
     {
-        std::array<char, 8192> buffer;
-        std::string result;
-        FILE* pipe = popen(cmd, "r");
-
-        if (!pipe) return std::string{};
-
-        while (fgets(buffer.data(), buffer.size(), pipe) != nullptr)
-            result += buffer.data();
+        FIF_Italic = 1, FIF_Bold = 2, FIF_Mono = 4, FIF_Light = 8, FIF_Serif = 16
+    };
 
-        pclose(pipe);
-        return result;
+    static std::string FontIndexPath()
+    {
+#ifdef GLIMMER_FONT_INDEX_PATH
+        return GLIMMER_FONT_INDEX_PATH;
+#else
+        if (auto cache = std::getenv("XDG_CACHE_HOME"); cache != nullptr && *cache != 0)
+            return std::string{ cache } + "/glimmer/font-index";
+        if (auto home = std::getenv("HOME"); home != nullptr && *home != 0)
+            return std::string{ home } + "/.cache/glimmer/font-index";
+        return std::string{};
+#endif
     }
 
-    // Trim whitespace from a string_view and return as string
-    static std::string_view Trim(std::string_view sv)
+    static std::vector<std::string> FontDirectories()
     {
-        // Find first non-whitespace
-        size_t start = 0;
-        while (start < sv.size() && std::isspace(sv[start]))
-            ++start;
+        std::vector<std::string> dirs{ "/usr/share/fonts", "/usr/local/share/fonts" };
+
+        if (auto data = std::getenv("XDG_DATA_HOME"); data != nullptr && *data != 0)
+            dirs.push_back(std::string{ data } + "/fonts");
+        if (auto home = std::getenv("HOME"); home != nullptr && *home != 0)
+        {
+            if (std::getenv("XDG_DATA_HOME") == nullptr) dirs.push_back(std::string{ home } + "/.local/share/fonts");
+            dirs.push_back(std::string{ home } + "/.fonts");
+        }
 
-        // Find last non-whitespace
-        size_t end = sv.size();
-        while (end > start && std::isspace(sv[end - 1]))
-            --end;
+        return dirs;
+    }
 
-        return sv.substr(start, end - start);
+    static bool IsFontFile(const std::filesystem::path& path)
+    {
+        auto ext = path.extension().string();
+        for (auto& ch : ext) ch = (char)std::tolower((unsigned char)ch);
+        return ext == ".ttf" || ext == ".otf";
     }
 
-    // Parse a single line from fc-list output
-    static FontFamilyInfo ParseFcListLine(const std::string& line)
+    // Line format: path \t size \t mtime \t weight \t flags \t family
+    static void LoadFontIndex(const std::string& indexPath, std::unordered_map<std::string, FontIndexEntry>& entries)
     {
-        FontFamilyInfo info;
-        std::string_view lineView(line);
+        std::ifstream file(indexPath);
+        std::string line;
 
-        // fc-list typically outputs: filename: font name:style=style1,style2,...
+        if (indexPath.empty() || !file.is_open() || !std::getline(file, line) || line != "glimmer-font-index 1")
+            return;
 
-        // Find the first colon for filename
-        size_t firstColon = lineView.find(':');
-        if (firstColon != std::string_view::npos)
+        while (std::getline(file, line))
         {
-            info.filename = Trim(lineView.substr(0, firstColon));
+            std::string_view fields[6];
+            std::string_view rest{ line };
+            auto count = 0;
 
-            // Find the second colon for font name
-            size_t secondColon = lineView.find(':', firstColon + 1);
-            if (secondColon != std::string_view::npos)
+            for (; count < 5; ++count)
             {
-                info.fontName = Trim(lineView.substr(firstColon + 1, secondColon - firstColon - 1));
+                auto tab = rest.find('\t');
+                if (tab == std::string_view::npos) break;
+                fields[count] = rest.substr(0, tab);
+                rest = rest.substr(tab + 1);
+            }
 
-                // Find "style=" after the second colon
-                std::string_view styleView = lineView.substr(secondColon + 1);
-                size_t stylePos = styleView.find("style=");
+            if (count < 5) continue;
+            fields[5] = rest;
+
+            FontIndexEntry entry;
+            int32_t weight = 400, flags = 0;
+            entry.path = fields[0];
+            std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), entry.size);
+            std::from_chars(fields[2].data(), fields[2].data() + fields[2].size(), entry.mtime);
+            std::from_chars(fields[3].data(), fields[3].data() + fields[3].size(), weight);
+            std::from_chars(fields[4].data(), fields[4].data() + fields[4].size(), flags);
+            entry.info.weight = weight;
+            entry.info.isItalic = flags & FIF_Italic;
+            entry.info.isBold = flags & FIF_Bold;
+            entry.info.isMono = flags & FIF_Mono;
+            entry.info.isLight = flags & FIF_Light;
+            entry.info.isSerif = flags & FIF_Serif;
+            entry.info.fontFamily = fields[5];
+            auto key = entry.path;
+            entries.emplace(std::move(key), std::move(entry));
+        }
+    }
 
-                if (stylePos != std::string_view::npos)
-                {
-                    styleView = styleView.substr(stylePos + 6); // 6 is length of "style="
-
-                    // Find the first comma in the style list
-                    size_t commaPos = styleView.find(',');
-                    if (commaPos != std::string_view::npos)
-                        info.style = Trim(styleView.substr(0, commaPos));
-                    else
-                        info.style = Trim(styleView);
-                }
-                else
-                    info.style = "Regular"; // Default style if not specified
-            }
-            else
+    static void SaveFontIndex(const std::string& indexPath, const std::vector<FontIndexEntry>& entries)
+    {
+        if (indexPath.empty()) return;
+
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path{ indexPath }.parent_path(), ec);
+
+        // Written to a temporary file first, so that a concurrent reader never sees a partial index
+        auto temp = indexPath + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::trunc);
+            if (!file.is_open()) return;
+
+            file << "glimmer-font-index 1\n";
+            for (const auto& entry : entries)
             {
-                // If there's no second colon, use everything after first colon as font name
-                info.fontName = Trim(lineView.substr(firstColon + 1));
-                info.style = "Regular";
+                auto flags = (entry.info.isItalic ? FIF_Italic : 0) | (entry.info.isBold ? FIF_Bold : 0) |
+                    (entry.info.isMono ? FIF_Mono : 0) | (entry.info.isLight ? FIF_Light : 0) |
+                    (entry.info.isSerif ? FIF_Serif : 0);
+                file << entry.path << '\t' << entry.size << '\t' << entry.mtime << '\t' << entry.info.weight
+                    << '\t' << flags << '\t' << entry.info.fontFamily << '\n';
             }
+
+            if (!file.good()) return;
         }
 
-        return info;
+        std::filesystem::rename(temp, indexPath, ec);
     }
 
-    static bool PopulateFromFcList()
+    // Scans the font directories recursively, fonts which are not in the index (or changed on
+    // disk) are parsed until the timeout expires, the rest are picked up by the next scan.
+    // Returns false if the scan timed out.
+    static bool PopulateFromFontDirectories(int timeoutMs)
     {
-        std::string output = ExecCommand("fc-list");
+        std::unordered_map<std::string, FontIndexEntry> indexed;
+        std::vector<FontIndexEntry> current;
+        auto indexPath = FontIndexPath();
+        LoadFontIndex(indexPath, indexed);
 
-        if (!output.empty())
+        auto start = std::chrono::steady_clock::now();
+        auto previousCount = indexed.size();
+        auto changed = false, timedOut = false;
+
+        for (const auto& dir : FontDirectories())
         {
-            std::istringstream iss(output);
-            std::string line;
+            std::error_code ec;
+            std::filesystem::recursive_directory_iterator it{ dir,
+                std::filesystem::directory_options::skip_permission_denied, ec }, end;
 
-            while (std::getline(iss, line))
+            for (; !ec && it != end; it.increment(ec))
             {
-                if (!line.empty())
+                const auto& entry = *it;
+                std::error_code fec;
+                if (!entry.is_regular_file(fec) || !IsFontFile(entry.path())) continue;
+
+                auto fpath = entry.path().string();
+                auto size = (uint64_t)entry.file_size(fec);
+                auto mtime = (int64_t)entry.last_write_time(fec).time_since_epoch().count();
+                auto existing = indexed.find(fpath);
+
+                if (existing != indexed.end() && existing->second.size == size && existing->second.mtime == mtime)
                 {
-                    auto info = ParseFcListLine(line);
-                    auto isBold = info.style.find("Bold") != std::string::npos;
-                    auto isItalics = (info.style.find("Oblique") != std::string::npos) ||
-                        (info.style.find("Italic") != std::string::npos);
-                    auto isMonospaced = info.fontName.find("Mono") != std::string::npos;
-                    auto ft = isBold && isItalics ? FT_BoldItalics : isBold ? FT_Bold :
-                        isItalics ? FT_Italics : FT_Normal;
-                    auto isSerif = info.fontName.find("Serif") != std::string::npos;
-                    FontLookup.Register(info.fontName, info.filename, ft, isMonospaced, isSerif);
+                    current.emplace_back(std::move(existing->second));
+                    continue;
                 }
-            }
 
-            return true;
+                if (timedOut) continue;
+
+#ifdef _DEBUG
+                std::cout << "Indexing font file: " << fpath << std::endl;
+#endif
+                auto& added = current.emplace_back();
+                added.path = std::move(fpath);
+                added.size = size;
+                added.mtime = mtime;
+                added.info = ExtractFontInfo(added.path);
+                changed = true;
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                timedOut = timeoutMs != -1 && elapsed > timeoutMs;
+            }
         }
 
-        return false;
+        if (changed || current.size() != previousCount) SaveFontIndex(indexPath, current);
+
+        for (const auto& entry : current)
+            if (!entry.info.fontFamily.empty())
+                RegisterFontFile(entry.path, entry.info);
+
+        return !timedOut;
     }
 #endif
 
@@ -816,23 +928,12 @@ namespace glimmer
             {
                 if (info.fontFamily.find(fname) != std::string::npos)
                 {
-                    auto isBold = info.isBold || (info.weight >= 600);
-                    auto ftype = isBold && info.isItalic ? FT_BoldItalics :
-                        isBold ? FT_Bold : info.isItalic ? FT_Italics :
-                        (info.weight < 400) || info.isLight ? FT_Light : FT_Normal;
-                    FontLookup.Register(info.fontFamily, fpath, ftype, info.isMono, info.isSerif);
+                    RegisterFontFile(fpath, info);
                     break;
                 }
             }
         }
-        else
-        {
-            auto isBold = info.isBold || (info.weight >= 600);
-            auto ftype = isBold && info.isItalic ? FT_BoldItalics :
-                isBold ? FT_Bold : info.isItalic ? FT_Italics :
-                (info.weight < 400) || info.isLight ? FT_Light : FT_Normal;
-            FontLookup.Register(info.fontFamily, fpath, ftype, info.isMono, info.isSerif);
-        }
+        else if (!info.fontFamily.empty()) RegisterFontFile(fpath, info);
     }
 
     static void PreloadFontLookupInfoImpl(int timeoutMs, std::string_view* lookupPaths, int lookupSz)
@@ -843,17 +944,20 @@ namespace glimmer
 
         for (auto idx = 0; idx < lookupSz; ++idx)
         {
-            if (FontLookup.LookupPaths.count(lookupPaths[idx]) == 0)
+            if (FontLookup.LookupPaths.count(std::string{ lookupPaths[idx] }) == 0)
                 notLookedUp.insert(lookupPaths[idx]);
         }
 
-        if (isDefaultPath)
 #ifdef _WIN32
-            notLookedUp.insert("C:\\Windows\\Fonts");
+        std::string_view defaultPath = "C:\\Windows\\Fonts";
 #elif __linux__
-            notLookedUp.insert("/usr/share/fonts/");
+        std::string_view defaultPath = "/usr/share/fonts/";
 #endif
 
+        if (isDefaultPath && FontLookup.LookupPaths.count(std::string{ defaultPath }) == 0)
+            notLookedUp.insert(defaultPath);
+        auto complete = true;
+
         if (!notLookedUp.empty())
         {
 #ifdef _WIN32
@@ -875,23 +979,7 @@ namespace glimmer
             }
 #elif __linux__
             if (isDefaultPath)
-            {
-                if (!PopulateFromFcList())
-                {
-                    auto start = std::chrono::system_clock().now().time_since_epoch().count();
-
-                    for (const auto& entry : std::filesystem::recursive_directory_iterator{ "/usr/share/fonts/" })
-                    {
-                        if (entry.is_regular_file() && entry.path().extension() == ".ttf")
-                        {
-                            ProcessFileEntry(entry, true);
-
-                            auto current = std::chrono::system_clock().now().time_since_epoch().count();
-                            if (timeoutMs != -1 && (int)(current - start) > timeoutMs) break;
-                        }
-                    }
-                }
-            }
+                complete = PopulateFromFontDirectories(timeoutMs);
             else
             {
                 auto start = std::chrono::system_clock().now().time_since_epoch().count();
@@ -911,6 +999,10 @@ namespace glimmer
                 }
             }
 #endif      
+
+            if (complete)
+                for (auto path : notLookedUp)
+                    FontLookup.LookupPaths.emplace(path);
         }
     }
 
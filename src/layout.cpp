@@ -3,6 +3,7 @@
 #include "context.h"
 #include "style.h"
 #include "draw.h"
+#include "profiler.h"
 
 #define GLIMMER_FLAT_LAYOUT_ENGINE 0
 #define GLIMMER_CLAY_LAYOUT_ENGINE 1
@@ -16,14 +17,15 @@
 #define CLAY_IMPLEMENTATION
 #include "libs/inc/clay/clay.h"
 
-Clay_Arena LayoutArena;
-void* LayoutMemory = nullptr;
+thread_local Clay_Arena LayoutArena;
+thread_local void* LayoutMemory = nullptr;
 #endif
 
 #if GLIMMER_LAYOUT_ENGINE == GLIMMER_YOGA_LAYOUT_ENGINE
 #include "libs/inc/yoga/Yoga.h"
-YGNodeRef root = nullptr;
-std::vector<YGNodeRef> children;
+// Layouts are built per thread, like the widget context tree
+thread_local YGNodeRef root = nullptr;
+thread_local std::vector<YGNodeRef> children;
 
 static ImRect GetBoundingBox(YGNodeConstRef node)
 {
@@ -261,7 +263,7 @@ namespace glimmer
     {
         if (layoutItem.wtype == WT_Scrollable)
         {
-            auto type = context.GetState(layoutItem.id).state.scroll.type;
+            auto type = context.GetState(layoutItem.id).state.scroll->type;
             if (type & ST_ReserveForVScroll)
             {
                 layoutItem.border.Max.x -= Config.scrollbarSz;
@@ -296,6 +298,7 @@ namespace glimmer
     void AddExtent(LayoutItemDescriptor& layoutItem, const StyleDescriptor& style, const NeighborWidgets& neighbors,
         ImVec2 size, ImVec2 totalsz)
     {
+        GLIMMER_PROFILE_SCOPE(PP_WidgetBounds);
         auto& context = GetContext();
         auto nextpos = !context.layouts.empty() ? context.layouts.top().nextpos : context.NextAdHocPos();
         auto [width, height] = size;
@@ -551,6 +554,7 @@ namespace glimmer
 
     void AddItemToLayout(LayoutDescriptor& layout, LayoutItemDescriptor& item, const StyleDescriptor& style)
     {
+        AllocationTagScope tag{ AT_Layout };
         layout.itemIndexes.emplace_back(GetContext().layoutItems.size(), LayoutOps::AddWidget);
 
 #if GLIMMER_LAYOUT_ENGINE == GLIMMER_FLAT_LAYOUT_ENGINE
@@ -757,6 +761,8 @@ namespace glimmer
 
     ImRect BeginLayout(Layout type, int32_t fill, int32_t alignment, bool wrap, ImVec2 spacing, const NeighborWidgets& neighbors)
     {
+        GLIMMER_PROFILE_SCOPE(PP_BeginLayout);
+        AllocationTagScope tag{ AT_Layout };
         auto& context = GetContext();
 
 #if GLIMMER_LAYOUT_ENGINE == GLIMMER_FLAT_LAYOUT_ENGINE
@@ -967,6 +973,7 @@ namespace glimmer
 
     static StyleDescriptor GetStyle(StyleStackT* StyleStack, int32_t state)
     {
+        GLIMMER_PROFILE_SCOPE(PP_StyleResolution);
         const auto& defstyle = !StyleStack[WSI_Default].empty() ? StyleStack[WSI_Default].top() : GetContext().GetStyle(WS_Default);
 
         auto idx = log2((unsigned)state);
@@ -982,15 +989,16 @@ namespace glimmer
         auto& context = GetContext();
         auto bbox = item.margin;
         auto wtype = (WidgetType)(item.id >> 16);
+        GLIMMER_PROFILE_SCOPE(PP_Widget, wtype);
         auto& renderer = context.GetRenderer();
         renderer.SetClipRect(bbox.Min, bbox.Max);
 
         switch (wtype)
         {
         case glimmer::WT_Label: {
-            auto& state = context.GetState(item.id).state.label;
+            auto& state = *context.GetState(item.id).state.label;
             auto flags = ToTextFlags(state.type);
-            const auto& style = GetStyle(StyleStack, state.state);
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = LabelImpl(item.id, style, item.margin, item.border, item.padding, item.content, item.text, renderer, io, flags);
@@ -999,9 +1007,9 @@ namespace glimmer
             break;
         }
         case glimmer::WT_Button: {
-            auto& state = context.GetState(item.id).state.button;
+            auto& state = *context.GetState(item.id).state.button;
             auto flags = ToTextFlags(state.type);
-            const auto& style = GetStyle(StyleStack, state.state);
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = ButtonImpl(item.id, style, item.margin, item.border, item.padding, item.content, item.text, renderer, io);
@@ -1010,8 +1018,8 @@ namespace glimmer
             break;
         }
         case glimmer::WT_RadioButton: {
-            auto& state = context.GetState(item.id).state.radio;
-            const auto& style = GetStyle(StyleStack, state.state);
+            auto& state = *context.GetState(item.id).state.radio;
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = RadioButtonImpl(item.id, state, style, item.margin, renderer, io);
@@ -1020,8 +1028,8 @@ namespace glimmer
             break;
         }
         case glimmer::WT_ToggleButton: {
-            auto& state = context.GetState(item.id).state.toggle;
-            const auto& style = GetStyle(StyleStack, state.state);
+            auto& state = *context.GetState(item.id).state.toggle;
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = ToggleButtonImpl(item.id, state, style, item.margin, ImVec2{ item.text.GetWidth(), item.text.GetHeight() }, renderer, io);
@@ -1030,8 +1038,8 @@ namespace glimmer
             break;
         }
         case glimmer::WT_Checkbox: {
-            auto& state = context.GetState(item.id).state.checkbox;
-            const auto& style = GetStyle(StyleStack, state.state);
+            auto& state = *context.GetState(item.id).state.checkbox;
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = CheckboxImpl(item.id, state, style, item.margin, item.padding, renderer, io);
@@ -1040,8 +1048,8 @@ namespace glimmer
             break;
         }
         case WT_Spinner: {
-            auto& state = context.GetState(item.id).state.spinner;
-            const auto& style = GetStyle(StyleStack, state.state);
+            auto& state = *context.GetState(item.id).state.spinner;
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = SpinnerImpl(item.id, state, style, item.padding, io, renderer);
@@ -1050,8 +1058,8 @@ namespace glimmer
             break;
         }
         case glimmer::WT_Slider: {
-            auto& state = context.GetState(item.id).state.slider;
-            const auto& style = GetStyle(StyleStack, state.state);
+            auto& state = *context.GetState(item.id).state.slider;
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = SliderImpl(item.id, state, style, item.border, renderer, io);
@@ -1060,8 +1068,8 @@ namespace glimmer
             break;
         }
         case glimmer::WT_TextInput: {
-            auto& state = context.GetState(item.id).state.input;
-            const auto& style = GetStyle(StyleStack, state.state);
+            auto& state = *context.GetState(item.id).state.input;
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = TextInputImpl(item.id, state, style, item.margin, item.content, renderer, io);
@@ -1070,8 +1078,8 @@ namespace glimmer
             break;
         }
         case glimmer::WT_DropDown: {
-            auto& state = context.GetState(item.id).state.dropdown;
-            const auto& style = GetStyle(StyleStack, state.state);
+            auto& state = *context.GetState(item.id).state.dropdown;
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = DropDownImpl(item.id, state, style, item.margin, item.border, item.padding, item.content, item.text, renderer, io);
@@ -1080,8 +1088,7 @@ namespace glimmer
             break;
         }
         case glimmer::WT_ItemGrid: {
-            auto& state = context.GetState(item.id).state.grid;
-            const auto& style = GetStyle(StyleStack, state.state);
+            const auto& style = GetStyle(StyleStack, context.states.flags(item.id));
             UpdateGeometry(item, bbox, style);
             context.AddItemGeometry(item.id, bbox);
             result = ItemGridImpl(item.id, style, item.margin, item.border, item.padding, item.content, item.text, renderer, io);
@@ -1119,6 +1126,8 @@ namespace glimmer
 
     WidgetDrawResult EndLayout(int depth)
     {
+        GLIMMER_PROFILE_SCOPE(PP_EndLayout);
+        AllocationTagScope tag{ AT_Layout };
         WidgetDrawResult result;
         ImRect geometry;
         auto& context = GetContext();
@@ -1147,7 +1156,7 @@ namespace glimmer
 
 #endif
                 // This stores the data for replay of style push/pop operations within a layout block
-                static StyleStackT StyleStack[WSI_Total];
+                static thread_local StyleStackT StyleStack[WSI_Total];
 
                 for (auto idx = 0; idx < WSI_Total; ++idx)
                 {
@@ -1,8 +1,12 @@
 #include "platform.h"
 #include "context.h"
 #include "renderer.h"
+#include "profiler.h"
 
 #include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifndef GLIMMER_MAX_CLIPBOARD_TEXTSZ
 #define GLIMMER_MAX_CLIPBOARD_TEXTSZ 4096
@@ -26,6 +30,9 @@
 #ifdef __EMSCRIPTEN__
 #include "../libs/emscripten/emscripten_mainloop_stub.h"
 #endif
+
+// Defined in the ImGui GLFW backend
+ImGuiKey ImGui_ImplGlfw_KeyToImGuiKey(int keycode, int scancode);
 #endif
 
 #ifdef _WIN32
@@ -40,28 +47,12 @@ static void DetermineKeyStatus(glimmer::IODescriptor& desc)
     desc.capslock = GetAsyncKeyState(VK_CAPITAL) < 0;
     desc.insert = false;
 }
-#elif __linux__
-#include <ctsdio>
-#include <unistd.h>
-
-static std::string exec(const char* cmd) 
-{
-    char buffer[128];
-    std::string result = "";
-    FILE* pipe = popen(cmd, "r");
-    if (!pipe) throw std::runtime_error("popen() failed!");
-
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr)
-        result += buffer;
-
-    pclose(pipe);
-    return result;
-}
-
+#else
+// Lock key state is not probed at startup, it is picked up from the first key/mouse event's
+// modifiers once the window exists (see RecordLockKeyMods)
 static void DetermineKeyStatus(glimmer::IODescriptor& desc)
 {
-    std::string xset_output = exec("xset -q | grep Caps | sed -n 's/^.*Caps Lock:\\s*\\(\\S*\\).*$/\\1/p'");
-    desc.capslock = xset_output.find("on") != std::string::npos;
+    desc.capslock = false;
     desc.insert = false;
 }
 #endif
@@ -102,6 +93,294 @@ namespace glimmer
         fprintf(stderr, "GLFW Error %d: %s\n", error, description);
     }
 
+#pragma region Input events
+
+    // Events are appended by the GLFW callbacks as they arrive during glfwPollEvents, and
+    // handed to the frame as a whole, so several events for the same key within a frame
+    // are all seen in order instead of being sampled once per frame
+    struct InputEventQueue
+    {
+        std::vector<InputEvent> pending, current;
+        int32_t modifiers = 0;
+        int32_t capsLock = -1; // as reported by GLFW_LOCK_KEY_MODS, -1 until an event has reported it
+
+        InputEvent& push(InputEventType type)
+        {
+            auto& event = pending.emplace_back();
+            event.timestamp = glfwGetTime();
+            event.type = type;
+            event.modifiers = modifiers;
+            return event;
+        }
+
+        // Previous frame's storage is reused for the next batch of events
+        std::span<const InputEvent> swap()
+        {
+            current.swap(pending);
+            pending.clear();
+            return std::span<const InputEvent>{ current.data(), current.size() };
+        }
+    };
+
+    static InputEventQueue& EventQueue(GLFWwindow* window)
+    {
+        return *(InputEventQueue*)glfwGetWindowUserPointer(window);
+    }
+
+    static void RecordLockKeyMods(InputEventQueue& queue, int key, int action, int mods)
+    {
+        // Modifiers of the caps lock key's own events may be sampled before or after the toggle
+        // depending on the windowing system, hence it is toggled here and other events resync
+        if (key == GLFW_KEY_CAPS_LOCK)
+        {
+            if (action == GLFW_PRESS) queue.capsLock = queue.capsLock == 1 ? 0 : 1;
+        }
+        else queue.capsLock = (mods & GLFW_MOD_CAPS_LOCK) != 0 ? 1 : 0;
+    }
+
+    static int32_t ToKeyModifiers(int mods)
+    {
+        return ((mods & GLFW_MOD_CONTROL) ? CtrlKeyMod : 0) | ((mods & GLFW_MOD_SHIFT) ? ShiftKeyMod : 0) |
+            ((mods & GLFW_MOD_ALT) ? AltKeyMod : 0) | ((mods & GLFW_MOD_SUPER) ? SuperKeyMod : 0);
+    }
+
+    // GLFW reports physical (US layout) keycodes, map printable keys through the active
+    // keyboard layout so shortcuts like Ctrl+Z follow the label on AZERTY/Dvorak keys
+    static int TranslateUntranslatedKey(int keycode, int scancode)
+    {
+#if (GLFW_VERSION_MAJOR * 1000 + GLFW_VERSION_MINOR * 100 >= 3300) && !defined(__EMSCRIPTEN__)
+        if (keycode >= GLFW_KEY_KP_0 && keycode <= GLFW_KEY_KP_EQUAL) return keycode;
+
+        auto prev = glfwSetErrorCallback(nullptr);
+        const char* name = glfwGetKeyName(keycode, scancode);
+        glfwSetErrorCallback(prev);
+        (void)glfwGetError(nullptr);
+
+        if (name != nullptr && name[0] != 0 && name[1] == 0)
+        {
+            static const char chars[] = "`-=[]\\,;'./";
+            static const int keys[] = { GLFW_KEY_GRAVE_ACCENT, GLFW_KEY_MINUS, GLFW_KEY_EQUAL, GLFW_KEY_LEFT_BRACKET,
+                GLFW_KEY_RIGHT_BRACKET, GLFW_KEY_BACKSLASH, GLFW_KEY_COMMA, GLFW_KEY_SEMICOLON, GLFW_KEY_APOSTROPHE,
+                GLFW_KEY_PERIOD, GLFW_KEY_SLASH, 0 };
+
+            if (name[0] >= '0' && name[0] <= '9') keycode = GLFW_KEY_0 + (name[0] - '0');
+            else if (name[0] >= 'A' && name[0] <= 'Z') keycode = GLFW_KEY_A + (name[0] - 'A');
+            else if (name[0] >= 'a' && name[0] <= 'z') keycode = GLFW_KEY_A + (name[0] - 'a');
+            else if (const char* p = strchr(chars, name[0])) keycode = keys[p - chars];
+        }
+#else
+        (void)scancode;
+#endif
+        return keycode;
+    }
+
+    // Installed before the ImGui backend, which chains to these
+    static void glfw_key_callback(GLFWwindow* window, int keycode, int scancode, int action, int mods)
+    {
+        auto& queue = EventQueue(window);
+        RecordLockKeyMods(queue, keycode, action, mods);
+        queue.modifiers = ToKeyModifiers(mods);
+
+        keycode = TranslateUntranslatedKey(keycode, scancode);
+        auto key = (int)ImGui_ImplGlfw_KeyToImGuiKey(keycode, scancode) - (int)ImGuiKey_NamedKey_BEGIN;
+        if (key < 0 || key >= Key_Total) return;
+
+        auto& event = queue.push(action == GLFW_RELEASE ? InputEventType::KeyReleased : InputEventType::KeyPressed);
+        event.key = (Key)key;
+    }
+
+    static void glfw_char_callback(GLFWwindow* window, unsigned int codepoint)
+    {
+        EventQueue(window).push(InputEventType::Character).codepoint = codepoint;
+    }
+
+    static void glfw_mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+    {
+        auto& queue = EventQueue(window);
+        RecordLockKeyMods(queue, GLFW_KEY_UNKNOWN, 0, mods);
+        queue.modifiers = ToKeyModifiers(mods);
+
+        double x = 0.0, y = 0.0;
+        glfwGetCursorPos(window, &x, &y);
+        auto& event = queue.push(action == GLFW_PRESS ? InputEventType::MousePressed : InputEventType::MouseReleased);
+        event.button = button;
+        event.pos = ImVec2{ (float)x, (float)y };
+    }
+
+    static void glfw_cursor_pos_callback(GLFWwindow* window, double x, double y)
+    {
+        auto& queue = EventQueue(window);
+
+        if (!queue.pending.empty() && queue.pending.back().type == InputEventType::MouseMoved)
+        {
+            queue.pending.back().timestamp = glfwGetTime();
+            queue.pending.back().pos = ImVec2{ (float)x, (float)y };
+        }
+        else queue.push(InputEventType::MouseMoved).pos = ImVec2{ (float)x, (float)y };
+    }
+
+    static void glfw_scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+    {
+        EventQueue(window).push(InputEventType::MouseWheel).pos = ImVec2{ (float)xoffset, (float)yoffset };
+    }
+
+#pragma endregion
+
+#pragma region Frame pipelining
+
+    template <typename T>
+    static void CopyBuffer(ImVector<T>& dest, const ImVector<T>& src)
+    {
+        // ImVector::operator= frees the destination first, resize keeps its capacity across frames
+        dest.resize(src.Size);
+        if (src.Size > 0) memcpy(dest.Data, src.Data, (size_t)src.size_in_bytes());
+    }
+
+    // Copy of a frame's draw data which the presenting thread owns until it has been submitted,
+    // the draw lists are reused between frames so steady state frames do not allocate
+    struct FrameSnapshot
+    {
+        ImDrawData data;
+        ImVector<ImDrawList*> lists;
+        int width = 0, height = 0;
+
+        void Capture(const ImDrawData& source, int fbwidth, int fbheight)
+        {
+            for (auto idx = lists.Size; idx < source.CmdListsCount; ++idx)
+                lists.push_back(IM_NEW(ImDrawList)(source.CmdLists[idx]->_Data));
+
+            data.Clear();
+            for (auto idx = 0; idx < source.CmdListsCount; ++idx)
+            {
+                auto dest = lists[idx];
+                const auto src = source.CmdLists[idx];
+                CopyBuffer(dest->CmdBuffer, src->CmdBuffer);
+                CopyBuffer(dest->IdxBuffer, src->IdxBuffer);
+                CopyBuffer(dest->VtxBuffer, src->VtxBuffer);
+                dest->Flags = src->Flags;
+                data.CmdLists.push_back(dest);
+            }
+
+            data.Valid = source.Valid;
+            data.CmdListsCount = source.CmdListsCount;
+            data.TotalIdxCount = source.TotalIdxCount;
+            data.TotalVtxCount = source.TotalVtxCount;
+            data.DisplayPos = source.DisplayPos;
+            data.DisplaySize = source.DisplaySize;
+            data.FramebufferScale = source.FramebufferScale;
+            width = fbwidth;
+            height = fbheight;
+        }
+
+        ~FrameSnapshot()
+        {
+            for (auto list : lists) IM_DELETE(list);
+        }
+    };
+
+    // Submits frames on a thread which owns the window's GL context, while the main thread builds
+    // the next frame. Two snapshots are used, the main thread fills one while the other is being
+    // submitted, and waits only if the previous frame has not been picked up yet, which bounds
+    // the added latency to one frame.
+    struct FramePresenter
+    {
+        void Start(GLFWwindow* window, const float (&color)[4])
+        {
+            target = window;
+            std::memcpy(bgcolor, color, sizeof(bgcolor));
+            stop = pending = false;
+            next = 0;
+
+            // The main thread keeps a hidden context sharing objects with the window's context,
+            // so that textures uploaded while building the UI are visible to the presenter
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            uploader = glfwCreateWindow(1, 1, "", nullptr, window);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+            glfwMakeContextCurrent(nullptr);
+            worker = std::thread{ &FramePresenter::Run, this };
+            glfwMakeContextCurrent(uploader);
+        }
+
+        void Submit(const ImDrawData& source, int width, int height)
+        {
+            // Uploads from this frame must be complete before another context samples them
+            glFinish();
+
+            {
+                std::unique_lock lock{ mutex };
+                cv.wait(lock, [this] { return !pending; });
+            }
+
+            snapshots[next].Capture(source, width, height);
+
+            {
+                std::scoped_lock lock{ mutex };
+                pending = true;
+            }
+
+            cv.notify_all();
+            next ^= 1;
+        }
+
+        void Stop()
+        {
+            if (!worker.joinable()) return;
+
+            {
+                std::scoped_lock lock{ mutex };
+                stop = true;
+            }
+
+            cv.notify_all();
+            worker.join();
+            glfwMakeContextCurrent(target);
+            glfwDestroyWindow(uploader);
+            uploader = nullptr;
+        }
+
+        void Run()
+        {
+            glfwMakeContextCurrent(target);
+            auto current = 0;
+
+            while (true)
+            {
+                {
+                    std::unique_lock lock{ mutex };
+                    cv.wait(lock, [this] { return pending || stop; });
+                    if (!pending) break;
+                    pending = false;
+                }
+
+                // Releasing the slot before submitting lets the main thread fill the other one
+                cv.notify_all();
+
+                auto& frame = snapshots[current];
+                glViewport(0, 0, frame.width, frame.height);
+                glClearColor(bgcolor[0], bgcolor[1], bgcolor[2], bgcolor[3]);
+                glClear(GL_COLOR_BUFFER_BIT);
+                ImGui_ImplOpenGL3_RenderDrawData(&frame.data);
+                glfwSwapBuffers(target);
+                current ^= 1;
+            }
+
+            glfwMakeContextCurrent(nullptr);
+        }
+
+        FrameSnapshot snapshots[2];
+        GLFWwindow* target = nullptr;
+        GLFWwindow* uploader = nullptr;
+        float bgcolor[4];
+        int next = 0;
+        bool pending = false, stop = false;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread worker;
+    };
+
+#pragma endregion
+
     struct ImGuiGLFWPlatform final : public IPlatform
     {
         ImGuiGLFWPlatform()
@@ -168,30 +447,41 @@ namespace glimmer
                 clicked = clicked || ImGui::IsMouseDown(idx);
             }
 
-            for (int key = Key_Tab; key != Key_Total; ++key)
+            // Key states only last a frame, so only keys which changed in the previous frame are reset
+            for (auto key : changedKeys) desc.keyStatus[key] = ButtonStatus::Default;
+            changedKeys.clear();
+            desc.events = events.swap();
+
+            for (const auto& event : desc.events)
             {
-                auto imkey = ImGuiKey_NamedKey_BEGIN + key;
-                if (ImGui::IsKeyPressed((ImGuiKey)imkey))
+                if (event.type == InputEventType::KeyPressed)
                 {
-                    if ((ImGuiKey)imkey == ImGuiKey_CapsLock) desc.capslock = !desc.capslock;
-                    else if ((ImGuiKey)imkey == ImGuiKey_Insert) desc.insert = !desc.insert;
+                    if (event.key == Key_CapsLock) desc.capslock = !desc.capslock;
+                    else if (event.key == Key_Insert) desc.insert = !desc.insert;
                     else
                     {
                         if (rollover < GLIMMER_NKEY_ROLLOVER_MAX)
-                            desc.key[rollover++] = (Key)key;
-                        desc.keyStatus[key] = ButtonStatus::Pressed;
-                        escape = imkey == ImGuiKey_Escape;
+                            desc.key[rollover++] = event.key;
+                        desc.keyStatus[event.key] = ButtonStatus::Pressed;
+                        changedKeys.push_back(event.key);
+                        escape = escape || event.key == Key_Escape;
                     }
                 }
-                else if (ImGui::IsKeyReleased((ImGuiKey)imkey))
-                    desc.keyStatus[key] = ButtonStatus::Released;
-                else
-                    desc.keyStatus[key] = ButtonStatus::Default;
+                else if (event.type == InputEventType::KeyReleased)
+                {
+                    // A key pressed and released within the same frame still reads as pressed
+                    if (desc.keyStatus[event.key] != ButtonStatus::Pressed)
+                        desc.keyStatus[event.key] = ButtonStatus::Released;
+                    changedKeys.push_back(event.key);
+                }
             }
 
             while (rollover <= GLIMMER_NKEY_ROLLOVER_MAX)
                 desc.key[rollover++] = Key_Invalid;
 
+            // Prefer the state reported by GLFW over toggling on key presses, once it is known
+            if (events.capsLock != -1) desc.capslock = events.capsLock == 1;
+
             if (clicked || escape)
             {
                 ResetActivePopUps(desc.mousepos, escape);
@@ -281,6 +571,14 @@ namespace glimmer
             glfwMakeContextCurrent(m_window);
             glfwSwapInterval(1); // Enable vsync
 
+            glfwSetInputMode(m_window, GLFW_LOCK_KEY_MODS, GLFW_TRUE);
+            glfwSetWindowUserPointer(m_window, &events);
+            glfwSetKeyCallback(m_window, glfw_key_callback);
+            glfwSetCharCallback(m_window, glfw_char_callback);
+            glfwSetMouseButtonCallback(m_window, glfw_mouse_button_callback);
+            glfwSetCursorPosCallback(m_window, glfw_cursor_pos_callback);
+            glfwSetScrollCallback(m_window, glfw_scroll_callback);
+
             // Setup Dear ImGui context
             IMGUI_CHECKVERSION();
             ImGui::CreateContext();
@@ -300,6 +598,9 @@ namespace glimmer
             bgcolor[2] = (float)params.bgcolor[2] / 255.f;
             bgcolor[3] = (float)params.bgcolor[3] / 255.f;
             softwareCursor = params.softwareCursor;
+#ifndef __EMSCRIPTEN__
+            pipelined = params.pipelined;
+#endif
 
 #ifdef _DEBUG
             _CrtSetDbgFlag(_CRTDBG_DELAY_FREE_MEM_DF);
@@ -322,6 +623,8 @@ namespace glimmer
 
             EMSCRIPTEN_MAINLOOP_BEGIN
 #else
+            if (pipelined) presenter.Start(m_window, bgcolor);
+
             while (!glfwWindowShouldClose(m_window) && !close)
 #endif
             {
@@ -332,6 +635,7 @@ namespace glimmer
                     continue;
                 }
 
+                BeginProfileFrame();
                 int width, height;
                 glfwGetWindowSize(m_window, &width, &height);
 
@@ -351,6 +655,7 @@ namespace glimmer
                 {
                     auto dl = ImGui::GetWindowDrawList();
                     Config.renderer->UserData = dl;
+                    Config.renderer->stats = RendererStats{};
                     dl->AddRectFilled(ImVec2{ 0, 0 }, winsz, ImColor{ bgcolor[0], bgcolor[1], bgcolor[2], bgcolor[3] });
                     close = !runner(winsz, *this, data);
                 }
@@ -359,15 +664,25 @@ namespace glimmer
                 ExitFrame();
 
                 // Rendering
-                ImGui::Render();
-                int display_w, display_h;
-                glfwGetFramebufferSize(m_window, &display_w, &display_h);
-                glViewport(0, 0, display_w, display_h);
-                glClearColor(bgcolor[0], bgcolor[1], bgcolor[2], bgcolor[3]);
-                glClear(GL_COLOR_BUFFER_BIT);
-                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                {
+                    GLIMMER_PROFILE_SCOPE(PP_Present);
+                    ImGui::Render();
+                    int display_w, display_h;
+                    glfwGetFramebufferSize(m_window, &display_w, &display_h);
+
+                    if (pipelined)
+                        presenter.Submit(*ImGui::GetDrawData(), display_w, display_h);
+                    else
+                    {
+                        glViewport(0, 0, display_w, display_h);
+                        glClearColor(bgcolor[0], bgcolor[1], bgcolor[2], bgcolor[3]);
+                        glClear(GL_COLOR_BUFFER_BIT);
+                        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                        glfwSwapBuffers(m_window);
+                    }
+                }
 
-                glfwSwapBuffers(m_window);
+                EndProfileFrame();
 
 #ifdef __EMSCRIPTEN__
             EMSCRIPTEN_MAINLOOP_END;
@@ -375,6 +690,7 @@ namespace glimmer
             }
 #endif
 
+            presenter.Stop();
             Cleanup();
             return true;
         }
@@ -383,6 +699,10 @@ namespace glimmer
         float bgcolor[4];
         MouseCursor cursor;
         bool softwareCursor = false;
+        bool pipelined = false;
+        FramePresenter presenter;
+        InputEventQueue events;
+        std::vector<Key> changedKeys;
     };
 
     IPlatform* GetPlatform(ImVec2 size)
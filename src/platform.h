@@ -34,6 +34,7 @@ inline bool operator>(ImVec2 lhs, ImVec2 rhs)
 
 #include <string_view>
 #include <vector>
+#include <span>
 
 namespace glimmer
 {
@@ -134,6 +135,29 @@ namespace glimmer
         Default, Pressed, Released, DoubleClicked
     };
 
+    enum class InputEventType : int8_t
+    {
+        KeyPressed,    // Also sent for key repeats
+        KeyReleased,
+        Character,     // Text input, after keyboard layout, shift and caps lock are applied
+        MousePressed,
+        MouseReleased,
+        MouseMoved,    // Consecutive moves are coalesced into one event
+        MouseWheel     // pos holds the horizontal and vertical scroll offsets
+    };
+
+    // Input as received from the windowing system, in arrival order
+    struct InputEvent
+    {
+        double timestamp = 0.0; // in seconds
+        InputEventType type = InputEventType::KeyPressed;
+        Key key = Key_Invalid;
+        int32_t modifiers = 0; // KeyModifiers held at the time of the event
+        uint32_t codepoint = 0;
+        int32_t button = -1;
+        ImVec2 pos;
+    };
+
     struct IODescriptor
     {
         ImVec2 mousepos;
@@ -148,6 +172,10 @@ namespace glimmer
         bool capslock = false;
         bool insert = false;
 
+        // Events received since the previous frame, the storage is owned by the platform
+        // and stays valid until the next frame starts
+        std::span<const InputEvent> events;
+
         IODescriptor();
 
         bool isLeftMouseDown() const
@@ -191,6 +219,10 @@ namespace glimmer
         std::string_view title;
         uint8_t bgcolor[4] = { 255, 255, 255, 255 };
         bool softwareCursor = false;
+
+        // Submit frames to the GPU from a separate thread which owns the GL context, so that
+        // building frame N+1 overlaps with submitting frame N, at the cost of a frame of latency
+        bool pipelined = false;
     };
 
     struct UIConfig;
@@ -0,0 +1,210 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace glimmer
+{
+    static FrameProfile Frames[GLIMMER_PROFILER_FRAMES];
+    static ProfileEvent Events[GLIMMER_PROFILER_MAX_EVENTS];
+    static int64_t TotalEvents = 0;
+    static int64_t TotalFrames = 0;
+    static int32_t CurrentFrameIdx = 0;
+    static thread_local bool ProfilingEnabled = false; // Only the thread which enabled profiling records
+    static std::atomic<std::thread::id> ProfilingThread{}; // Owner of the frame and event buffers
+    static const auto ProfileEpoch = std::chrono::steady_clock::now();
+
+    static const char* PhaseNames[PP_Total] = {
+        "Frame", "StyleResolution", "BeginLayout", "EndLayout", "WidgetBounds",
+        "Widget", "DeferredReplay", "EventHandling", "Present"
+    };
+
+    static const char* WidgetTypeNames[WT_TotalTypes] = {
+        "Label", "Button", "RadioButton", "ToggleButton", "Checkbox",
+        "Layout", "Scrollable", "Splitter", "SplitterRegion", "Accordion",
+        "Slider", "Spinner", "TextInput", "DropDown", "TabBar", "ItemGrid", "Charts"
+    };
+
+    static int64_t ProfileClock()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now() - ProfileEpoch).count();
+    }
+
+    FrameProfile::FrameProfile()
+    {
+        reset(-1, 0);
+    }
+
+    void FrameProfile::reset(int64_t frameIdx, int64_t startTime)
+    {
+        frame = frameIdx;
+        start = startTime;
+        duration = 0;
+        allocations = 0;
+        allocatedBytes = 0;
+
+        for (auto idx = 0; idx < PP_Total; ++idx)
+        {
+            phaseTime[idx] = 0;
+            phaseCalls[idx] = 0;
+        }
+
+        for (auto idx = 0; idx < WT_TotalTypes; ++idx)
+        {
+            widgetTime[idx] = 0;
+            widgetCalls[idx] = 0;
+        }
+    }
+
+    ProfileScope::ProfileScope(ProfilePhase phase_, WidgetType wtype_, bool active)
+        : phase{ phase_ }, wtype{ wtype_ }
+    {
+        if (active && ProfilingEnabled) start = ProfileClock();
+    }
+
+    ProfileScope::~ProfileScope()
+    {
+        if (start == -1 || !ProfilingEnabled) return;
+
+        auto duration = ProfileClock() - start;
+        auto& frame = Frames[CurrentFrameIdx];
+        frame.phaseTime[phase] += duration;
+        frame.phaseCalls[phase]++;
+
+        if (wtype >= 0 && wtype < WT_TotalTypes)
+        {
+            frame.widgetTime[wtype] += duration;
+            frame.widgetCalls[wtype]++;
+        }
+
+        auto& ev = Events[TotalEvents % GLIMMER_PROFILER_MAX_EVENTS];
+        ev.start = start;
+        ev.duration = duration;
+        ev.frame = (int32_t)TotalFrames;
+        ev.phase = phase;
+        ev.wtype = wtype;
+        ++TotalEvents;
+    }
+
+    // The frame and event buffers are shared, only one thread may profile at a time
+    void EnableProfiling(bool enable)
+    {
+        auto self = std::this_thread::get_id();
+        auto owner = std::thread::id{};
+
+        if (enable)
+        {
+            auto acquired = ProfilingThread.compare_exchange_strong(owner, self) || owner == self;
+            assert(acquired && "Profiling is already enabled on another thread");
+            if (!acquired) return;
+        }
+        else if (ProfilingEnabled) ProfilingThread.store(owner);
+
+        ProfilingEnabled = enable;
+    }
+
+    bool IsProfilingEnabled()
+    {
+        return ProfilingEnabled;
+    }
+
+    void BeginProfileFrame()
+    {
+        if (!ProfilingEnabled) return;
+        Frames[CurrentFrameIdx].reset(TotalFrames, ProfileClock());
+    }
+
+    void EndProfileFrame()
+    {
+        if (!ProfilingEnabled) return;
+
+        auto& frame = Frames[CurrentFrameIdx];
+        frame.duration = ProfileClock() - frame.start;
+        frame.phaseTime[PP_Frame] = frame.duration;
+        frame.phaseCalls[PP_Frame] = 1;
+
+        auto& ev = Events[TotalEvents % GLIMMER_PROFILER_MAX_EVENTS];
+        ev.start = frame.start;
+        ev.duration = frame.duration;
+        ev.frame = (int32_t)TotalFrames;
+        ev.phase = PP_Frame;
+        ev.wtype = WT_Invalid;
+        ++TotalEvents;
+
+        ++TotalFrames;
+        CurrentFrameIdx = (CurrentFrameIdx + 1) % GLIMMER_PROFILER_FRAMES;
+    }
+
+    void RecordProfileAllocation(int64_t bytes)
+    {
+        if (!ProfilingEnabled) return;
+
+        auto& frame = Frames[CurrentFrameIdx];
+        frame.allocations++;
+        frame.allocatedBytes += bytes;
+    }
+
+    const FrameProfile& GetFrameProfile(int32_t depth)
+    {
+        static const FrameProfile Empty{};
+        if (depth < 0 || depth >= GLIMMER_PROFILER_FRAMES || depth >= TotalFrames) return Empty;
+
+        auto idx = (CurrentFrameIdx - 1 - depth + (2 * GLIMMER_PROFILER_FRAMES)) % GLIMMER_PROFILER_FRAMES;
+        return Frames[idx];
+    }
+
+    int32_t TotalProfiledFrames()
+    {
+        return (int32_t)std::min<int64_t>(TotalFrames, GLIMMER_PROFILER_FRAMES);
+    }
+
+    std::string_view GetProfilePhaseName(ProfilePhase phase)
+    {
+        return phase >= 0 && phase < PP_Total ? PhaseNames[phase] : "";
+    }
+
+    bool ExportChromeTrace(std::string_view filepath)
+    {
+        std::string path{ filepath };
+        auto fptr = std::fopen(path.c_str(), "w");
+        if (fptr == nullptr) return false;
+
+        auto count = std::min<int64_t>(TotalEvents, GLIMMER_PROFILER_MAX_EVENTS);
+        auto first = TotalEvents - count;
+        auto separator = "";
+
+        std::fprintf(fptr, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        for (auto idx = first; idx < TotalEvents; ++idx)
+        {
+            const auto& ev = Events[idx % GLIMMER_PROFILER_MAX_EVENTS];
+            auto isWidget = ev.wtype >= 0 && ev.wtype < WT_TotalTypes;
+
+            std::fprintf(fptr, "%s{\"name\":\"%s%s%s\",\"cat\":\"glimmer\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}", separator, PhaseNames[ev.phase],
+                isWidget ? ":" : "", isWidget ? WidgetTypeNames[ev.wtype] : "",
+                (double)ev.start / 1000.0, (double)ev.duration / 1000.0, ev.frame);
+            separator = ",\n";
+        }
+
+        // Per-frame allocation counters are exported as counter events
+        for (auto depth = TotalProfiledFrames() - 1; depth >= 0; --depth)
+        {
+            const auto& frame = GetFrameProfile(depth);
+            std::fprintf(fptr, "%s{\"name\":\"Allocations\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.3f,"
+                "\"args\":{\"calls\":%d,\"bytes\":%lld}}", separator, (double)frame.start / 1000.0,
+                frame.allocations, (long long)frame.allocatedBytes);
+            separator = ",\n";
+        }
+
+        std::fprintf(fptr, "\n]}\n");
+        std::fclose(fptr);
+        return true;
+    }
+}
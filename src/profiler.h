@@ -0,0 +1,95 @@
+#pragma once
+
+#include "types.h"
+
+#ifndef GLIMMER_PROFILER_FRAMES
+#define GLIMMER_PROFILER_FRAMES 256
+#endif
+
+#ifndef GLIMMER_PROFILER_MAX_EVENTS
+#define GLIMMER_PROFILER_MAX_EVENTS 16384
+#endif
+
+namespace glimmer
+{
+    enum ProfilePhase : int16_t
+    {
+        PP_Frame,
+        PP_StyleResolution,
+        PP_BeginLayout,
+        PP_EndLayout,
+        PP_WidgetBounds,
+        PP_Widget, // Complete widget invocation, attributed to widget type
+        PP_DeferredReplay,
+        PP_EventHandling,
+        PP_Present,
+        PP_Total
+    };
+
+    // Aggregated timings of a single frame, all durations are in nanoseconds
+    struct FrameProfile
+    {
+        int64_t frame = -1;
+        int64_t start = 0;
+        int64_t duration = 0;
+        int64_t phaseTime[PP_Total];
+        int32_t phaseCalls[PP_Total];
+        int64_t widgetTime[WT_TotalTypes];
+        int32_t widgetCalls[WT_TotalTypes];
+        int32_t allocations = 0;
+        int64_t allocatedBytes = 0;
+
+        FrameProfile();
+        void reset(int64_t frameIdx, int64_t startTime);
+    };
+
+    // A single recorded scope, used for trace export
+    struct ProfileEvent
+    {
+        int64_t start = 0;
+        int64_t duration = 0;
+        int32_t frame = 0;
+        ProfilePhase phase = PP_Total;
+        WidgetType wtype = WT_Invalid;
+    };
+
+    struct ProfileScope
+    {
+        int64_t start = -1;
+        ProfilePhase phase;
+        WidgetType wtype;
+
+        ProfileScope(ProfilePhase phase, WidgetType wtype = WT_Invalid, bool active = true);
+        ~ProfileScope();
+    };
+
+    // Profiling records on the calling thread only, one thread may have it enabled at a time
+    void EnableProfiling(bool enable);
+    bool IsProfilingEnabled();
+
+    // Invoked by platform at start and end of frame
+    void BeginProfileFrame();
+    void EndProfileFrame();
+
+    // Allocation counters are fed by the library's allocators (the default passthrough allocator,
+    // the debug allocator in debug builds), custom allocators which do not forward to one of
+    // them have to call this to show up in frame profiles
+    void RecordProfileAllocation(int64_t bytes);
+
+    // depth = 0 is the last completed frame, depth = 1 is the one before and so on...
+    const FrameProfile& GetFrameProfile(int32_t depth = 0);
+    int32_t TotalProfiledFrames();
+    std::string_view GetProfilePhaseName(ProfilePhase phase);
+
+    // Export recorded events as Chrome trace JSON (chrome://tracing or Perfetto)
+    bool ExportChromeTrace(std::string_view filepath);
+}
+
+#define GLIMMER_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GLIMMER_PROFILE_CONCAT(a, b) GLIMMER_PROFILE_CONCAT_IMPL(a, b)
+
+#ifndef GLIMMER_DISABLE_PROFILER
+#define GLIMMER_PROFILE_SCOPE(...) glimmer::ProfileScope GLIMMER_PROFILE_CONCAT(__profscope, __LINE__){ __VA_ARGS__ }
+#else
+#define GLIMMER_PROFILE_SCOPE(...)
+#endif
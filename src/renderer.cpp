@@ -1,8 +1,17 @@
 #include "renderer.h"
 #include "context.h"
+#include "profiler.h"
 
 #include <cstdio>
+#include <cstring>
 #include <charconv>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -57,6 +66,108 @@ namespace glimmer
 
 #pragma region ImGui Renderer
 
+    // Unit circle sampled at fixed angular steps, and the segment count per full circle for small
+    // integral radii, shared by every arc tessellated by the renderer
+    struct UnitCircleTable
+    {
+        static constexpr int CachedRadii = 256;
+
+        ImVec2 points[GLIMMER_ARC_TABLE_SZ];
+        int16_t segments[CachedRadii];
+
+        UnitCircleTable()
+        {
+            for (auto idx = 0; idx < GLIMMER_ARC_TABLE_SZ; ++idx)
+            {
+                auto angle = (2.f * (float)M_PI * (float)idx) / (float)GLIMMER_ARC_TABLE_SZ;
+                points[idx] = ImVec2{ cosf(angle), sinf(angle) };
+            }
+
+            for (auto radius = 0; radius < CachedRadii; ++radius)
+                segments[radius] = (int16_t)Compute((float)radius);
+        }
+
+        // Chord of angle a deviates from the arc by r * (1 - cos(a/2)), solve for a given max error
+        static int Compute(float radius)
+        {
+            if (radius <= GLIMMER_ARC_MAX_ERROR) return 4;
+            auto count = (int)ceilf((float)M_PI / acosf(1.f - (GLIMMER_ARC_MAX_ERROR / radius)));
+            return std::clamp(count, 4, GLIMMER_ARC_TABLE_SZ);
+        }
+
+        int SegmentCount(float radius) const
+        {
+            auto intr = (int)radius;
+            return ((float)intr == radius && intr < CachedRadii) ? (int)segments[intr] : Compute(radius);
+        }
+    };
+
+    static const UnitCircleTable& UnitCircle()
+    {
+        static const UnitCircleTable table;
+        return table;
+    }
+
+    // Appends points of the arc from startdeg to enddeg (screen space, clockwise) to the current path.
+    // Angles snap to the table resolution and the segment count scales with radius and arc span.
+    static void PathArc(ImDrawList& dl, ImVec2 center, float radius, float startdeg, float enddeg, RendererStats& stats)
+    {
+        constexpr float StepsPerDegree = (float)GLIMMER_ARC_TABLE_SZ / 360.f;
+
+        if (radius < 0.5f)
+        {
+            dl.PathLineTo(center);
+            return;
+        }
+
+        const auto& table = UnitCircle();
+        auto from = (int)roundf(startdeg * StepsPerDegree), span = (int)roundf(enddeg * StepsPerDegree) - from;
+        auto steps = std::abs(span);
+        auto segments = (table.SegmentCount(radius) * steps + GLIMMER_ARC_TABLE_SZ - 1) / GLIMMER_ARC_TABLE_SZ;
+        segments = std::clamp(segments, 1, std::max(steps, 1));
+
+        dl._Path.reserve(dl._Path.Size + segments + 1);
+        for (auto seg = 0; seg <= segments; ++seg)
+        {
+            auto idx = (from + ((span * seg) / segments)) % GLIMMER_ARC_TABLE_SZ;
+            if (idx < 0) idx += GLIMMER_ARC_TABLE_SZ;
+            auto unit = table.points[idx];
+            dl.PathLineTo(ImVec2{ center.x + unit.x * radius, center.y + unit.y * radius });
+        }
+
+        stats.arcs++;
+        stats.arcSegments += segments;
+    }
+
+    // Accumulates geometry written to a draw list into the renderer stats, nested
+    // draw calls (i.e. a primitive implemented through another one) are counted once
+    struct GeometryCounter
+    {
+        ImDrawList* dl = nullptr;
+        RendererStats& stats;
+        int32_t& depth;
+        int vtxStart = 0, idxStart = 0;
+
+        GeometryCounter(void* userdata, RendererStats& stats, int32_t& depth)
+            : dl{ (ImDrawList*)userdata }, stats{ stats }, depth{ depth }
+        {
+            if (depth++ == 0 && dl != nullptr)
+            {
+                vtxStart = dl->VtxBuffer.Size;
+                idxStart = dl->IdxBuffer.Size;
+            }
+        }
+
+        ~GeometryCounter()
+        {
+            if (--depth == 0 && dl != nullptr)
+            {
+                stats.vertices += dl->VtxBuffer.Size - vtxStart;
+                stats.indices += dl->IdxBuffer.Size - idxStart;
+            }
+        }
+    };
+
     ImTextureID UploadImage(ImVec2 pos, ImVec2 size, unsigned char* pixels, ImDrawList& dl)
     {
         GLint last_texture;
@@ -114,6 +225,12 @@ namespace glimmer
         void DrawSVG(ImVec2 pos, ImVec2 size, uint32_t color, std::string_view content, bool fromFile) override;
         void DrawImage(ImVec2 pos, ImVec2 size, std::string_view file) override;
 
+        // Draws into the given list without touching ImGui's global state (current window, clip rect
+        // and font stacks), so that it can be used off the main thread. Only geometry and text are
+        // supported when detached.
+        void Detach(ImDrawList* dl, ImFont* font, float fontsz);
+        float CurrentFontSize() const { return _currentFontSz; }
+
     private:
 
         void ConstructRoundedRect(ImVec2 startpos, ImVec2 endpos, float topleftr, float toprightr, float bottomrightr, float bottomleftr);
@@ -127,37 +244,54 @@ namespace glimmer
         };
 
         float _currentFontSz = 0.f;
+        int32_t _countDepth = 0;
         std::vector<std::pair<ImageLookupKey, ImTextureID>> bitmaps;
         ImDrawList* prevlist = nullptr;
+        ImDrawList* _detached = nullptr;
+        std::vector<std::pair<ImFont*, float>> _fonts;
     };
 
     ImGuiRenderer::ImGuiRenderer()
     {}
 
+    void ImGuiRenderer::Detach(ImDrawList* dl, ImFont* font, float fontsz)
+    {
+        UserData = _detached = dl;
+        _fonts.clear();
+        _fonts.emplace_back(font, fontsz);
+        _currentFontSz = fontsz;
+        stats = RendererStats{};
+    }
+
     void ImGuiRenderer::SetClipRect(ImVec2 startpos, ImVec2 endpos, bool intersect)
     {
         Round(startpos); Round(endpos);
-        ImGui::PushClipRect(startpos, endpos, intersect);
+        if (_detached != nullptr) _detached->PushClipRect(startpos, endpos, intersect);
+        else ImGui::PushClipRect(startpos, endpos, intersect);
     }
 
     void ImGuiRenderer::ResetClipRect()
     {
-        ImGui::PopClipRect();
+        if (_detached != nullptr) _detached->PopClipRect();
+        else ImGui::PopClipRect();
     }
 
     void ImGuiRenderer::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(startpos); Round(endpos); thickness = roundf(thickness);
         ((ImDrawList*)UserData)->AddLine(startpos, endpos, color, thickness);
     }
 
     void ImGuiRenderer::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         ((ImDrawList*)UserData)->AddPolyline(points, sz, color, 0, thickness);
     }
 
     void ImGuiRenderer::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, float thickness)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(pos1); Round(pos2); Round(pos3); thickness = roundf(thickness);
         filled ? ((ImDrawList*)UserData)->AddTriangleFilled(pos1, pos2, pos3, color) :
             ((ImDrawList*)UserData)->AddTriangle(pos1, pos2, pos3, color, thickness);
@@ -165,6 +299,7 @@ namespace glimmer
 
     void ImGuiRenderer::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         if (thickness > 0.f || filled)
         {
             Round(startpos); Round(endpos); thickness = roundf(thickness);
@@ -176,6 +311,7 @@ namespace glimmer
     void ImGuiRenderer::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled,
         float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         auto isUniformRadius = (topleftr == toprightr && toprightr == bottomrightr && bottomrightr == bottomleftr) ||
             ((topleftr + toprightr + bottomrightr + bottomleftr) == 0.f);
 
@@ -208,6 +344,7 @@ namespace glimmer
 
     void ImGuiRenderer::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t colorfrom, uint32_t colorto, Direction dir)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(startpos); Round(endpos);
         dir == DIR_Horizontal ? ((ImDrawList*)UserData)->AddRectFilledMultiColor(startpos, endpos, colorfrom, colorto, colorto, colorfrom) :
             ((ImDrawList*)UserData)->AddRectFilledMultiColor(startpos, endpos, colorfrom, colorfrom, colorto, colorto);
@@ -216,6 +353,7 @@ namespace glimmer
     void ImGuiRenderer::DrawRoundedRectGradient(ImVec2 startpos, ImVec2 endpos, float topleftr, float toprightr, float bottomrightr, float bottomleftr, 
         uint32_t colorfrom, uint32_t colorto, Direction dir)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         auto& dl = *((ImDrawList*)UserData);
         ConstructRoundedRect(startpos, endpos, topleftr, toprightr, bottomrightr, bottomleftr);
         // TODO: Create color array per vertex
@@ -224,6 +362,7 @@ namespace glimmer
 
     void ImGuiRenderer::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, float thickness)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(center); radius = roundf(radius); thickness = roundf(thickness);
         filled ? ((ImDrawList*)UserData)->AddCircleFilled(center, radius, color) :
             ((ImDrawList*)UserData)->AddCircle(center, radius, color, 0, thickness);
@@ -231,14 +370,14 @@ namespace glimmer
 
     void ImGuiRenderer::DrawSector(ImVec2 center, float radius, int start, int end, uint32_t color, bool filled, bool inverted, float thickness)
     {
-        constexpr float DegToRad = M_PI / 180.f;
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(center); radius = roundf(radius); thickness = roundf(thickness);
 
         if (inverted)
         {
             auto& dl = *((ImDrawList*)UserData);
             dl.PathClear();
-            dl.PathArcTo(center, radius, DegToRad * (float)start, DegToRad * (float)end, 32);
+            PathArc(dl, center, radius, (float)start, (float)end, stats);
             auto start = dl._Path.front(), end = dl._Path.back();
 
             ImVec2 exterior[4] = { { std::min(start.x, end.x), std::min(start.y, end.y) },
@@ -267,7 +406,7 @@ namespace glimmer
         {
             auto& dl = *((ImDrawList*)UserData);
             dl.PathClear();
-            dl.PathArcTo(center, radius, DegToRad * (float)start, DegToRad * (float)end, 32);
+            PathArc(dl, center, radius, (float)start, (float)end, stats);
             dl.PathLineTo(center);
             filled ? dl.PathFillConcave(color) : dl.PathStroke(color, ImDrawFlags_Closed, thickness);
         }
@@ -275,12 +414,14 @@ namespace glimmer
 
     void ImGuiRenderer::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         filled ? ((ImDrawList*)UserData)->AddConvexPolyFilled(points, sz, color) :
             ((ImDrawList*)UserData)->AddPolyline(points, sz, color, ImDrawFlags_Closed, thickness);
     }
 
     void ImGuiRenderer::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         auto drawList = ((ImDrawList*)UserData);
         const ImVec2 uv = drawList->_Data->TexUvWhitePixel;
 
@@ -378,16 +519,14 @@ namespace glimmer
 
     void ImGuiRenderer::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(center); radius = roundf(radius);
 
         auto drawList = ((ImDrawList*)UserData);
         if (((in | out) & IM_COL32_A_MASK) == 0 || radius < 0.5f)
             return;
-        auto startrad = ((float)M_PI / 180.f) * (float)start;
-        auto endrad = ((float)M_PI / 180.f) * (float)end;
 
-        // Use arc with 32 segment count
-        drawList->PathArcTo(center, radius, startrad, endrad, 32);
+        PathArc(*drawList, center, radius, (float)start, (float)end, stats);
         const int count = drawList->_Path.Size - 1;
 
         unsigned int vtx_base = drawList->_VtxCurrentIdx;
@@ -412,16 +551,7 @@ namespace glimmer
 
     bool ImGuiRenderer::SetCurrentFont(std::string_view family, float sz, FontType type)
     {
-        auto font = GetFont(family, sz, type);
-
-        if (font != nullptr)
-        {
-            _currentFontSz = sz;
-            ImGui::PushFont((ImFont*)font);
-            return true;
-        }
-
-        return false;
+        return SetCurrentFont(GetFont(family, sz, type), sz);
     }
 
     bool ImGuiRenderer::SetCurrentFont(void* fontptr, float sz)
@@ -429,7 +559,8 @@ namespace glimmer
         if (fontptr != nullptr)
         {
             _currentFontSz = sz;
-            ImGui::PushFont((ImFont*)fontptr);
+            if (_detached != nullptr) _fonts.emplace_back((ImFont*)fontptr, sz);
+            else ImGui::PushFont((ImFont*)fontptr);
             return true;
         }
 
@@ -438,7 +569,12 @@ namespace glimmer
 
     void ImGuiRenderer::ResetFont()
     {
-        ImGui::PopFont();
+        if (_detached != nullptr)
+        {
+            if (_fonts.size() > 1) _fonts.pop_back();
+            _currentFontSz = _fonts.back().second;
+        }
+        else ImGui::PopFont();
     }
 
     ImVec2 ImGuiRenderer::GetTextSize(std::string_view text, void* fontptr, float sz, float wrapWidth)
@@ -448,8 +584,9 @@ namespace glimmer
 
     void ImGuiRenderer::DrawText(std::string_view text, ImVec2 pos, uint32_t color, float wrapWidth)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(pos);
-        auto font = ImGui::GetFont();
+        auto font = _detached != nullptr ? _fonts.back().first : ImGui::GetFont();
         ((ImDrawList*)UserData)->AddText(font, _currentFontSz, pos, color, text.data(), text.data() + text.size(),
             wrapWidth);
     }
@@ -503,10 +640,11 @@ namespace glimmer
 
     void ImGuiRenderer::DrawSVG(ImVec2 pos, ImVec2 size, uint32_t color, std::string_view content, bool fromFile)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(pos); Round(size);
 
         constexpr int bufsz = 1 << 13;
-        static char buffer[bufsz] = { 0 };
+        static thread_local char buffer[bufsz] = { 0 };
 
         auto& dl = *((ImDrawList*)UserData);
         bool found = false;
@@ -560,6 +698,7 @@ namespace glimmer
 
     void ImGuiRenderer::DrawImage(ImVec2 pos, ImVec2 size, std::string_view file)
     {
+        GeometryCounter counter{ UserData, stats, _countDepth };
         Round(pos); Round(size);
 
         auto& dl = *((ImDrawList*)UserData);
@@ -625,13 +764,13 @@ namespace glimmer
         dl.PathClear();
         dl.PathLineTo(ImVec2{ startpos.x, endpos.y - bottomleftr });
         dl.PathLineTo(ImVec2{ startpos.x, startpos.y + topleftr });
-        if (topleftr > 0.f) dl.PathArcToFast(ImVec2{ startpos.x + topleftr, startpos.y + topleftr }, topleftr, 6, 9);
+        if (topleftr > 0.f) PathArc(dl, ImVec2{ startpos.x + topleftr, startpos.y + topleftr }, topleftr, 180.f, 270.f, stats);
         dl.PathLineTo(ImVec2{ endpos.x - toprightr, startpos.y });
-        if (toprightr > 0.f) dl.PathArcToFast(ImVec2{ endpos.x - toprightr, startpos.y + toprightr }, toprightr, 9, 12);
+        if (toprightr > 0.f) PathArc(dl, ImVec2{ endpos.x - toprightr, startpos.y + toprightr }, toprightr, 270.f, 360.f, stats);
         dl.PathLineTo(ImVec2{ endpos.x, endpos.y - bottomrightr });
-        if (bottomrightr > 0.f) dl.PathArcToFast(ImVec2{ endpos.x - bottomrightr, endpos.y - bottomrightr }, bottomrightr, 0, 3);
+        if (bottomrightr > 0.f) PathArc(dl, ImVec2{ endpos.x - bottomrightr, endpos.y - bottomrightr }, bottomrightr, 0.f, 90.f, stats);
         dl.PathLineTo(ImVec2{ startpos.x - bottomleftr, endpos.y });
-        if (bottomleftr > 0.f) dl.PathArcToFast(ImVec2{ startpos.x + bottomleftr, endpos.y - bottomleftr }, bottomleftr, 3, 6);
+        if (bottomleftr > 0.f) PathArc(dl, ImVec2{ startpos.x + bottomleftr, endpos.y - bottomleftr }, bottomleftr, 90.f, 180.f, stats);
     }
 
     float IRenderer::EllipsisWidth(void* fontptr, float sz)
@@ -745,23 +884,51 @@ namespace glimmer
         DrawParams() {}
     };
 
+    struct DeferredRenderer;
+    static void TessellateParallel(const DeferredRenderer& source, ImGuiRenderer& target, ImVec2 offset, int32_t from, int32_t to);
+
     struct DeferredRenderer final : public IRenderer
     {
+        FrameArenaAllocator arena{ GLIMMER_FRAME_ARENA_CHUNKSZ, GlobalAllocator };
         Vector<std::pair<DrawingOps, DrawParams>, int32_t, 32> queue{ 32 };
         ImVec2(*TextMeasure)(std::string_view text, void* fontptr, float sz, float wrapWidth);
+        std::deque<std::string> texts; // copies of enqueued text when commands outlive the frame
+        bool retained = false;
 
-        DeferredRenderer(ImVec2(*tm)(std::string_view text, void* fontptr, float sz, float wrapWidth))
-            : TextMeasure{ tm } {
+        DeferredRenderer(ImVec2(*tm)(std::string_view text, void* fontptr, float sz, float wrapWidth),
+            bool retain = false)
+            : TextMeasure{ tm }, retained{ retain } {
+        }
+
+        std::string_view Retain(std::string_view text)
+        {
+            return retained ? std::string_view{ texts.emplace_back(text) } : text;
         }
 
         int TotalEnqueued() const override { return queue.size(); }
 
         void Render(IRenderer& renderer, ImVec2 offset, int from, int to) override
         {
+            GLIMMER_PROFILE_SCOPE(PP_DeferredReplay);
+            to = to == -1 ? queue.size() : to;
+
+            if (Config.parallelTessellation && (to - from) >= GLIMMER_PARALLEL_TESSELLATION_MIN)
+            {
+                if (auto target = dynamic_cast<ImGuiRenderer*>(&renderer); target != nullptr)
+                {
+                    TessellateParallel(*this, *target, offset, from, to);
+                    return;
+                }
+            }
+
             auto prevdl = renderer.UserData;
             renderer.UserData = ImGui::GetWindowDrawList();
-            to = to == -1 ? queue.size() : to;
+            Replay(renderer, offset, from, to);
+            renderer.UserData = prevdl;
+        }
 
+        void Replay(IRenderer& renderer, ImVec2 offset, int from, int to) const
+        {
             for (auto idx = from; idx < to; ++idx)
             {
                 const auto& entry = queue[idx];
@@ -844,24 +1011,30 @@ namespace glimmer
                 default: break;
                 }
             }
-
-            renderer.UserData = prevdl;
         }
 
-        void Reset() { queue.clear(true); size = { 0.f, 0.f }; }
+        // Queue is the only occupant of the arena, so it grows in place and reset is O(1)
+        void Reset() { arena.Reset(); queue.rebind(&arena); texts.clear(); size = { 0.f, 0.f }; }
+
+        std::pair<DrawingOps, DrawParams>& Enqueue(DrawingOps op)
+        {
+            AllocationTagScope tag{ AT_Renderer };
+            auto& val = queue.emplace_back(); val.first = op;
+            return val;
+        }
 
         void SetClipRect(ImVec2 startpos, ImVec2 endpos, bool intersect)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::PushClippingRect;
+            auto& val = Enqueue(DrawingOps::PushClippingRect);
             val.second.clippingRect = { startpos, endpos, intersect };
             size = ImMax(size, endpos);
         }
 
-        void ResetClipRect() { auto& val = queue.emplace_back(); val.first = DrawingOps::PopClippingRect; }
+        void ResetClipRect() { Enqueue(DrawingOps::PopClippingRect); }
 
         void DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness = 1.f)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::Line;
+            auto& val = Enqueue(DrawingOps::Line);
             val.second.line = { startpos, endpos, color, thickness };
             size = ImMax(size, endpos);
         }
@@ -873,7 +1046,7 @@ namespace glimmer
 
         void DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, float thickness = 1.f)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::Triangle;
+            auto& val = Enqueue(DrawingOps::Triangle);
             val.second.triangle = { pos1, pos2, pos3, color, thickness, filled };
             size = ImMax(size, pos1);
             size = ImMax(size, pos2);
@@ -882,7 +1055,7 @@ namespace glimmer
 
         void DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness = 1.f)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::Rectangle;
+            auto& val = Enqueue(DrawingOps::Rectangle);
             val.second.rect = { startpos, endpos, color, thickness, filled };
             size = ImMax(size, endpos);
         }
@@ -890,14 +1063,14 @@ namespace glimmer
         void DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float topleftr, float toprightr,
             float bottomrightr, float bottomleftr, float thickness = 1.f)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::RoundedRectangle;
+            auto& val = Enqueue(DrawingOps::RoundedRectangle);
             val.second.roundedRect = { startpos, endpos, topleftr, toprightr, bottomleftr, bottomrightr, color, thickness, filled };
             size = ImMax(size, endpos);
         }
 
         void DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t colorfrom, uint32_t colorto, Direction dir)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::RectGradient;
+            auto& val = Enqueue(DrawingOps::RectGradient);
             val.second.rectGradient = { startpos, endpos, colorfrom, colorto, dir };
             size = ImMax(size, endpos);
         }
@@ -905,7 +1078,7 @@ namespace glimmer
         void DrawRoundedRectGradient(ImVec2 startpos, ImVec2 endpos, float topleftr, float toprightr, float bottomrightr,
             float bottomleftr, uint32_t colorfrom, uint32_t colorto, Direction dir)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::RoundedRectGradient;
+            auto& val = Enqueue(DrawingOps::RoundedRectGradient);
             val.second.roundedRectGradient = { startpos, endpos, topleftr, toprightr, bottomleftr, bottomrightr, colorfrom, colorto, dir };
             size = ImMax(size, endpos);
         }
@@ -916,14 +1089,14 @@ namespace glimmer
 
         void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, float thickness = 1.f)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::Circle;
+            auto& val = Enqueue(DrawingOps::Circle);
             val.second.circle = { center, radius, color, thickness, filled };
             size = ImMax(size, center + ImVec2{ radius, radius });
         }
 
         void DrawSector(ImVec2 center, float radius, int start, int end, uint32_t color, bool filled, bool inverted, float thickness = 1.f)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::Sector;
+            auto& val = Enqueue(DrawingOps::Sector);
             val.second.sector = { center, radius, start, end, color, thickness, filled, inverted };
             size = ImMax(size, center + ImVec2{ radius, radius });
         }
@@ -932,21 +1105,21 @@ namespace glimmer
 
         bool SetCurrentFont(std::string_view family, float sz, FontType type) override
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::PushFont;
+            auto& val = Enqueue(DrawingOps::PushFont);
             val.second.font = { GetFont(family, sz, type), sz };
             return true;
         }
 
         bool SetCurrentFont(void* fontptr, float sz) override
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::PushFont;
+            auto& val = Enqueue(DrawingOps::PushFont);
             val.second.font = { fontptr, sz };
             return true;
         }
 
         void ResetFont() override
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::PopFont;
+            Enqueue(DrawingOps::PopFont);
         }
 
         ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz, float wrapWidth = -1.f)
@@ -956,8 +1129,8 @@ namespace glimmer
 
         void DrawText(std::string_view text, ImVec2 pos, uint32_t color, float wrapWidth = -1.f)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::Text;
-            ::new (&val.second.text.text) std::string_view{ text };
+            auto& val = Enqueue(DrawingOps::Text);
+            ::new (&val.second.text.text) std::string_view{ Retain(text) };
             val.second.text.color = color;
             val.second.text.pos = pos;
             val.second.text.wrapWidth = wrapWidth;
@@ -966,15 +1139,15 @@ namespace glimmer
 
         void DrawTooltip(ImVec2 pos, std::string_view text)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::Tooltip;
+            auto& val = Enqueue(DrawingOps::Tooltip);
             val.second.tooltip.pos = pos;
-            ::new (&val.second.tooltip.text) std::string_view{ text };
+            ::new (&val.second.tooltip.text) std::string_view{ Retain(text) };
         }
 
         void DrawSVG(ImVec2 pos, ImVec2 size, uint32_t color, std::string_view content, bool fromFile)
         {
-            auto& val = queue.emplace_back(); val.first = DrawingOps::SVG;
-            val.second.svg = { pos, size, color, content, fromFile };
+            auto& val = Enqueue(DrawingOps::SVG);
+            val.second.svg = { pos, size, color, Retain(content), fromFile };
         }
     };
 
@@ -982,304 +1155,353 @@ namespace glimmer
 
 #pragma region SVG Renderer
 
-    // Helper to format uint32_t color to SVG "rgb(r,g,b)" or "rgba(r,g,b,a_float)" string into a buffer
-    // Returns the number of characters written (excluding null terminator).
-    inline int formatColorToSvg(char* buffer, size_t bufferSize, uint32_t colorInt)
+    void WriteSVGToFile(std::string_view chunk, void* file)
     {
-        auto [r, g, b, a] = DecomposeColor(colorInt); // Assumes DecomposeColor is available
-        if (a == 255)
+        std::fwrite(chunk.data(), 1, chunk.size(), (FILE*)file);
+    }
+
+    struct SVGColor { uint32_t color; };
+    struct SVGOpacity { uint32_t color; };
+    struct SVGEscaped { std::string_view text; };
+
+    // Growable SVG output, drained into the sink (if any) whenever it crosses GLIMMER_SVG_FLUSH_SZ.
+    // Numbers are formatted with std::to_chars, trailing zeros of the fractional part are trimmed.
+    struct SVGStream
+    {
+        std::string buffer;
+        SVGSinkT sink = nullptr;
+        void* userdata = nullptr;
+
+        void append(const char* data, size_t sz)
         {
-            return snprintf(buffer, bufferSize, "rgb(%d,%d,%d)", r, g, b);
+            buffer.append(data, sz);
+            if (sink != nullptr && buffer.size() >= GLIMMER_SVG_FLUSH_SZ) flush();
         }
-        else
+
+        void flush()
         {
-            return snprintf(buffer, bufferSize, "rgba(%d,%d,%d,%.3f)", r, g, b, static_cast<float>(a) / 255.0f);
+            if (sink != nullptr && !buffer.empty())
+            {
+                sink(buffer, userdata);
+                buffer.clear();
+            }
         }
-    }
-
-    // Helper to format uint32_t color's alpha to SVG opacity string into a buffer
-    // Returns the number of characters written.
-    inline int formatOpacityToSvg(char* buffer, size_t bufferSize, uint32_t colorInt) 
-    {
-        auto [r, g, b, a] = DecomposeColor(colorInt);
-        return snprintf(buffer, bufferSize, "%.3f", static_cast<float>(a) / 255.0f);
-    }
 
-    struct SVGRenderer final : public IRenderer
-    {
-        ImVec2(*textMeasureFunc)(std::string_view text, void* fontPtr, float sz, float wrapWidth);
+        void fixed(float value, int precision)
+        {
+            char buf[48];
+            auto end = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, precision).ptr;
 
-        int defsIdCounter;
-        std::string currentClipPathId; // Kept as std::string for convenience of ID management
-        bool clippingActive;
-        ImVec2 svgDimensions;
+            if (std::find(buf, end, '.') != end)
+            {
+                while (end[-1] == '0') --end;
+                if (end[-1] == '.') --end;
+            }
 
-        std::string currentFontFamily; // Kept as std::string
-        float currentFontSizePixels;
+            if (end - buf == 2 && buf[0] == '-' && buf[1] == '0') append("0", 1);
+            else append(buf, end - buf);
+        }
 
-        static constexpr size_t svgMainBufferSize = 1024 * 64; // 64KB for main content
-        static constexpr size_t svgDefsBufferSize = 1024 * 8;  // 8KB for <defs> content
-        static constexpr size_t scratchBufferSize = 1024 * 2;  // 2KB for temporary formatting
+        SVGStream& operator<<(std::string_view str) { append(str.data(), str.size()); return *this; }
+        SVGStream& operator<<(char ch) { append(&ch, 1); return *this; }
+        SVGStream& operator<<(float value) { fixed(value, 2); return *this; }
 
-        char mainSvgBuffer[svgMainBufferSize];
-        size_t mainSvgBufferOffset;
+        SVGStream& operator<<(int32_t value)
+        {
+            char buf[16];
+            auto end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+            append(buf, end - buf);
+            return *this;
+        }
 
-        char defsBuffer[svgDefsBufferSize];
-        size_t defsBufferOffset;
+        SVGStream& operator<<(SVGColor color)
+        {
+            auto [r, g, b, a] = DecomposeColor(color.color);
+            *this << (a == 255 ? "rgb(" : "rgba(") << r << ',' << g << ',' << b;
+            if (a != 255) { *this << ','; fixed((float)a / 255.f, 3); }
+            return *this << ')';
+        }
 
-        char scratchBuffer[scratchBufferSize]; // For formatting individual elements
+        SVGStream& operator<<(SVGOpacity color)
+        {
+            auto [r, g, b, a] = DecomposeColor(color.color);
+            fixed((float)a / 255.f, 3);
+            return *this;
+        }
 
-        // Helper to append data to a buffer, handling potential overflow.
-        void appendToBuffer(char* destBuffer, size_t& destOffset, size_t destCapacity, const char* srcData, int srcLen) 
+        SVGStream& operator<<(SVGEscaped escaped)
         {
-            if (srcLen <= 0) return;
-            if (destOffset + srcLen < destCapacity) {
-                memcpy(destBuffer + destOffset, srcData, srcLen);
-                destOffset += srcLen;
-                destBuffer[destOffset] = '\0'; // Keep null-terminated for safety if used as C-string
-            }
-            else {
-                // Handle overflow: for now, just don't append to prevent overrun.
-                // Optionally, log an error or append an overflow marker if space allows.
+            auto text = escaped.text;
+            size_t from = 0;
+
+            for (size_t idx = 0; idx < text.size(); ++idx)
+            {
+                std::string_view seq;
+                switch (text[idx])
+                {
+                case '&':  seq = "&amp;"; break;
+                case '<':  seq = "&lt;"; break;
+                case '>':  seq = "&gt;"; break;
+                case '"':  seq = "&quot;"; break;
+                case '\'': seq = "&apos;"; break;
+                default: continue;
+                }
+
+                append(text.data() + from, idx - from);
+                *this << seq;
+                from = idx + 1;
             }
+
+            append(text.data() + from, text.size() - from);
+            return *this;
         }
+    };
+
+    struct SVGRenderer final : public IRenderer
+    {
+        // Gradients and clip paths are emitted once per distinct definition and referred by id afterwards
+        enum class DefKind : int32_t { ClipRect, HorizontalGradient, VerticalGradient, RadialGradient };
 
-        void appendStringViewToBuffer(char* destBuffer, size_t& destOffset, size_t destCapacity, std::string_view sv) 
+        struct DefKey
         {
-            appendToBuffer(destBuffer, destOffset, destCapacity, sv.data(), static_cast<int>(sv.length()));
-        }
+            DefKind kind = DefKind::ClipRect;
+            uint32_t from = 0, to = 0;
+            float x0 = 0.f, y0 = 0.f, x1 = 0.f, y1 = 0.f;
+
+            bool operator==(const DefKey&) const = default;
+        };
+
+        struct DefKeyHash
+        {
+            size_t operator()(const DefKey& key) const
+            {
+                uint64_t hash = 14695981039346656037ull;
+                auto mix = [&hash](uint32_t val) { hash = (hash ^ val) * 1099511628211ull; };
+                uint32_t bits[4];
+                std::memcpy(bits, &key.x0, sizeof(bits));
+                mix((uint32_t)key.kind); mix(key.from); mix(key.to);
+                for (auto bit : bits) mix(bit);
+                return (size_t)hash;
+            }
+        };
 
-        SVGRenderer(ImVec2(*measureFunc)(std::string_view text, void* fontPtr, float sz, float wrapWidth), ImVec2 dimensionsVal = { 800, 600 })
-            : textMeasureFunc(measureFunc),
-            defsIdCounter(0),
-            clippingActive(false),
-            svgDimensions(dimensionsVal),
-            currentFontFamily("sans-serif"),
-            currentFontSizePixels(16.f),
-            mainSvgBufferOffset(0),
-            defsBufferOffset(0)
+        ImVec2(*textMeasureFunc)(std::string_view text, void* fontPtr, float sz, float wrapWidth);
+
+        int32_t defsIdCounter = 0;
+        bool clippingActive = false;
+        bool finalized = false;
+        ImVec2 svgDimensions;
+
+        std::string currentFontFamily = "sans-serif";
+        float currentFontSizePixels = 16.f;
+
+        SVGStream out;
+        std::unordered_map<DefKey, int32_t, DefKeyHash> defs;
+
+        SVGRenderer(ImVec2(*measureFunc)(std::string_view text, void* fontPtr, float sz, float wrapWidth), ImVec2 dimensionsVal = { 800, 600 },
+            SVGSinkT sink = nullptr, void* userdata = nullptr)
+            : textMeasureFunc(measureFunc), svgDimensions(dimensionsVal)
         {
-            mainSvgBuffer[0] = '\0';
-            defsBuffer[0] = '\0';
+            out.sink = sink;
+            out.userdata = userdata;
             Reset();
         }
 
         void Reset() override
         {
-            mainSvgBufferOffset = 0;
-            mainSvgBuffer[0] = '\0';
-            defsBufferOffset = 0;
-            defsBuffer[0] = '\0';
-
+            out.buffer.clear();
+            defs.clear();
             defsIdCounter = 0;
-            currentClipPathId.clear();
             clippingActive = false;
-
+            finalized = false;
             this->size = svgDimensions;
+
+            float svgW = (svgDimensions.x > 0.001f) ? svgDimensions.x : 1.0f;
+            float svgH = (svgDimensions.y > 0.001f) ? svgDimensions.y : 1.0f;
+            out << "<svg width=\"" << svgW << "\" height=\"" << svgH << "\" viewBox=\"0 0 " << svgW << ' ' << svgH << "\" "
+                "xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\">\n";
         }
 
-        std::string GetSVG()
+        std::string_view Finalize() override
         {
-            std::string finalSvgStr;
-            // Estimate size
-            size_t headerLen = 200; // Approx
-            size_t footerLen = 20;  // Approx
-            finalSvgStr.reserve(headerLen + defsBufferOffset + mainSvgBufferOffset + footerLen);
+            if (!finalized)
+            {
+                ResetClipRect();
+                out << "</svg>\n";
+                out.flush();
+                finalized = true;
+            }
 
-            float svgW = (svgDimensions.x > 0.001f) ? svgDimensions.x : 1.0f;
-            float svgH = (svgDimensions.y > 0.001f) ? svgDimensions.y : 1.0f;
+            return out.sink == nullptr ? std::string_view{ out.buffer } : std::string_view{};
+        }
+
+        // Returns the id of the definition, writing it out first if this is its first use
+        int32_t Define(const DefKey& key)
+        {
+            auto it = defs.find(key);
+            if (it != defs.end()) return it->second;
+
+            auto id = ++defsIdCounter;
+            defs.emplace(key, id);
+
+            if (key.kind == DefKind::ClipRect)
+            {
+                out << "  <defs><clipPath id=\"def" << id << "\"><rect x=\"" << key.x0 << "\" y=\"" << key.y0
+                    << "\" width=\"" << std::max(0.f, key.x1 - key.x0) << "\" height=\"" << std::max(0.f, key.y1 - key.y0)
+                    << "\" /></clipPath></defs>\n";
+            }
+            else
+            {
+                if (key.kind == DefKind::RadialGradient)
+                    out << "  <defs><radialGradient id=\"def" << id << "\" cx=\"50%\" cy=\"50%\" r=\"50%\" fx=\"50%\" fy=\"50%\">\n";
+                else
+                    out << "  <defs><linearGradient id=\"def" << id << "\" " << (key.kind == DefKind::HorizontalGradient ?
+                        "x1=\"0%\" y1=\"0%\" x2=\"100%\" y2=\"0%\">\n" : "x1=\"0%\" y1=\"0%\" x2=\"0%\" y2=\"100%\">\n");
+
+                out << "    <stop offset=\"0%\" style=\"stop-color:" << SVGColor{ key.from } << ";stop-opacity:" << SVGOpacity{ key.from } << "\" />\n"
+                    << "    <stop offset=\"100%\" style=\"stop-color:" << SVGColor{ key.to } << ";stop-opacity:" << SVGOpacity{ key.to } << "\" />\n"
+                    << (key.kind == DefKind::RadialGradient ? "  </radialGradient></defs>\n" : "  </linearGradient></defs>\n");
+            }
 
-            int writtenHeader = snprintf(scratchBuffer, scratchBufferSize,
-                "<svg width=\"%.2f\" height=\"%.2f\" viewBox=\"0 0 %.2f %.2f\" "
-                "xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\">\n"
-                "  <defs>\n",
-                svgW, svgH, svgW, svgH);
-            if (writtenHeader > 0) finalSvgStr.append(scratchBuffer, writtenHeader);
+            return id;
+        }
 
-            if (defsBufferOffset > 0) 
+        int32_t DefineGradient(uint32_t from, uint32_t to, Direction dir)
+        {
+            DefKey key;
+            key.kind = dir == DIR_Horizontal ? DefKind::HorizontalGradient : DefKind::VerticalGradient;
+            key.from = from; key.to = to;
+            return Define(key);
+        }
+
+        // Writes fill/stroke attributes, filled shapes with a positive thickness are stroked with the fill color
+        void Paint(uint32_t color, bool filled, float thickness)
+        {
+            if (filled)
             {
-                finalSvgStr.append(defsBuffer, defsBufferOffset);
+                out << " fill=\"" << SVGColor{ color } << '"';
+                if (thickness > 0.f) out << " stroke=\"" << SVGColor{ color } << "\" stroke-width=\"" << thickness << '"';
             }
-            finalSvgStr.append("  </defs>\n"); // Close defs
+            else
+                out << " fill=\"none\" stroke=\"" << SVGColor{ color } << "\" stroke-width=\"" << thickness << '"';
+        }
 
-            if (mainSvgBufferOffset > 0) 
+        void Points(ImVec2* points, int numPoints)
+        {
+            for (int i = 0; i < numPoints; ++i)
             {
-                finalSvgStr.append(mainSvgBuffer, mainSvgBufferOffset);
+                if (i > 0) out << ' ';
+                out << points[i].x << ',' << points[i].y;
             }
+        }
 
-            finalSvgStr.append("</svg>\n");
-            return finalSvgStr;
+        void RoundedRectPath(ImVec2 startPos, ImVec2 endPos, float w, float h, float topLeftR, float topRightR, float bottomRightR, float bottomLeftR)
+        {
+            float tlr = std::min({ std::max(0.0f, topLeftR), w / 2.0f, h / 2.0f });
+            float trr = std::min({ std::max(0.0f, topRightR), w / 2.0f, h / 2.0f });
+            float brr = std::min({ std::max(0.0f, bottomRightR), w / 2.0f, h / 2.0f });
+            float blr = std::min({ std::max(0.0f, bottomLeftR), w / 2.0f, h / 2.0f });
+
+            out << "M " << startPos.x + tlr << ',' << startPos.y << ' ';
+            out << "L " << endPos.x - trr << ',' << startPos.y << ' ';
+            if (trr > 0.001f) out << "A " << trr << ',' << trr << " 0 0 1 " << endPos.x << ',' << startPos.y + trr << ' ';
+            out << "L " << endPos.x << ',' << endPos.y - brr << ' ';
+            if (brr > 0.001f) out << "A " << brr << ',' << brr << " 0 0 1 " << endPos.x - brr << ',' << endPos.y << ' ';
+            out << "L " << startPos.x + blr << ',' << endPos.y << ' ';
+            if (blr > 0.001f) out << "A " << blr << ',' << blr << " 0 0 1 " << startPos.x << ',' << endPos.y - blr << ' ';
+            out << "L " << startPos.x << ',' << startPos.y + tlr << ' ';
+            if (tlr > 0.001f) out << "A " << tlr << ',' << tlr << " 0 0 1 " << startPos.x + tlr << ',' << startPos.y << ' ';
+            out << 'Z';
+        }
+
+        void SectorPath(ImVec2 center, float radius, int startAngleDeg, int endAngleDeg)
+        {
+            float startRad = static_cast<float>(startAngleDeg) * M_PI / 180.0f;
+            float endRad = static_cast<float>(endAngleDeg) * M_PI / 180.0f;
+            ImVec2 pStart = { center.x + radius * cosf(startRad), center.y + radius * sinf(startRad) };
+            ImVec2 pEnd = { center.x + radius * cosf(endRad), center.y + radius * sinf(endRad) };
+
+            float angleDiff = static_cast<float>(endAngleDeg - startAngleDeg);
+            while (angleDiff <= -360.0f) angleDiff += 360.0f;
+            while (angleDiff > 360.0f) angleDiff -= 360.0f;
+            int32_t largeArcFlag = (std::abs(angleDiff) > 180.0f) ? 1 : 0;
+            int32_t sweepFlag = (angleDiff >= 0.0f) ? 1 : 0;
+
+            out << "M " << center.x << ',' << center.y << " L " << pStart.x << ',' << pStart.y << " A " << radius << ',' << radius
+                << " 0 " << largeArcFlag << ',' << sweepFlag << ' ' << pEnd.x << ',' << pEnd.y << " Z";
         }
 
         // --- IRenderer Implementation ---
 
         void SetClipRect(ImVec2 startPos, ImVec2 endPos, bool intersect) override
         {
-            if (clippingActive) 
+            if (clippingActive)
             { // Close previous clipping group in main content
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, "  </g>\n", strlen("  </g>\n"));
+                out << "  </g>\n";
             }
 
-            defsIdCounter++;
-            char clipIdCstr[64];
-            snprintf(clipIdCstr, sizeof(clipIdCstr), "clipPathDef%d", defsIdCounter);
-            currentClipPathId = clipIdCstr;
-
-            int defsWritten = snprintf(scratchBuffer, scratchBufferSize,
-                "    <clipPath id=\"%s\">\n"
-                "      <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" />\n"
-                "    </clipPath>\n",
-                currentClipPathId.c_str(),
-                startPos.x, startPos.y,
-                std::max(0.0f, endPos.x - startPos.x),
-                std::max(0.0f, endPos.y - startPos.y));
-            if (defsWritten > 0) 
-            {
-                appendToBuffer(defsBuffer, defsBufferOffset, svgDefsBufferSize, scratchBuffer, defsWritten);
-            }
+            DefKey key;
+            key.kind = DefKind::ClipRect;
+            key.x0 = startPos.x; key.y0 = startPos.y;
+            key.x1 = endPos.x; key.y1 = endPos.y;
+            auto id = Define(key);
 
-            int gWritten = snprintf(scratchBuffer, scratchBufferSize, "  <g clip-path=\"url(#%s)\">\n", currentClipPathId.c_str());
-            if (gWritten > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, gWritten);
-            }
+            out << "  <g clip-path=\"url(#def" << id << ")\">\n";
             clippingActive = true;
         }
 
         void ResetClipRect() override
         {
-            if (clippingActive) 
+            if (clippingActive)
             {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, "  </g>\n", strlen("  </g>\n"));
+                out << "  </g>\n";
                 clippingActive = false;
-                currentClipPathId.clear();
             }
         }
 
         void DrawLine(ImVec2 startPos, ImVec2 endPos, uint32_t color, float thickness = 1.f) override
         {
             if (thickness <= 0.f) return;
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-
-            int written = snprintf(scratchBuffer, scratchBufferSize,
-                "  <line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                startPos.x, startPos.y, endPos.x, endPos.y, colorBuf, thickness);
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            out << "  <line x1=\"" << startPos.x << "\" y1=\"" << startPos.y << "\" x2=\"" << endPos.x << "\" y2=\"" << endPos.y
+                << "\" stroke=\"" << SVGColor{ color } << "\" stroke-width=\"" << thickness << "\" />\n";
         }
 
         void DrawPolyline(ImVec2* points, int numPoints, uint32_t color, float thickness) override
         {
             if (numPoints < 2 || thickness <= 0.f) return;
-
-            char pointsListStr[scratchBufferSize / 2];
-            int pointsListOffset = 0;
-            char pointItemBuf[40];
-
-            for (int i = 0; i < numPoints; ++i) 
-            {
-                int currentPtLen = snprintf(pointItemBuf, sizeof(pointItemBuf), "%.2f,%.2f%s",
-                    points[i].x, points[i].y, (i == numPoints - 1 ? "" : " "));
-                if (pointsListOffset + currentPtLen < (int)sizeof(pointsListStr) - 1) { // -1 for null terminator
-                    memcpy(pointsListStr + pointsListOffset, pointItemBuf, currentPtLen);
-                    pointsListOffset += currentPtLen;
-                }
-                else { break; }
-            }
-            pointsListStr[pointsListOffset] = '\0';
-
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-
-            int written = snprintf(scratchBuffer, scratchBufferSize,
-                "  <polyline points=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" fill=\"none\" />\n",
-                pointsListStr, colorBuf, thickness);
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            out << "  <polyline points=\"";
+            Points(points, numPoints);
+            out << "\" stroke=\"" << SVGColor{ color } << "\" stroke-width=\"" << thickness << "\" fill=\"none\" />\n";
         }
 
         void DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, float thickness = 1.f) override
         {
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-
-            int written = 0;
-            if (filled) 
-            {
-                if (thickness > 0.0f) {
-                    written = snprintf(scratchBuffer, scratchBufferSize,
-                        "  <polygon points=\"%.2f,%.2f %.2f,%.2f %.2f,%.2f\" fill=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                        pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y, colorBuf, colorBuf, thickness);
-                }
-                else {
-                    written = snprintf(scratchBuffer, scratchBufferSize,
-                        "  <polygon points=\"%.2f,%.2f %.2f,%.2f %.2f,%.2f\" fill=\"%s\" />\n",
-                        pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y, colorBuf);
-                }
-            }
-            else 
-            {
-                if (thickness <= 0.f) return;
-                written = snprintf(scratchBuffer, scratchBufferSize,
-                    "  <polygon points=\"%.2f,%.2f %.2f,%.2f %.2f,%.2f\" fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                    pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y, colorBuf, thickness);
-            }
-
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            if (!filled && thickness <= 0.f) return;
+            ImVec2 points[3] = { pos1, pos2, pos3 };
+            out << "  <polygon points=\"";
+            Points(points, 3);
+            out << '"';
+            Paint(color, filled, thickness);
+            out << " />\n";
         }
 
         void DrawRect(ImVec2 startPos, ImVec2 endPos, uint32_t color, bool filled, float thickness = 1.f) override
         {
             float w = endPos.x - startPos.x;
             float h = endPos.y - startPos.y;
-            if (w <= 0.001f && h <= 0.001f) 
+            if (w <= 0.001f && h <= 0.001f)
             {
                 if (!filled && thickness > 0.f && (std::abs(w) < 0.001f || std::abs(h) < 0.001f)) { /* line */ }
                 else return;
             }
-            
+
+            if (!filled && thickness <= 0.f) return;
             w = std::max(0.0f, w);
             h = std::max(0.0f, h);
 
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-            int written = 0;
-
-            if (filled) 
-            {
-                if (thickness > 0.0f) 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize,
-                        "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                        startPos.x, startPos.y, w, h, colorBuf, colorBuf, thickness);
-                }
-                else 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize,
-                        "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"%s\" />\n",
-                        startPos.x, startPos.y, w, h, colorBuf);
-                }
-            }
-            else 
-            {
-                if (thickness <= 0.f) return;
-                written = snprintf(scratchBuffer, scratchBufferSize,
-                    "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                    startPos.x, startPos.y, w, h, colorBuf, thickness);
-            }
-
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            out << "  <rect x=\"" << startPos.x << "\" y=\"" << startPos.y << "\" width=\"" << w << "\" height=\"" << h << '"';
+            Paint(color, filled, thickness);
+            out << " />\n";
         }
 
         void DrawRoundedRect(ImVec2 startPos, ImVec2 endPos, uint32_t color, bool filled,
@@ -1289,91 +1511,27 @@ namespace glimmer
             float w = endPos.x - startPos.x;
             float h = endPos.y - startPos.y;
             if (w <= 0.001f || h <= 0.001f) return;
-            w = std::max(0.0f, w);
-            h = std::max(0.0f, h);
-
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-            int written = 0;
+            if (!filled && thickness <= 0.f) return;
 
             bool uniformRadii = (std::abs(topLeftR - topRightR) < 0.01f &&
                 std::abs(topRightR - bottomRightR) < 0.01f &&
                 std::abs(bottomRightR - bottomLeftR) < 0.01f);
 
-            if (uniformRadii && topLeftR >= 0.f) 
+            if (uniformRadii && topLeftR >= 0.f)
             {
-                float radius = std::min({ topLeftR, w / 2.0f, h / 2.0f });
-                radius = std::max(0.0f, radius);
-                if (filled) {
-                    if (thickness > 0.0f) 
-                    {
-                        written = snprintf(scratchBuffer, scratchBufferSize,
-                            "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" rx=\"%.2f\" ry=\"%.2f\" fill=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                            startPos.x, startPos.y, w, h, radius, radius, colorBuf, colorBuf, thickness);
-                    }
-                    else 
-                    {
-                        written = snprintf(scratchBuffer, scratchBufferSize,
-                            "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" rx=\"%.2f\" ry=\"%.2f\" fill=\"%s\" />\n",
-                            startPos.x, startPos.y, w, h, radius, radius, colorBuf);
-                    }
-                }
-                else 
-                {
-                    if (thickness <= 0.f) return;
-                    written = snprintf(scratchBuffer, scratchBufferSize,
-                        "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" rx=\"%.2f\" ry=\"%.2f\" fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                        startPos.x, startPos.y, w, h, radius, radius, colorBuf, thickness);
-                }
+                float radius = std::max(0.0f, std::min({ topLeftR, w / 2.0f, h / 2.0f }));
+                out << "  <rect x=\"" << startPos.x << "\" y=\"" << startPos.y << "\" width=\"" << w << "\" height=\"" << h
+                    << "\" rx=\"" << radius << "\" ry=\"" << radius << '"';
             }
-            else 
+            else
             {
-                float tlr = std::min({ std::max(0.0f, topLeftR), w / 2.0f, h / 2.0f });
-                float trr = std::min({ std::max(0.0f, topRightR), w / 2.0f, h / 2.0f });
-                float brr = std::min({ std::max(0.0f, bottomRightR), w / 2.0f, h / 2.0f });
-                float blr = std::min({ std::max(0.0f, bottomLeftR), w / 2.0f, h / 2.0f });
-
-                char pathDataBuf[1024];
-                int pathOffset = 0;
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "M %.2f,%.2f ", startPos.x + tlr, startPos.y);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", endPos.x - trr, startPos.y);
-                if (trr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", trr, trr, endPos.x, startPos.y + trr);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", endPos.x, endPos.y - brr);
-                if (brr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", brr, brr, endPos.x - brr, endPos.y);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", startPos.x + blr, endPos.y);
-                if (blr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", blr, blr, startPos.x, endPos.y - blr);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", startPos.x, startPos.y + tlr);
-                if (tlr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", tlr, tlr, startPos.x + tlr, startPos.y);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "Z");
-
-                if (pathOffset > 0 && pathOffset < (int)sizeof(pathDataBuf)) 
-                {
-                    if (filled) 
-                    {
-                        if (thickness > 0.0f) 
-                        {
-                            written = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                                pathDataBuf, colorBuf, colorBuf, thickness);
-                        }
-                        else 
-                        {
-                            written = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"%s\" />\n",
-                                pathDataBuf, colorBuf);
-                        }
-                    }
-                    else 
-                    {
-                        if (thickness <= 0.f) return;
-                        written = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                            pathDataBuf, colorBuf, thickness);
-                    }
-                }
+                out << "  <path d=\"";
+                RoundedRectPath(startPos, endPos, w, h, topLeftR, topRightR, bottomRightR, bottomLeftR);
+                out << '"';
             }
 
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            Paint(color, filled, thickness);
+            out << " />\n";
         }
 
         void DrawRectGradient(ImVec2 startPos, ImVec2 endPos, uint32_t colorFrom, uint32_t colorTo, Direction dir) override
@@ -1381,40 +1539,10 @@ namespace glimmer
             float w = endPos.x - startPos.x;
             float h = endPos.y - startPos.y;
             if (w <= 0.001f || h <= 0.001f) return;
-            w = std::max(0.0f, w); h = std::max(0.0f, h);
-
-            defsIdCounter++;
-            char gradientIdCstr[64];
-            snprintf(gradientIdCstr, sizeof(gradientIdCstr), "gradRectDef%d", defsIdCounter);
-
-            char colorFromBuf[64], colorToBuf[64];
-            char opacityFromBuf[16], opacityToBuf[16];
-            formatColorToSvg(colorFromBuf, sizeof(colorFromBuf), colorFrom);
-            formatColorToSvg(colorToBuf, sizeof(colorToBuf), colorTo);
-            formatOpacityToSvg(opacityFromBuf, sizeof(opacityFromBuf), colorFrom);
-            formatOpacityToSvg(opacityToBuf, sizeof(opacityToBuf), colorTo);
-
-            int defsWritten = snprintf(scratchBuffer, scratchBufferSize,
-                "    <linearGradient id=\"%s\" %s>\n"
-                "      <stop offset=\"0%%\" style=\"stop-color:%s;stop-opacity:%s\" />\n"
-                "      <stop offset=\"100%%\" style=\"stop-color:%s;stop-opacity:%s\" />\n"
-                "    </linearGradient>\n",
-                gradientIdCstr,
-                (dir == DIR_Horizontal ? "x1=\"0%\" y1=\"0%\" x2=\"100%\" y2=\"0%\"" : "x1=\"0%\" y1=\"0%\" x2=\"0%\" y2=\"100%\""),
-                colorFromBuf, opacityFromBuf,
-                colorToBuf, opacityToBuf);
-            if (defsWritten > 0) 
-            {
-                appendToBuffer(defsBuffer, defsBufferOffset, svgDefsBufferSize, scratchBuffer, defsWritten);
-            }
 
-            int rectWritten = snprintf(scratchBuffer, scratchBufferSize,
-                "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"url(#%s)\" />\n",
-                startPos.x, startPos.y, w, h, gradientIdCstr);
-            if (rectWritten > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, rectWritten);
-            }
+            auto id = DefineGradient(colorFrom, colorTo, dir);
+            out << "  <rect x=\"" << startPos.x << "\" y=\"" << startPos.y << "\" width=\"" << w << "\" height=\"" << h
+                << "\" fill=\"url(#def" << id << ")\" />\n";
         }
 
         void DrawRoundedRectGradient(ImVec2 startPos, ImVec2 endPos,
@@ -1424,132 +1552,43 @@ namespace glimmer
             float w = endPos.x - startPos.x;
             float h = endPos.y - startPos.y;
             if (w <= 0.001f || h <= 0.001f) return;
-            w = std::max(0.0f, w); h = std::max(0.0f, h);
-
-            defsIdCounter++;
-            char gradientIdCstr[64];
-            snprintf(gradientIdCstr, sizeof(gradientIdCstr), "gradRoundRectDef%d", defsIdCounter);
-
-            char colorFromBuf[64], colorToBuf[64];
-            char opacityFromBuf[16], opacityToBuf[16];
-            formatColorToSvg(colorFromBuf, sizeof(colorFromBuf), colorFrom);
-            formatColorToSvg(colorToBuf, sizeof(colorToBuf), colorTo);
-            formatOpacityToSvg(opacityFromBuf, sizeof(opacityFromBuf), colorFrom);
-            formatOpacityToSvg(opacityToBuf, sizeof(opacityToBuf), colorTo);
-
-            int defsWritten = snprintf(scratchBuffer, scratchBufferSize,
-                "    <linearGradient id=\"%s\" %s>\n"
-                "      <stop offset=\"0%%\" style=\"stop-color:%s;stop-opacity:%s\" />\n"
-                "      <stop offset=\"100%%\" style=\"stop-color:%s;stop-opacity:%s\" />\n"
-                "    </linearGradient>\n",
-                gradientIdCstr,
-                (dir == DIR_Horizontal ? "x1=\"0%\" y1=\"0%\" x2=\"100%\" y2=\"0%\"" : "x1=\"0%\" y1=\"0%\" x2=\"0%\" y2=\"100%\""),
-                colorFromBuf, opacityFromBuf,
-                colorToBuf, opacityToBuf);
-
-            if (defsWritten > 0) 
-            {
-                appendToBuffer(defsBuffer, defsBufferOffset, svgDefsBufferSize, scratchBuffer, defsWritten);
-            }
 
-            int shapeWritten = 0;
+            auto id = DefineGradient(colorFrom, colorTo, dir);
             bool uniformRadii = (std::abs(topLeftR - topRightR) < 0.01f &&
                 std::abs(topRightR - bottomRightR) < 0.01f &&
                 std::abs(bottomRightR - bottomLeftR) < 0.01f);
 
-            if (uniformRadii && topLeftR >= 0.f) 
+            if (uniformRadii && topLeftR >= 0.f)
             {
-                float radius = std::min({ topLeftR, w / 2.0f, h / 2.0f });
-                radius = std::max(0.0f, radius);
-                shapeWritten = snprintf(scratchBuffer, scratchBufferSize,
-                    "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" rx=\"%.2f\" ry=\"%.2f\" fill=\"url(#%s)\" />\n",
-                    startPos.x, startPos.y, w, h, radius, radius, gradientIdCstr);
+                float radius = std::max(0.0f, std::min({ topLeftR, w / 2.0f, h / 2.0f }));
+                out << "  <rect x=\"" << startPos.x << "\" y=\"" << startPos.y << "\" width=\"" << w << "\" height=\"" << h
+                    << "\" rx=\"" << radius << "\" ry=\"" << radius << '"';
             }
-            else 
+            else
             {
-                float tlr = std::min({ std::max(0.0f, topLeftR), w / 2.0f, h / 2.0f });
-                float trr = std::min({ std::max(0.0f, topRightR), w / 2.0f, h / 2.0f });
-                float brr = std::min({ std::max(0.0f, bottomRightR), w / 2.0f, h / 2.0f });
-                float blr = std::min({ std::max(0.0f, bottomLeftR), w / 2.0f, h / 2.0f });
-
-                char pathDataBuf[1024];
-                int pathOffset = 0;
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "M %.2f,%.2f ", startPos.x + tlr, startPos.y);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", endPos.x - trr, startPos.y);
-                if (trr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", trr, trr, endPos.x, startPos.y + trr);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", endPos.x, endPos.y - brr);
-                if (brr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", brr, brr, endPos.x - brr, endPos.y);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", startPos.x + blr, endPos.y);
-                if (blr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", blr, blr, startPos.x, endPos.y - blr);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "L %.2f,%.2f ", startPos.x, startPos.y + tlr);
-                if (tlr > 0.001f) pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "A %.2f,%.2f 0 0 1 %.2f,%.2f ", tlr, tlr, startPos.x + tlr, startPos.y);
-                pathOffset += snprintf(pathDataBuf + pathOffset, sizeof(pathDataBuf) - pathOffset, "Z");
-
-                if (pathOffset > 0 && pathOffset < (int)sizeof(pathDataBuf)) 
-                {
-                    shapeWritten = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"url(#%s)\" />\n",
-                        pathDataBuf, gradientIdCstr);
-                }
+                out << "  <path d=\"";
+                RoundedRectPath(startPos, endPos, w, h, topLeftR, topRightR, bottomRightR, bottomLeftR);
+                out << '"';
             }
 
-            if (shapeWritten > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, shapeWritten);
-            }
+            out << " fill=\"url(#def" << id << ")\" />\n";
         }
 
         void DrawPolygon(ImVec2* points, int numPoints, uint32_t color, bool filled, float thickness = 1.f) override
         {
             if (numPoints < 3) return;
+            if (!filled && thickness <= 0.f) return;
 
-            char pointsListStr[scratchBufferSize / 2];
-            int pointsListOffset = 0;
-            char pointItemBuf[40];
-            for (int i = 0; i < numPoints; ++i) 
-            {
-                int currentPtLen = snprintf(pointItemBuf, sizeof(pointItemBuf), "%.2f,%.2f%s",
-                    points[i].x, points[i].y, (i == numPoints - 1 ? "" : " "));
-                if (pointsListOffset + currentPtLen < (int)sizeof(pointsListStr) - 1) 
-                {
-                    memcpy(pointsListStr + pointsListOffset, pointItemBuf, currentPtLen);
-                    pointsListOffset += currentPtLen;
-                }
-                else { break; }
-            }
-            pointsListStr[pointsListOffset] = '\0';
-
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-            int written = 0;
-
-            if (filled) {
-                if (thickness > 0.0f) 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize, "  <polygon points=\"%s\" fill=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                        pointsListStr, colorBuf, colorBuf, thickness);
-                }
-                else 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize, "  <polygon points=\"%s\" fill=\"%s\" />\n",
-                        pointsListStr, colorBuf);
-                }
-            }
-            else 
-            {
-                if (thickness <= 0.f) return;
-                written = snprintf(scratchBuffer, scratchBufferSize, "  <polygon points=\"%s\" fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                    pointsListStr, colorBuf, thickness);
-            }
-
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            out << "  <polygon points=\"";
+            Points(points, numPoints);
+            out << '"';
+            Paint(color, filled, thickness);
+            out << " />\n";
         }
 
         void DrawPolyGradient(ImVec2* points, uint32_t* colors, int numPoints) override
         {
-            if (numPoints > 0 && colors) 
+            if (numPoints > 0 && colors)
             { // Simplified: use first color for solid fill
                 DrawPolygon(points, numPoints, colors[0], true, 0.f);
             }
@@ -1558,159 +1597,59 @@ namespace glimmer
         void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, float thickness = 1.f) override
         {
             if (radius <= 0.001f) return;
-            radius = std::max(0.0f, radius);
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-            int written = 0;
+            if (!filled && thickness <= 0.f) return;
 
-            if (filled) 
-            {
-                if (thickness > 0.0f) 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize, "  <circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\" fill=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                        center.x, center.y, radius, colorBuf, colorBuf, thickness);
-                }
-                else 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize, "  <circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\" fill=\"%s\" />\n",
-                        center.x, center.y, radius, colorBuf);
-                }
-            }
-            else 
-            {
-                if (thickness <= 0.f) return;
-                written = snprintf(scratchBuffer, scratchBufferSize, "  <circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\" fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                    center.x, center.y, radius, colorBuf, thickness);
-            }
-
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            out << "  <circle cx=\"" << center.x << "\" cy=\"" << center.y << "\" r=\"" << radius << '"';
+            Paint(color, filled, thickness);
+            out << " />\n";
         }
 
         void DrawSector(ImVec2 center, float radius, int startAngleDeg, int endAngleDeg, uint32_t color, bool filled, bool inverted, float thickness = 1.f) override
         {
             if (radius <= 0.001f) return;
-            radius = std::max(0.0f, radius);
-            float startRad = static_cast<float>(startAngleDeg) * M_PI / 180.0f;
-            float endRad = static_cast<float>(endAngleDeg) * M_PI / 180.0f;
-
-            ImVec2 pStart = { center.x + radius * cosf(startRad), center.y + radius * sinf(startRad) };
-            ImVec2 pEnd = { center.x + radius * cosf(endRad), center.y + radius * sinf(endRad) };
 
             float angleDiff = static_cast<float>(endAngleDeg - startAngleDeg);
             while (angleDiff <= -360.0f) angleDiff += 360.0f;
             while (angleDiff > 360.0f) angleDiff -= 360.0f;
 
-            int largeArcFlag = (std::abs(angleDiff) > 180.0f) ? 1 : 0;
-            int sweepFlag = (angleDiff >= 0.0f) ? 1 : 0;
-
-            if (std::abs(angleDiff) >= 359.99f) 
+            if (std::abs(angleDiff) >= 359.99f)
             {
                 DrawCircle(center, radius, color, filled, thickness);
                 return;
             }
 
-            if (inverted) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, "\n", strlen("\n"));
-            }
-
-            char pathDataBuf[512];
-            snprintf(pathDataBuf, sizeof(pathDataBuf), "M %.2f,%.2f L %.2f,%.2f A %.2f,%.2f 0 %d,%d %.2f,%.2f Z",
-                center.x, center.y, pStart.x, pStart.y, radius, radius, largeArcFlag, sweepFlag, pEnd.x, pEnd.y);
-
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-            int written = 0;
-
-            if (filled) 
-            {
-                if (thickness > 0.0f) 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"%s\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                        pathDataBuf, colorBuf, colorBuf, thickness);
-                }
-                else 
-                {
-                    written = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"%s\" />\n",
-                        pathDataBuf, colorBuf);
-                }
-            }
-            else 
-            {
-                if (thickness <= 0.f) return;
-                written = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" />\n",
-                    pathDataBuf, colorBuf, thickness);
-            }
+            if (!filled && thickness <= 0.f) return;
+            if (inverted) out << '\n';
 
-            if (written > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
-            }
+            out << "  <path d=\"";
+            SectorPath(center, radius, startAngleDeg, endAngleDeg);
+            out << '"';
+            Paint(color, filled, thickness);
+            out << " />\n";
         }
 
         void DrawRadialGradient(ImVec2 center, float radius, uint32_t colorIn, uint32_t colorOut, int startAngleDeg, int endAngleDeg) override
         {
             if (radius <= 0.001f) return;
-            radius = std::max(0.0f, radius);
-            defsIdCounter++;
-            char gradientIdCstr[64];
-            snprintf(gradientIdCstr, sizeof(gradientIdCstr), "gradRadialDef%d", defsIdCounter);
-
-            char colorInBuf[64], colorOutBuf[64];
-            char opacityInBuf[16], opacityOutBuf[16];
-            formatColorToSvg(colorInBuf, sizeof(colorInBuf), colorIn);
-            formatColorToSvg(colorOutBuf, sizeof(colorOutBuf), colorOut);
-            formatOpacityToSvg(opacityInBuf, sizeof(opacityInBuf), colorIn);
-            formatOpacityToSvg(opacityOutBuf, sizeof(opacityOutBuf), colorOut);
-
-            int defsWritten = snprintf(scratchBuffer, scratchBufferSize,
-                "    <radialGradient id=\"%s\" cx=\"50%%\" cy=\"50%%\" r=\"50%%\" fx=\"50%%\" fy=\"50%%\">\n"
-                "      <stop offset=\"0%%\" style=\"stop-color:%s;stop-opacity:%s\" />\n"
-                "      <stop offset=\"100%%\" style=\"stop-color:%s;stop-opacity:%s\" />\n"
-                "    </radialGradient>\n",
-                gradientIdCstr, colorInBuf, opacityInBuf, colorOutBuf, opacityOutBuf);
-
-            if (defsWritten > 0) 
-            {
-                appendToBuffer(defsBuffer, defsBufferOffset, svgDefsBufferSize, scratchBuffer, defsWritten);
-            }
 
-            int shapeWritten = 0;
+            DefKey key;
+            key.kind = DefKind::RadialGradient;
+            key.from = colorIn; key.to = colorOut;
+            auto id = Define(key);
+
             float angleDiffAbs = std::abs(static_cast<float>(endAngleDeg - startAngleDeg));
             while (angleDiffAbs >= 360.0f) angleDiffAbs -= 360.0f;
 
-            if (angleDiffAbs < 359.99f && !(startAngleDeg == 0 && endAngleDeg == 0)) 
-            {
-                float startRad = static_cast<float>(startAngleDeg) * M_PI / 180.0f;
-                float endRad = static_cast<float>(endAngleDeg) * M_PI / 180.0f;
-                ImVec2 pStart = { center.x + radius * cosf(startRad), center.y + radius * sinf(startRad) };
-                ImVec2 pEnd = { center.x + radius * cosf(endRad), center.y + radius * sinf(endRad) };
-
-                float angleDiffSweep = static_cast<float>(endAngleDeg - startAngleDeg);
-                while (angleDiffSweep <= -360.0f) angleDiffSweep += 360.0f;
-                while (angleDiffSweep > 360.0f) angleDiffSweep -= 360.0f;
-                int largeArcFlag = (std::abs(angleDiffSweep) > 180.0f) ? 1 : 0;
-                int sweepFlag = (angleDiffSweep >= 0.0f) ? 1 : 0;
-
-                char pathDataBuf[512];
-                snprintf(pathDataBuf, sizeof(pathDataBuf), "M %.2f,%.2f L %.2f,%.2f A %.2f,%.2f 0 %d,%d %.2f,%.2f Z",
-                    center.x, center.y, pStart.x, pStart.y, radius, radius, largeArcFlag, sweepFlag, pEnd.x, pEnd.y);
-                shapeWritten = snprintf(scratchBuffer, scratchBufferSize, "  <path d=\"%s\" fill=\"url(#%s)\" />\n",
-                    pathDataBuf, gradientIdCstr);
-            }
-            else 
+            if (angleDiffAbs < 359.99f && !(startAngleDeg == 0 && endAngleDeg == 0))
             {
-                shapeWritten = snprintf(scratchBuffer, scratchBufferSize, "  <circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\" fill=\"url(#%s)\" />\n",
-                    center.x, center.y, radius, gradientIdCstr);
+                out << "  <path d=\"";
+                SectorPath(center, radius, startAngleDeg, endAngleDeg);
+                out << '"';
             }
+            else
+                out << "  <circle cx=\"" << center.x << "\" cy=\"" << center.y << "\" r=\"" << radius << '"';
 
-            if (shapeWritten > 0) 
-            {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, shapeWritten);
-            }
+            out << " fill=\"url(#def" << id << ")\" />\n";
         }
 
         bool SetCurrentFont(std::string_view family, float sz, FontType type) override { return false; }
@@ -1719,7 +1658,7 @@ namespace glimmer
 
         ImVec2 GetTextSize(std::string_view text, void* fontPtr, float sz, float wrapWidth = -1.f) override
         {
-            if (textMeasureFunc) 
+            if (textMeasureFunc)
             {
                 return textMeasureFunc(text, fontPtr, sz, wrapWidth);
             }
@@ -1730,34 +1669,9 @@ namespace glimmer
         void DrawText(std::string_view text, ImVec2 pos, uint32_t color, float wrapWidth = -1.f) override
         {
             float adjustedY = pos.y + currentFontSizePixels * 0.8f;
-
-            char colorBuf[64];
-            formatColorToSvg(colorBuf, sizeof(colorBuf), color);
-
-            int writtenOffset = snprintf(scratchBuffer, scratchBufferSize,
-                "  <text x=\"%.2f\" y=\"%.2f\" font-family=\"%s\" font-size=\"%.0fpx\" fill=\"%s\">",
-                pos.x, adjustedY, currentFontFamily.c_str(), currentFontSizePixels, colorBuf);
-            if (writtenOffset <= 0) return;
-            appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, writtenOffset);
-
-            char escCharBuf[10];
-            for (char c : text) 
-            {
-                const char* escSeq = nullptr;
-                int seqLen = 1;
-                switch (c) 
-                {
-                case '&':  escSeq = "&amp;"; seqLen = 5; break;
-                case '<':  escSeq = "&lt;"; seqLen = 4; break;
-                case '>':  escSeq = "&gt;"; seqLen = 4; break;
-                case '"':  escSeq = "&quot;"; seqLen = 6; break;
-                case '\'': escSeq = "&apos;"; seqLen = 6; break;
-                default:   escCharBuf[0] = c; escCharBuf[1] = '\0'; escSeq = escCharBuf; break;
-                }
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, escSeq, seqLen);
-            }
-
-            appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, "</text>\n", strlen("</text>\n"));
+            out << "  <text x=\"" << pos.x << "\" y=\"" << adjustedY << "\" font-family=\"" << SVGEscaped{ currentFontFamily }
+                << "\" font-size=\"" << (int32_t)roundf(currentFontSizePixels) << "px\" fill=\"" << SVGColor{ color } << "\">"
+                << SVGEscaped{ text } << "</text>\n";
         }
 
         void DrawTooltip(ImVec2 pos, std::string_view text) override
@@ -1772,59 +1686,29 @@ namespace glimmer
             const char* defaultTooltipFontFamily = "sans-serif";
 
             ImVec2 textDim = { 0.0f, 0.0f };
-            if (textMeasureFunc) 
+            if (textMeasureFunc)
             {
                 textDim = textMeasureFunc(text, nullptr, defaultTooltipFontSize, -1.f);
             }
-            else 
+            else
             {
                 textDim = ImVec2{ static_cast<float>(text.length()) * defaultTooltipFontSize * 0.6f, defaultTooltipFontSize };
             }
 
-            float rectX = pos.x;
-            float rectY = pos.y;
             float rectW = textDim.x + 2 * padding;
             float rectH = textDim.y + 2 * padding;
-
             float textXPos = pos.x + padding;
             float textYPos = pos.y + padding + textDim.y * 0.8f;
 
-            char bgColorBuf[64], textColorBuf[64], borderColorBuf[64];
-            formatColorToSvg(bgColorBuf, sizeof(bgColorBuf), bgColorVal);
-            formatColorToSvg(textColorBuf, sizeof(textColorBuf), textColorVal);
-            formatColorToSvg(borderColorBuf, sizeof(borderColorBuf), borderColorVal);
-
-            int initialOffset = 0;
-            initialOffset += snprintf(scratchBuffer + initialOffset, scratchBufferSize - initialOffset, "  <g>\n");
-            initialOffset += snprintf(scratchBuffer + initialOffset, scratchBufferSize - initialOffset,
-                "    <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" rx=\"3\" ry=\"3\" fill=\"%s\" stroke=\"%s\" stroke-width=\"1\" />\n",
-                rectX, rectY, rectW, rectH, bgColorBuf, borderColorBuf);
-            appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, initialOffset);
-
-            int textPartOffset = snprintf(scratchBuffer, scratchBufferSize,
-                "    <text x=\"%.2f\" y=\"%.2f\" font-family=\"%s\" font-size=\"%.0fpx\" fill=\"%s\">",
-                textXPos, textYPos, defaultTooltipFontFamily, defaultTooltipFontSize, textColorBuf);
-            if (textPartOffset > 0) appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, textPartOffset);
-
-            char escCharBuf[10];
-            for (char c : text) 
-            {
-                const char* escSeq = nullptr; int seqLen = 1;
-                switch (c) 
-                {
-                case '&':  escSeq = "&amp;"; seqLen = 5; break; case '<':  escSeq = "&lt;"; seqLen = 4; break;
-                case '>':  escSeq = "&gt;"; seqLen = 4; break; case '"':  escSeq = "&quot;"; seqLen = 6; break;
-                case '\'': escSeq = "&apos;"; seqLen = 6; break; default:   escCharBuf[0] = c; escCharBuf[1] = '\0'; escSeq = escCharBuf; break;
-                }
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, escSeq, seqLen);
-            }
-
-            appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, "</text>\n  </g>\n", strlen("</text>\n  </g>\n"));
+            out << "  <g>\n    <rect x=\"" << pos.x << "\" y=\"" << pos.y << "\" width=\"" << rectW << "\" height=\"" << rectH
+                << "\" rx=\"3\" ry=\"3\" fill=\"" << SVGColor{ bgColorVal } << "\" stroke=\"" << SVGColor{ borderColorVal } << "\" stroke-width=\"1\" />\n"
+                << "    <text x=\"" << textXPos << "\" y=\"" << textYPos << "\" font-family=\"" << defaultTooltipFontFamily
+                << "\" font-size=\"" << (int32_t)defaultTooltipFontSize << "px\" fill=\"" << SVGColor{ textColorVal } << "\">"
+                << SVGEscaped{ text } << "</text>\n  </g>\n";
         }
 
-
         float EllipsisWidth(void* fontPtr, float sz) override {
-            if (textMeasureFunc) 
+            if (textMeasureFunc)
             {
                 return textMeasureFunc("...", fontPtr, sz, -1.f).x;
             }
@@ -1837,39 +1721,267 @@ namespace glimmer
 
         void DrawSVG(ImVec2 pos, ImVec2 size, uint32_t color, std::string_view svgContentToEmbed, bool fromFile) override
         {
-            if (fromFile) 
+            if (svgContentToEmbed.empty()) return;
+
+            if (fromFile)
             {
-                int written = snprintf(scratchBuffer, scratchBufferSize, "  \n", (int)svgContentToEmbed.length(), svgContentToEmbed.data());
-                if (written > 0) appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
+                DrawImage(pos, size, svgContentToEmbed);
                 return;
             }
-            if (svgContentToEmbed.empty()) return;
-
-            int writtenOpen = snprintf(scratchBuffer, scratchBufferSize,
-                "  <svg x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\">\n",
-                pos.x, pos.y, size.x, size.y);
-            if (writtenOpen > 0) appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, writtenOpen);
 
-            appendStringViewToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, svgContentToEmbed);
-            appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, "\n  </svg>\n", strlen("\n  </svg>\n"));
+            out << "  <svg x=\"" << pos.x << "\" y=\"" << pos.y << "\" width=\"" << size.x << "\" height=\"" << size.y << "\">\n"
+                << svgContentToEmbed << "\n  </svg>\n";
         }
 
         void DrawImage(ImVec2 pos, ImVec2 size, std::string_view filePathOrDataUri) override
         {
             if (size.x <= 0.001f || size.y <= 0.001f || filePathOrDataUri.empty()) return;
-            size.x = std::max(0.0f, size.x); size.y = std::max(0.0f, size.y);
 
-            int written = snprintf(scratchBuffer, scratchBufferSize,
-                "  <image x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" xlink:href=\"%.*s\" />\n",
-                pos.x, pos.y, size.x, size.y,
-                (int)filePathOrDataUri.length(), filePathOrDataUri.data());
-            if (written > 0) 
+            out << "  <image x=\"" << pos.x << "\" y=\"" << pos.y << "\" width=\"" << size.x << "\" height=\"" << size.y
+                << "\" xlink:href=\"" << SVGEscaped{ filePathOrDataUri } << "\" />\n";
+        }
+    };
+
+#pragma endregion
+
+#pragma region Parallel Tessellation
+
+    // Persistent workers which tessellate chunks of a deferred command range, the calling
+    // thread works on chunks as well. Runs are serialized, UI trees on several threads share it.
+    struct TessellationPool
+    {
+        std::vector<std::thread> workers;
+        std::mutex lock, runLock;
+        std::condition_variable wake, done;
+        void (*job)(int32_t, void*) = nullptr;
+        void* data = nullptr;
+        int32_t total = 0, busy = 0;
+        std::atomic<int32_t> next{ 0 }, remaining{ 0 };
+        uint64_t generation = 0;
+        bool stopping = false;
+
+        explicit TessellationPool(int32_t count)
+        {
+            for (auto idx = 0; idx < count; ++idx)
+                workers.emplace_back([this] { Work(); });
+        }
+
+        ~TessellationPool()
+        {
+            { std::lock_guard<std::mutex> guard{ lock }; stopping = true; }
+            wake.notify_all();
+            for (auto& worker : workers) worker.join();
+        }
+
+        // Job published by one Run(), workers copy it under the lock so that a later Run() never
+        // rewrites the fields a late waking worker is still reading
+        struct Job
+        {
+            void (*func)(int32_t, void*) = nullptr;
+            void* data = nullptr;
+            int32_t total = 0;
+        };
+
+        void Work()
+        {
+            uint64_t seen = 0;
+
+            while (true)
             {
-                appendToBuffer(mainSvgBuffer, mainSvgBufferOffset, svgMainBufferSize, scratchBuffer, written);
+                Job current;
+
+                {
+                    std::unique_lock<std::mutex> guard{ lock };
+                    wake.wait(guard, [&] { return stopping || generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                    current = Job{ job, data, total };
+                    ++busy;
+                }
+
+                Drain(current);
+
+                { std::lock_guard<std::mutex> guard{ lock }; --busy; }
+                done.notify_all();
             }
         }
+
+        void Drain(const Job& current)
+        {
+            for (auto idx = next.fetch_add(1); idx < current.total; idx = next.fetch_add(1))
+            {
+                current.func(idx, current.data);
+                remaining.fetch_sub(1);
+            }
+        }
+
+        void Run(int32_t count, void (*func)(int32_t, void*), void* userdata)
+        {
+            std::lock_guard<std::mutex> serial{ runLock };
+
+            {
+                // A worker which woke late for the previous run may still hold its snapshot,
+                // next must not be reset below it until that worker has left Drain()
+                std::unique_lock<std::mutex> guard{ lock };
+                done.wait(guard, [&] { return busy == 0; });
+                job = func; data = userdata; total = count;
+                next = 0; remaining = count;
+                ++generation;
+            }
+
+            wake.notify_all();
+            Drain(Job{ func, userdata, count });
+
+            // Workers still inside Drain() read the job, wait for them before it changes
+            std::unique_lock<std::mutex> guard{ lock };
+            done.wait(guard, [&] { return remaining.load() == 0 && busy == 0; });
+        }
     };
 
+    static TessellationPool& Tessellators()
+    {
+        static TessellationPool pool{ GLIMMER_TESSELLATION_THREADS };
+        return pool;
+    }
+
+    struct TessellationChunk
+    {
+        // Draw lists tessellate paths in a scratch buffer of their shared data, so each chunk has a copy
+        ImDrawListSharedData shared;
+        ImDrawList dl{ &shared };
+        ImGuiRenderer renderer;
+        int32_t from = 0, to = 0;
+        bool serial = false; // Contains commands which need ImGui's global state, replayed on the caller
+    };
+
+    struct TessellationJob
+    {
+        const DeferredRenderer* source = nullptr;
+        const std::unique_ptr<TessellationChunk>* chunks = nullptr;
+        ImVec2 offset;
+    };
+
+    // Chunks keep their draw list buffers across frames
+    static thread_local std::vector<std::unique_ptr<TessellationChunk>> TessellationChunks;
+
+    static void TessellateChunk(int32_t index, void* data)
+    {
+        const auto& job = *(const TessellationJob*)data;
+        auto& chunk = *job.chunks[index];
+        if (!chunk.serial) job.source->Replay(chunk.renderer, job.offset, chunk.from, chunk.to);
+    }
+
+    // Appends the tessellated geometry of a chunk to the target list, commands keep their clip rect
+    // and texture, indices are rebased onto the target's vertex buffer
+    static void MergeDrawList(ImDrawList& target, const ImDrawList& source)
+    {
+        for (const auto& cmd : source.CmdBuffer)
+        {
+            if (cmd.ElemCount == 0 || cmd.UserCallback != nullptr) continue;
+
+            const auto* indices = source.IdxBuffer.Data + cmd.IdxOffset;
+            auto vmin = UINT32_MAX, vmax = 0u;
+            for (auto idx = 0u; idx < cmd.ElemCount; ++idx)
+            {
+                vmin = std::min<uint32_t>(vmin, indices[idx]);
+                vmax = std::max<uint32_t>(vmax, indices[idx]);
+            }
+
+            auto vcount = (int)(vmax - vmin + 1);
+            target.PushClipRect({ cmd.ClipRect.x, cmd.ClipRect.y }, { cmd.ClipRect.z, cmd.ClipRect.w });
+            target.PushTextureID(cmd.TextureId);
+            target.PrimReserve((int)cmd.ElemCount, vcount);
+
+            auto base = target._VtxCurrentIdx;
+            std::memcpy(target._VtxWritePtr, source.VtxBuffer.Data + cmd.VtxOffset + vmin, vcount * sizeof(ImDrawVert));
+            for (auto idx = 0u; idx < cmd.ElemCount; ++idx)
+                target._IdxWritePtr[idx] = (ImDrawIdx)(base + indices[idx] - vmin);
+
+            target._VtxWritePtr += vcount;
+            target._IdxWritePtr += cmd.ElemCount;
+            target._VtxCurrentIdx += vcount;
+            target.PopTextureID();
+            target.PopClipRect();
+        }
+    }
+
+    // Splits the range at points where the clip rect and font stacks are balanced, so every chunk
+    // starts with the state of the range start. Chunks are tessellated in parallel into their own
+    // draw lists, and merged in order into the current window's draw list.
+    static void TessellateParallel(const DeferredRenderer& source, ImGuiRenderer& target, ImVec2 offset, int32_t from, int32_t to)
+    {
+        auto& dl = *ImGui::GetWindowDrawList();
+        auto font = ImGui::GetFont();
+        auto fontsz = target.CurrentFontSize();
+        auto clip = dl._CmdHeader.ClipRect;
+        auto texture = dl._CmdHeader.TextureId;
+        auto chunksz = std::max(256, (to - from) / ((GLIMMER_TESSELLATION_THREADS + 1) * 2));
+        auto count = 0, depth = 0;
+        auto serial = false;
+
+        auto addChunk = [&](int32_t start, int32_t end) {
+            if (count == (int32_t)TessellationChunks.size())
+                TessellationChunks.emplace_back(std::make_unique<TessellationChunk>());
+
+            auto& chunk = *TessellationChunks[count++];
+            chunk.from = start; chunk.to = end; chunk.serial = serial;
+
+            ImVector<ImVec2> scratch;
+            scratch.swap(chunk.shared.TempBuffer);
+            chunk.shared = *ImGui::GetDrawListSharedData();
+            chunk.shared.TempBuffer.swap(scratch);
+            chunk.dl._ResetForNewFrame();
+            chunk.dl.Flags = dl.Flags;
+            chunk.dl.PushClipRect({ clip.x, clip.y }, { clip.z, clip.w });
+            chunk.dl.PushTextureID(texture);
+            chunk.renderer.Detach(&chunk.dl, font, fontsz);
+        };
+
+        auto start = from;
+        for (auto idx = from; idx < to; ++idx)
+        {
+            switch (source.queue[idx].first)
+            {
+            case DrawingOps::PushClippingRect: case DrawingOps::PushFont: ++depth; break;
+            case DrawingOps::PopClippingRect: case DrawingOps::PopFont: --depth; break;
+            case DrawingOps::SVG: case DrawingOps::Image: case DrawingOps::Tooltip: serial = true; break;
+            default: break;
+            }
+
+            if (depth <= 0 && (idx + 1 - start) >= chunksz)
+            {
+                addChunk(start, idx + 1);
+                start = idx + 1;
+                serial = false;
+            }
+        }
+
+        if (start < to) addChunk(start, to);
+
+        TessellationJob job{ &source, TessellationChunks.data(), offset };
+        Tessellators().Run(count, &TessellateChunk, &job);
+
+        auto prevdl = target.UserData;
+        target.UserData = &dl;
+
+        for (auto idx = 0; idx < count; ++idx)
+        {
+            auto& chunk = *TessellationChunks[idx];
+
+            if (chunk.serial) source.Replay(target, offset, chunk.from, chunk.to);
+            else
+            {
+                MergeDrawList(dl, chunk.dl);
+                target.stats.vertices += chunk.renderer.stats.vertices;
+                target.stats.indices += chunk.renderer.stats.indices;
+                target.stats.arcs += chunk.renderer.stats.arcs;
+                target.stats.arcSegments += chunk.renderer.stats.arcSegments;
+            }
+        }
+
+        target.UserData = prevdl;
+    }
+
 #pragma endregion
 
     IRenderer* CreateDeferredRenderer(TextMeasureFuncT tmfunc)
@@ -1878,14 +1990,19 @@ namespace glimmer
         return &renderer;
     }
 
+    IRenderer* CreateRetainedRenderer(TextMeasureFuncT tmfunc)
+    {
+        return new DeferredRenderer{ tmfunc, true };
+    }
+
     IRenderer* CreateImGuiRenderer()
     {
         static thread_local ImGuiRenderer renderer{};
         return &renderer;
     }
 
-    IRenderer* CreateSVGRenderer(TextMeasureFuncT tmfunc, ImVec2 dimensions)
+    IRenderer* CreateSVGRenderer(TextMeasureFuncT tmfunc, ImVec2 dimensions, SVGSinkT sink, void* userdata)
     {
-        return new SVGRenderer(tmfunc, dimensions);
+        return new SVGRenderer(tmfunc, dimensions, sink, userdata);
     }
 }
\ No newline at end of file
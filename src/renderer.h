@@ -4,14 +4,52 @@
 
 #include "im_font_manager.h"
 
+// Maximum distance (in pixels) between a tessellated arc and the true circle
+#ifndef GLIMMER_ARC_MAX_ERROR
+#define GLIMMER_ARC_MAX_ERROR 0.3f
+#endif
+
+// Resolution of the shared unit-circle table, a multiple of 360 keeps degree angles exact
+#ifndef GLIMMER_ARC_TABLE_SZ
+#define GLIMMER_ARC_TABLE_SZ 720
+#endif
+
+// Deferred ranges with at least this many commands are tessellated on worker threads
+// when UIConfig::parallelTessellation is set
+#ifndef GLIMMER_PARALLEL_TESSELLATION_MIN
+#define GLIMMER_PARALLEL_TESSELLATION_MIN 4096
+#endif
+
+// Worker threads used for tessellation, in addition to the thread which renders the frame
+#ifndef GLIMMER_TESSELLATION_THREADS
+#define GLIMMER_TESSELLATION_THREADS 3
+#endif
+
+// Buffered SVG output is handed to the sink once it grows beyond this size
+#ifndef GLIMMER_SVG_FLUSH_SZ
+#define GLIMMER_SVG_FLUSH_SZ (1 << 16)
+#endif
+
 namespace glimmer
 {
+    // Geometry emitted by a renderer, reset by the owner once per frame
+    struct RendererStats
+    {
+        int32_t vertices = 0;
+        int32_t indices = 0;
+        int32_t arcs = 0;
+        int32_t arcSegments = 0;
+    };
+
     // Implement this to draw primitives in your favorite graphics API
     // TODO: Separate gradient creation vs. drawing
     struct IRenderer
     {
         void* UserData = nullptr;
         ImVec2 size{ 0.f, 0.f };
+        RendererStats stats;
+
+        virtual ~IRenderer() = default;
 
         virtual void SetClipRect(ImVec2 startpos, ImVec2 endpos, bool intersect = true) = 0;
         virtual void ResetClipRect() = 0;
@@ -48,6 +86,9 @@ namespace glimmer
         virtual void Render(IRenderer& renderer, ImVec2 offset, int from = 0, int to = -1) {}
         virtual int TotalEnqueued() const { return 0; }
         virtual void Reset() {}
+
+        // Completes the document of serializing renderers, returns the output unless it was streamed to a sink
+        virtual std::string_view Finalize() { return {}; }
     };
 
     // =============================================================================================
@@ -59,5 +100,16 @@ namespace glimmer
     ImVec2 ImGuiMeasureText(std::string_view text, void* fontptr, float sz, float wrapWidth);
 
     IRenderer* CreateDeferredRenderer(TextMeasureFuncT tmfunc);
+
+    // Deferred renderer owned by the caller whose commands (and their text) are kept across frames
+    // until Reset, for content which is recorded once and replayed at varying offsets
+    IRenderer* CreateRetainedRenderer(TextMeasureFuncT tmfunc);
     IRenderer* CreateImGuiRenderer();
+
+    // Receives SVG output in chunks as it is produced, userdata is passed through as-is
+    using SVGSinkT = void(*)(std::string_view chunk, void* userdata);
+    void WriteSVGToFile(std::string_view chunk, void* file);
+
+    // Without a sink the complete document is kept in memory and returned by Finalize
+    IRenderer* CreateSVGRenderer(TextMeasureFuncT tmfunc, ImVec2 dimensions, SVGSinkT sink = nullptr, void* userdata = nullptr);
 }
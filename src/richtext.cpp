@@ -0,0 +1,434 @@
+#include "richtext.h"
+#include "context.h"
+#include "renderer.h"
+
+#include <cctype>
+#include <unordered_map>
+
+namespace glimmer
+{
+    struct RichTextStyle
+    {
+        std::string_view tag;
+        std::string_view family;
+        void* font = nullptr;
+        float size = 0.f;
+        int32_t flags = 0;
+        uint32_t color = 0;
+        bool hasColor = false;
+    };
+
+    struct RichTextCache
+    {
+        // Colliding hashes keep separate entries, nodes are stable so content drawn in the
+        // current frame stays valid while other entries are inserted
+        std::unordered_multimap<uint64_t, RichTextContent> entries;
+        uint64_t tick = 0, frame = 1;
+    };
+
+    static thread_local RichTextCache TextCache;
+
+#pragma region Parsing
+
+    static void ResolveFont(RichTextStyle& style)
+    {
+        FontStyle font;
+        font.family = style.family;
+        font.size = style.size;
+        font.flags = style.flags;
+        font.font = nullptr;
+        AddFontPtr(font);
+        if (font.font != nullptr) style.font = font.font;
+    }
+
+    static std::string_view GetAttribute(std::string_view attrs, std::string_view name)
+    {
+        auto pos = attrs.find(name);
+
+        while (pos != std::string_view::npos)
+        {
+            auto idx = pos + name.size();
+            while (idx < attrs.size() && std::isspace((unsigned char)attrs[idx])) idx++;
+
+            if (idx < attrs.size() && attrs[idx] == '=' && (pos == 0 || std::isspace((unsigned char)attrs[pos - 1])))
+            {
+                idx++;
+                while (idx < attrs.size() && std::isspace((unsigned char)attrs[idx])) idx++;
+                if (idx >= attrs.size()) break;
+
+                auto quote = attrs[idx];
+                if (quote == '"' || quote == '\'')
+                {
+                    auto end = attrs.find(quote, idx + 1);
+                    return end == std::string_view::npos ? attrs.substr(idx + 1) : attrs.substr(idx + 1, end - idx - 1);
+                }
+
+                auto end = idx;
+                while (end < attrs.size() && !std::isspace((unsigned char)attrs[end])) end++;
+                return attrs.substr(idx, end - idx);
+            }
+
+            pos = attrs.find(name, pos + 1);
+        }
+
+        return {};
+    }
+
+    static void ApplyTag(RichTextStyle& style, std::string_view tag, std::string_view attrs)
+    {
+        auto prevflags = style.flags;
+
+        if (tag == "b" || tag == "strong") style.flags |= FontStyleBold;
+        else if (tag == "i" || tag == "em") style.flags |= FontStyleItalics;
+        else if (tag == "u") style.flags |= FontStyleUnderline;
+        else if (tag == "s" || tag == "strike" || tag == "del") style.flags |= FontStyleStrikethrough;
+        else if (tag == "span")
+        {
+            auto css = GetAttribute(attrs, "style");
+            if (css.empty()) return;
+
+            StyleDescriptor parsed;
+            parsed.font.family = style.family;
+            parsed.font.size = style.size;
+            parsed.font.flags = style.flags;
+            parsed.font.font = style.font;
+            parsed.fgcolor = style.color;
+            parsed.From(css, false);
+
+            if (parsed.specified & StyleFgColor)
+            {
+                style.color = parsed.fgcolor;
+                style.hasColor = true;
+            }
+
+            auto fontChanged = parsed.font.family != style.family || parsed.font.size != style.size;
+            style.family = parsed.font.family;
+            style.size = parsed.font.size;
+            style.flags = parsed.font.flags;
+            if (fontChanged) style.font = nullptr;
+        }
+        else return;
+
+        constexpr int32_t FontSelection = FontStyleBold | FontStyleItalics | FontStyleLight;
+        if (style.font == nullptr || ((prevflags ^ style.flags) & FontSelection) != 0)
+            ResolveFont(style);
+    }
+
+    static void ParseRichText(RichTextContent& content, const FontStyle& font)
+    {
+        FixedSizeStack<RichTextStyle, GLIMMER_RICHTEXT_MAX_NESTING> stack;
+        auto& base = stack.push();
+        base.family = font.family;
+        base.font = font.font;
+        base.size = font.size;
+        base.flags = font.flags;
+
+        std::string_view source = content.source;
+        auto& text = content.text;
+        auto spanStart = 0, overflow = 0;
+
+        auto pushSpan = [&](int32_t offset, int32_t length, bool newline) {
+            const auto& style = stack.top();
+            auto& span = content.spans.emplace_back();
+            span.offset = offset;
+            span.length = length;
+            span.font = style.font;
+            span.size = style.size;
+            span.flags = style.flags;
+            span.color = style.color;
+            span.hasColor = style.hasColor;
+            span.newline = newline;
+        };
+
+        auto addSpan = [&](bool newline) {
+            auto length = (int32_t)text.size() - spanStart;
+            if (length > 0) pushSpan(spanStart, length, false);
+            if (newline) pushSpan((int32_t)text.size(), 0, true);
+            spanStart = (int32_t)text.size();
+        };
+
+        for (size_t idx = 0; idx < source.size();)
+        {
+            auto ch = source[idx];
+
+            if (ch == '<')
+            {
+                auto closing = (idx + 1 < source.size()) && source[idx + 1] == '/';
+                auto begin = idx + (closing ? 2 : 1), nameEnd = begin;
+                while (nameEnd < source.size() && std::isalnum((unsigned char)source[nameEnd])) nameEnd++;
+                auto tagEnd = nameEnd < source.size() ? source.find('>', nameEnd) : std::string_view::npos;
+
+                if (nameEnd > begin && tagEnd != std::string_view::npos)
+                {
+                    auto tag = source.substr(begin, nameEnd - begin);
+                    auto attrs = source.substr(nameEnd, tagEnd - nameEnd);
+                    auto selfClosing = !attrs.empty() && attrs.back() == '/';
+                    idx = tagEnd + 1;
+
+                    if (tag == "br")
+                    {
+                        addSpan(true);
+                        continue;
+                    }
+
+                    addSpan(false);
+
+                    if (closing)
+                    {
+                        if (overflow > 0) { overflow--; continue; }
+
+                        for (auto depth = stack.size() - 1; depth > 0; --depth)
+                            if (stack[depth].tag == tag)
+                            {
+                                stack.pop((int16_t)(stack.size() - depth), false);
+                                break;
+                            }
+                    }
+                    else if (!selfClosing)
+                    {
+                        if (stack.size() == GLIMMER_RICHTEXT_MAX_NESTING) { overflow++; continue; }
+
+                        auto next = stack.top();
+                        next.tag = tag;
+                        ApplyTag(next, tag, attrs);
+                        stack.push() = next;
+                    }
+
+                    continue;
+                }
+            }
+            else if (ch == '&')
+            {
+                auto end = source.find(';', idx);
+                auto entity = end != std::string_view::npos && end - idx <= 6 ? source.substr(idx, end - idx + 1) :
+                    std::string_view{};
+                char decoded = entity == "&amp;" ? '&' : entity == "&lt;" ? '<' : entity == "&gt;" ? '>' :
+                    entity == "&quot;" ? '"' : entity == "&apos;" ? '\'' : entity == "&nbsp;" ? ' ' : 0;
+
+                if (decoded != 0)
+                {
+                    text.push_back(decoded);
+                    idx = end + 1;
+                    continue;
+                }
+            }
+            else if (ch == '\n')
+            {
+                addSpan(true);
+                idx++;
+                continue;
+            }
+
+            text.push_back(ch);
+            idx++;
+        }
+
+        addSpan(false);
+    }
+
+    // Deferred renderers keep views into the decoded text until they are flushed, so content
+    // used in the current frame is never evicted. The cache may exceed its size for a frame.
+    static void Evict(RichTextCache& cache, bool all)
+    {
+        for (auto it = cache.entries.begin(); it != cache.entries.end();)
+        {
+            auto stale = all || it->second.lastUse + (GLIMMER_RICHTEXT_CACHE_SZ / 2) < cache.tick;
+            if (stale && it->second.lastFrame != cache.frame) it = cache.entries.erase(it);
+            else ++it;
+        }
+    }
+
+    static RichTextContent& GetContent(std::string_view text, const FontStyle& font)
+    {
+        auto& cache = TextCache;
+        auto key = (uint64_t)std::hash<std::string_view>{}(text);
+        key ^= ((uint64_t)(uintptr_t)font.font + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2));
+        key ^= ((uint64_t)std::hash<float>{}(font.size) + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2));
+        key ^= ((uint64_t)font.flags + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2));
+        cache.tick++;
+
+        auto [first, last] = cache.entries.equal_range(key);
+        for (auto it = first; it != last; ++it)
+        {
+            auto& existing = it->second;
+            if (existing.source == text && existing.basefont == font.font &&
+                existing.basesz == font.size && existing.baseflags == font.flags)
+            {
+                existing.lastUse = cache.tick;
+                existing.lastFrame = cache.frame;
+                return existing;
+            }
+        }
+
+        if (cache.entries.size() >= GLIMMER_RICHTEXT_CACHE_SZ)
+        {
+            Evict(cache, false);
+            if (cache.entries.size() >= GLIMMER_RICHTEXT_CACHE_SZ) Evict(cache, true);
+        }
+
+        auto& content = cache.entries.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+            std::forward_as_tuple())->second;
+        content.source.assign(text.data(), text.size());
+        content.basefont = font.font;
+        content.basesz = font.size;
+        content.baseflags = font.flags;
+        content.lastUse = cache.tick;
+        content.lastFrame = cache.frame;
+        ParseRichText(content, font);
+        return content;
+    }
+
+#pragma endregion
+
+#pragma region Line layout
+
+    static void BuildLayout(const RichTextContent& content, RichTextLayout& layout, float width, IRenderer& renderer)
+    {
+        std::string_view text = content.text;
+        layout.runs.clear();
+        layout.width = width;
+        layout.size = ImVec2{};
+
+        float x = 0.f, y = 0.f, lineh = 0.f;
+        auto lineStart = 0;
+
+        auto finishLine = [&] {
+            for (auto ridx = lineStart; ridx < (int)layout.runs.size(); ++ridx)
+                layout.runs[ridx].pos.y = y + (lineh - layout.runs[ridx].size.y);
+            layout.size.x = std::max(layout.size.x, x);
+            y += lineh;
+            x = lineh = 0.f;
+            lineStart = (int)layout.runs.size();
+        };
+
+        for (auto sidx = 0; sidx < (int)content.spans.size(); ++sidx)
+        {
+            const auto& span = content.spans[sidx];
+
+            if (span.newline)
+            {
+                if (lineh == 0.f) lineh = span.size;
+                finishLine();
+                continue;
+            }
+
+            auto pos = span.offset, end = span.offset + span.length;
+
+            while (pos < end)
+            {
+                // Words carry their trailing spaces, only the visible part has to fit
+                auto wordEnd = pos;
+                while (wordEnd < end && !std::isspace((unsigned char)text[wordEnd])) wordEnd++;
+                auto visibleEnd = wordEnd;
+                while (wordEnd < end && std::isspace((unsigned char)text[wordEnd])) wordEnd++;
+
+                auto visible = renderer.GetTextSize(text.substr(pos, visibleEnd - pos), span.font, span.size);
+                auto wordsz = visibleEnd == wordEnd ? visible :
+                    renderer.GetTextSize(text.substr(pos, wordEnd - pos), span.font, span.size);
+                wordsz.y = std::max(wordsz.y, span.size);
+
+                if (width > 0.f && x > 0.f && (x + visible.x) > width)
+                    finishLine();
+
+                auto merge = (int)layout.runs.size() > lineStart && layout.runs.back().span == sidx &&
+                    (layout.runs.back().offset + layout.runs.back().length) == pos;
+
+                if (merge)
+                {
+                    auto& last = layout.runs.back();
+                    last.length += wordEnd - pos;
+                    last.size.x += wordsz.x;
+                    last.size.y = std::max(last.size.y, wordsz.y);
+                }
+                else
+                {
+                    auto& run = layout.runs.emplace_back();
+                    run.span = sidx;
+                    run.offset = pos;
+                    run.length = wordEnd - pos;
+                    run.pos = ImVec2{ x, 0.f };
+                    run.size = wordsz;
+                }
+
+                x += wordsz.x;
+                lineh = std::max(lineh, wordsz.y);
+                pos = wordEnd;
+            }
+        }
+
+        if ((int)layout.runs.size() > lineStart || lineh > 0.f) finishLine();
+        layout.size.y = y;
+    }
+
+    static std::pair<RichTextContent*, RichTextLayout*> GetLayout(std::string_view text, const FontStyle& font, float width, IRenderer& renderer)
+    {
+        auto& content = GetContent(text, font);
+        auto& cache = TextCache;
+        width = width > 0.f ? width : -1.f;
+        RichTextLayout* oldest = &content.layouts[0];
+
+        for (auto& layout : content.layouts)
+        {
+            if (layout.lastUse != 0 && layout.width == width)
+            {
+                layout.lastUse = cache.tick;
+                return { &content, &layout };
+            }
+
+            if (layout.lastUse < oldest->lastUse) oldest = &layout;
+        }
+
+        BuildLayout(content, *oldest, width, renderer);
+        oldest->lastUse = cache.tick;
+        return { &content, oldest };
+    }
+
+#pragma endregion
+
+    const RichTextContent& ParseRichText(std::string_view text, const FontStyle& font)
+    {
+        return GetContent(text, font);
+    }
+
+    const RichTextLayout& LayoutRichText(std::string_view text, const FontStyle& font, float width, IRenderer& renderer)
+    {
+        return *GetLayout(text, font, width, renderer).second;
+    }
+
+    ImVec2 MeasureRichText(std::string_view text, const FontStyle& font, float width, IRenderer& renderer)
+    {
+        return GetLayout(text, font, width, renderer).second->size;
+    }
+
+    void DrawRichText(std::string_view text, ImVec2 pos, float width, const FontStyle& font, uint32_t color, IRenderer& renderer)
+    {
+        auto [content, layout] = GetLayout(text, font, width, renderer);
+        std::string_view decoded = content->text;
+
+        for (const auto& run : layout->runs)
+        {
+            const auto& span = content->spans[run.span];
+            auto fgcolor = span.hasColor ? span.color : color;
+            auto runpos = pos + run.pos;
+
+            auto pushed = renderer.SetCurrentFont(span.font, span.size);
+            renderer.DrawText(decoded.substr(run.offset, run.length), runpos, fgcolor);
+            if (pushed) renderer.ResetFont();
+
+            if (span.flags & FontStyleUnderline)
+                renderer.DrawLine(runpos + ImVec2{ 0.f, run.size.y - 1.f }, runpos + ImVec2{ run.size.x, run.size.y - 1.f }, fgcolor, 1.f);
+            if (span.flags & FontStyleStrikethrough)
+                renderer.DrawLine(runpos + ImVec2{ 0.f, run.size.y * 0.55f }, runpos + ImVec2{ run.size.x, run.size.y * 0.55f }, fgcolor, 1.f);
+        }
+    }
+
+    void ClearRichTextCache()
+    {
+        Evict(TextCache, true);
+    }
+
+    void EndRichTextFrame()
+    {
+        TextCache.frame++;
+    }
+}
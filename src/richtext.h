@@ -0,0 +1,83 @@
+#pragma once
+
+#include "types.h"
+#include "style.h"
+
+#include <string>
+#include <vector>
+
+// Maximum nesting depth of rich text markup tags
+#ifndef GLIMMER_RICHTEXT_MAX_NESTING
+#define GLIMMER_RICHTEXT_MAX_NESTING 32
+#endif
+
+// Number of parsed rich text contents kept per thread
+#ifndef GLIMMER_RICHTEXT_CACHE_SZ
+#define GLIMMER_RICHTEXT_CACHE_SZ 512
+#endif
+
+// Number of line layouts (distinct wrap widths) kept per parsed content
+#ifndef GLIMMER_RICHTEXT_MAX_LAYOUTS
+#define GLIMMER_RICHTEXT_MAX_LAYOUTS 4
+#endif
+
+namespace glimmer
+{
+    struct IRenderer;
+
+    // Run of decoded text sharing one style, a zero length span with newline set is a forced line break
+    struct RichTextSpan
+    {
+        int32_t offset = 0, length = 0;
+        void* font = nullptr;
+        float size = 0.f;
+        uint32_t color = 0;
+        int32_t flags = 0; // FontStyleUnderline, FontStyleStrikethrough, ...
+        bool hasColor = false; // Otherwise inherits the foreground color at draw time
+        bool newline = false;
+    };
+
+    // Positioned piece of a span on a laid out line, position is relative to the text origin
+    struct RichTextRun
+    {
+        int32_t span = 0;
+        int32_t offset = 0, length = 0;
+        ImVec2 pos;
+        ImVec2 size;
+    };
+
+    struct RichTextLayout
+    {
+        float width = -1.f;
+        uint64_t lastUse = 0;
+        ImVec2 size;
+        std::vector<RichTextRun> runs;
+    };
+
+    // Stage one output: markup parsed into spans over the entity-decoded text
+    struct RichTextContent
+    {
+        std::string source;
+        void* basefont = nullptr;
+        float basesz = 0.f;
+        int32_t baseflags = 0;
+
+        std::string text;
+        std::vector<RichTextSpan> spans;
+        RichTextLayout layouts[GLIMMER_RICHTEXT_MAX_LAYOUTS];
+        uint64_t lastUse = 0;
+        uint64_t lastFrame = 0; // Drawn text is referenced by deferred renderers until the frame ends
+    };
+
+    // Supports <b>, <strong>, <i>, <em>, <u>, <s>, <strike>, <del>, <br> and <span style="...">
+    // with the CSS properties understood by StyleDescriptor. Both parsed spans and line layouts
+    // are cached, repeated calls with the same content and width do not re-parse or re-measure.
+    [[nodiscard]] const RichTextContent& ParseRichText(std::string_view text, const FontStyle& font);
+    [[nodiscard]] const RichTextLayout& LayoutRichText(std::string_view text, const FontStyle& font, float width, IRenderer& renderer);
+    [[nodiscard]] ImVec2 MeasureRichText(std::string_view text, const FontStyle& font, float width, IRenderer& renderer);
+    void DrawRichText(std::string_view text, ImVec2 pos, float width, const FontStyle& font, uint32_t color, IRenderer& renderer);
+    // Drops cached content which is not used in the current frame
+    void ClearRichTextCache();
+    // Called once per frame after rendering, content of past frames becomes evictable
+    void EndRichTextFrame();
+}
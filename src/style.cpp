@@ -316,7 +316,7 @@ namespace glimmer
         }
         else if (NamedColor != nullptr)
         {
-            static char buffer[32] = { 0 };
+            static thread_local char buffer[32] = { 0 };
             memset(buffer, 0, 32);
             memcpy(buffer, stylePropVal.data(), std::min((int)stylePropVal.size(), 31));
             return NamedColor(buffer, userData);
@@ -1056,6 +1056,12 @@ namespace glimmer
                 (int)stylePropVal.size(), stylePropVal.data());
             prop = StyleFontStyle;
         }
+        else if (AreSame(stylePropName, "text-decoration") || AreSame(stylePropName, "text-decoration-line"))
+        {
+            if (stylePropVal.find("underline") != std::string_view::npos) style.font.flags |= FontStyleUnderline;
+            if (stylePropVal.find("line-through") != std::string_view::npos) style.font.flags |= FontStyleStrikethrough;
+            prop = StyleFontStyle;
+        }
         else if (AreSame(stylePropName, "box-shadow"))
         {
             style.shadow = ExtractBoxShadow(stylePropVal, Config.defaultFontSz, 1.f, GetColor, Config.userData);
@@ -1275,6 +1281,7 @@ namespace glimmer
     void PushStyle(std::string_view defcss, std::string_view hovercss, std::string_view pressedcss,
         std::string_view focusedcss, std::string_view checkedcss, std::string_view disblcss)
     {
+        AllocationTagScope tag{ AT_Style };
         std::string_view css[WSI_Total] = { defcss, focusedcss, hovercss, pressedcss, checkedcss, "", "", "", disblcss };
         auto& context = GetContext();
         
@@ -1299,7 +1306,7 @@ namespace glimmer
 
     void PushStyleFmt(WidgetState state, std::string_view fmt, ...)
     {
-        static char buffer[4096] = { 0 };
+        static thread_local char buffer[4096] = { 0 };
 
         std::memset(buffer, 0, 4096);
         va_list args;
@@ -1313,6 +1320,7 @@ namespace glimmer
 
     void PushStyle(WidgetState state, std::string_view css)
     {
+        AllocationTagScope tag{ AT_Style };
         auto idx = log2((unsigned)state);
         auto& context = GetContext();
 
@@ -1333,6 +1341,7 @@ namespace glimmer
 
     void PopStyle(int depth, int32_t state)
     {
+        AllocationTagScope tag{ AT_Style };
         auto& context = GetContext();
 
         if (!context.layouts.empty())
@@ -0,0 +1,352 @@
+#include "timeseries.h"
+#include "libs/inc/implot/implot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <bit>
+#include <string>
+
+namespace glimmer
+{
+    static thread_local std::vector<double> CandidateXs, CandidateYs;
+    static thread_local std::vector<double> StreamXs, StreamYs;
+
+    // ImPlot takes labels as C strings, a string_view need not be null-terminated
+    static const char* PlotLabel(std::string_view label)
+    {
+        static thread_local std::string buffer;
+        buffer.assign(label.data(), label.size());
+        return buffer.c_str();
+    }
+
+#pragma region Pyramid
+
+    static void MergeSummary(const std::vector<double>& ys, std::vector<TimeSeries::Summary>& level,
+        int32_t block, TimeSeries::Summary summary)
+    {
+        if ((int32_t)level.size() <= block)
+        {
+            level.push_back(summary);
+            return;
+        }
+
+        auto& existing = level[block];
+        if (ys[summary.min] < ys[existing.min]) existing.min = summary.min;
+        if (ys[summary.max] > ys[existing.max]) existing.max = summary.max;
+    }
+
+    void TimeSeries::Append(double x, double y)
+    {
+        assert(xs.empty() || x >= xs.back());
+
+        auto idx = (int32_t)xs.size();
+        xs.push_back(x);
+        ys.push_back(y);
+        MergeSummary(ys, levels[0], idx / GLIMMER_SERIES_BLOCK_SZ, { idx, idx });
+
+        // A block is folded into the level above once it is complete, level L is touched
+        // once every BLOCK_SZ^L appends which keeps appending amortized O(1)
+        int64_t span = GLIMMER_SERIES_BLOCK_SZ;
+        for (auto level = 0; level + 1 < GLIMMER_SERIES_MAX_LEVELS && ((int64_t)idx + 1) % span == 0; ++level)
+        {
+            span *= GLIMMER_SERIES_BLOCK_SZ;
+            MergeSummary(ys, levels[level + 1], (int32_t)(idx / span), levels[level].back());
+        }
+    }
+
+    void TimeSeries::Append(const double* x, const double* y, int32_t count)
+    {
+        Reserve(size() + count);
+        for (auto idx = 0; idx < count; ++idx)
+            Append(x[idx], y[idx]);
+    }
+
+    void TimeSeries::Clear()
+    {
+        xs.clear();
+        ys.clear();
+        for (auto& level : levels) level.clear();
+    }
+
+    void TimeSeries::Reserve(int32_t count)
+    {
+        xs.reserve(count);
+        ys.reserve(count);
+        levels[0].reserve(count / GLIMMER_SERIES_BLOCK_SZ + 1);
+    }
+
+    // Extremes of the points in [from, to), walks up to the largest complete pyramid block
+    // aligned at the cursor and back down near the end of the range
+    static TimeSeries::Summary RangeMinMax(const TimeSeries& series, int32_t from, int32_t to)
+    {
+        TimeSeries::Summary result{ from, from };
+
+        while (from < to)
+        {
+            auto level = -1;
+            int64_t span = 1;
+
+            for (int64_t next = GLIMMER_SERIES_BLOCK_SZ; level + 1 < GLIMMER_SERIES_MAX_LEVELS &&
+                (from % next) == 0 && from + next <= to; next *= GLIMMER_SERIES_BLOCK_SZ)
+            {
+                ++level;
+                span = next;
+            }
+
+            TimeSeries::Summary block = level < 0 ? TimeSeries::Summary{ from, from } :
+                series.levels[level][from / span];
+            if (series.ys[block.min] < series.ys[result.min]) result.min = block.min;
+            if (series.ys[block.max] > series.ys[result.max]) result.max = block.max;
+            from += (int32_t)span;
+        }
+
+        return result;
+    }
+
+#pragma endregion
+
+#pragma region Decimation
+
+    static void EmitPoint(const TimeSeries& series, int32_t idx, int32_t& last,
+        std::vector<double>& outx, std::vector<double>& outy)
+    {
+        if (idx == last) return;
+        outx.push_back(series.xs[idx]);
+        outy.push_back(series.ys[idx]);
+        last = idx;
+    }
+
+    // Each bucket contributes its minimum and maximum in x order, the range end points are kept
+    static void DownsampleMinMax(const TimeSeries& series, int32_t from, int32_t to, int32_t count,
+        std::vector<double>& outx, std::vector<double>& outy)
+    {
+        auto buckets = std::max(1, (count - 2) / 2);
+        auto total = (int64_t)(to - from);
+        auto last = -1;
+        outx.reserve(count);
+        outy.reserve(count);
+
+        EmitPoint(series, from, last, outx, outy);
+
+        for (auto bucket = 0; bucket < buckets; ++bucket)
+        {
+            auto start = from + (int32_t)(total * bucket / buckets);
+            auto end = from + (int32_t)(total * (bucket + 1) / buckets);
+            if (start >= end) continue;
+
+            auto extremes = RangeMinMax(series, start, end);
+            EmitPoint(series, std::min(extremes.min, extremes.max), last, outx, outy);
+            EmitPoint(series, std::max(extremes.min, extremes.max), last, outx, outy);
+        }
+
+        EmitPoint(series, to - 1, last, outx, outy);
+    }
+
+    static void DownsampleLTTB(const double* xs, const double* ys, int32_t size, int32_t count,
+        std::vector<double>& outx, std::vector<double>& outy)
+    {
+        outx.reserve(count);
+        outy.reserve(count);
+        outx.push_back(xs[0]);
+        outy.push_back(ys[0]);
+
+        // First and last points are fixed, the rest are split into count - 2 buckets
+        auto every = (double)(size - 2) / (double)(count - 2);
+        auto selected = 0;
+
+        for (auto bucket = 0; bucket < count - 2; ++bucket)
+        {
+            auto start = (int32_t)(bucket * every) + 1;
+            auto end = std::min((int32_t)((bucket + 1) * every) + 1, size - 1);
+            auto nextStart = end;
+            auto nextEnd = std::min((int32_t)((bucket + 2) * every) + 1, size);
+
+            auto avgx = 0.0, avgy = 0.0;
+            for (auto idx = nextStart; idx < nextEnd; ++idx) { avgx += xs[idx]; avgy += ys[idx]; }
+            auto span = std::max(1, nextEnd - nextStart);
+            avgx /= (double)span; avgy /= (double)span;
+
+            auto maxarea = -1.0;
+            auto next = start;
+
+            for (auto idx = start; idx < end; ++idx)
+            {
+                auto area = std::fabs((xs[selected] - avgx) * (ys[idx] - ys[selected]) -
+                    (xs[selected] - xs[idx]) * (avgy - ys[selected]));
+                if (area > maxarea) { maxarea = area; next = idx; }
+            }
+
+            outx.push_back(xs[next]);
+            outy.push_back(ys[next]);
+            selected = next;
+        }
+
+        outx.push_back(xs[size - 1]);
+        outy.push_back(ys[size - 1]);
+    }
+
+    void TimeSeries::Downsample(double xmin, double xmax, int32_t count, DownsampleMethod method,
+        std::vector<double>& outx, std::vector<double>& outy) const
+    {
+        outx.clear();
+        outy.clear();
+        if (xs.empty() || count <= 0) return;
+
+        auto from = (int32_t)(std::lower_bound(xs.begin(), xs.end(), xmin) - xs.begin());
+        auto to = (int32_t)(std::upper_bound(xs.begin(), xs.end(), xmax) - xs.begin());
+        from = std::max(0, from - 1);
+        to = std::min(size(), to + 1);
+
+        if (to - from <= std::max(count, 4))
+        {
+            outx.assign(xs.begin() + from, xs.begin() + to);
+            outy.assign(ys.begin() + from, ys.begin() + to);
+            return;
+        }
+
+        count = std::max(count, 4);
+
+        if (method == DownsampleMethod::MinMax)
+            DownsampleMinMax(*this, from, to, count, outx, outy);
+        else
+        {
+            // LTTB is linear in its input, run it over min/max candidates from the pyramid
+            // rather than over every point in range
+            CandidateXs.clear();
+            CandidateYs.clear();
+            DownsampleMinMax(*this, from, to, count * 4, CandidateXs, CandidateYs);
+
+            if ((int32_t)CandidateXs.size() <= count)
+            {
+                outx.swap(CandidateXs);
+                outy.swap(CandidateYs);
+            }
+            else
+                DownsampleLTTB(CandidateXs.data(), CandidateYs.data(), (int32_t)CandidateXs.size(),
+                    count, outx, outy);
+        }
+    }
+
+#pragma endregion
+
+#pragma region Streaming
+
+    StreamingSeries::StreamingSeries(int32_t history)
+        : capacity{ std::bit_ceil((uint64_t)std::max(history, 1) * 2u) }, history{ std::max(history, 1) }
+    {
+        samples = std::make_unique<SeriesSample[]>(capacity);
+    }
+
+    bool StreamingSeries::Push(double x, double y)
+    {
+        SeriesSample sample{ x, y };
+        return Push(&sample, 1) == 1;
+    }
+
+    int32_t StreamingSeries::Push(const SeriesSample* source, int32_t count)
+    {
+        auto current = head.load(std::memory_order_relaxed);
+
+        if (current + count - cachedTail > capacity)
+            cachedTail = tail.load(std::memory_order_acquire);
+
+        auto pushed = (int32_t)std::min<uint64_t>(count, capacity - (current - cachedTail));
+        auto mask = capacity - 1;
+
+        for (auto idx = 0; idx < pushed; ++idx)
+            samples[(current + idx) & mask] = source[idx];
+
+        head.store(current + pushed, std::memory_order_release);
+        if (pushed < count) drops.fetch_add(count - pushed, std::memory_order_relaxed);
+        return pushed;
+    }
+
+    StreamingSeriesView StreamingSeries::View() const
+    {
+        auto start = tail.load(std::memory_order_relaxed);
+        auto end = head.load(std::memory_order_acquire);
+        auto from = start & (capacity - 1), count = end - start;
+        StreamingSeriesView view;
+
+        if (from + count <= capacity)
+            view.first = std::span<const SeriesSample>{ samples.get() + from, count };
+        else
+        {
+            view.first = std::span<const SeriesSample>{ samples.get() + from, capacity - from };
+            view.second = std::span<const SeriesSample>{ samples.get(), count - (capacity - from) };
+        }
+
+        return view;
+    }
+
+    void StreamingSeries::Trim(int32_t keep)
+    {
+        auto start = tail.load(std::memory_order_relaxed);
+        auto end = head.load(std::memory_order_acquire);
+        if (end - start > (uint64_t)keep)
+            tail.store(end - keep, std::memory_order_release);
+    }
+
+    static ImPlotPoint StreamingSample(int idx, void* data)
+    {
+        const auto& sample = (*(const StreamingSeriesView*)data)[idx];
+        return ImPlotPoint{ sample.x, sample.y };
+    }
+
+    void PlotStreamingSeries(std::string_view label, StreamingSeries& series, int32_t flags)
+    {
+        series.Trim();
+        auto view = series.View();
+        auto count = std::max(4, (int32_t)(ImPlot::GetPlotSize().x * GLIMMER_SERIES_POINTS_PER_PIXEL));
+        auto total = view.size();
+
+        if (total <= count)
+        {
+            ImPlot::PlotLineG(PlotLabel(label), &StreamingSample, &view, total, flags);
+            return;
+        }
+
+        // Samples are in push order, bucket them by index and keep each bucket's extremes
+        auto buckets = count / 2;
+        StreamXs.clear();
+        StreamYs.clear();
+
+        for (auto bucket = 0; bucket < buckets; ++bucket)
+        {
+            auto start = (int32_t)((int64_t)total * bucket / buckets);
+            auto end = (int32_t)((int64_t)total * (bucket + 1) / buckets);
+            auto min = start, max = start;
+
+            for (auto idx = start + 1; idx < end; ++idx)
+            {
+                if (view[idx].y < view[min].y) min = idx;
+                if (view[idx].y > view[max].y) max = idx;
+            }
+
+            StreamXs.push_back(view[std::min(min, max)].x);
+            StreamYs.push_back(view[std::min(min, max)].y);
+
+            if (min != max)
+            {
+                StreamXs.push_back(view[std::max(min, max)].x);
+                StreamYs.push_back(view[std::max(min, max)].y);
+            }
+        }
+
+        ImPlot::PlotLine(PlotLabel(label), StreamXs.data(), StreamYs.data(), (int)StreamXs.size(), flags);
+    }
+
+#pragma endregion
+
+    void PlotTimeSeries(std::string_view label, const TimeSeries& series, DownsampleMethod method, int32_t flags)
+    {
+        static thread_local std::vector<double> xs, ys;
+
+        auto limits = ImPlot::GetPlotLimits();
+        auto width = ImPlot::GetPlotSize().x;
+        auto count = std::max(4, (int32_t)(width * GLIMMER_SERIES_POINTS_PER_PIXEL));
+        series.Downsample(limits.X.Min, limits.X.Max, count, method, xs, ys);
+        ImPlot::PlotLine(PlotLabel(label), xs.data(), ys.data(), (int)xs.size(), flags);
+    }
+}
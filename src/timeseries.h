@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <span>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+// Fan-out of the min/max pyramid, each summary block covers this many blocks of the level below
+#ifndef GLIMMER_SERIES_BLOCK_SZ
+#define GLIMMER_SERIES_BLOCK_SZ 16
+#endif
+
+// Number of pyramid levels, 16^8 points are more than a series can index
+#ifndef GLIMMER_SERIES_MAX_LEVELS
+#define GLIMMER_SERIES_MAX_LEVELS 8
+#endif
+
+// Points handed to ImPlot per horizontal pixel of the plot area
+#ifndef GLIMMER_SERIES_POINTS_PER_PIXEL
+#define GLIMMER_SERIES_POINTS_PER_PIXEL 2
+#endif
+
+namespace glimmer
+{
+    enum class DownsampleMethod
+    {
+        MinMax, // Keeps the extremes of every pixel column, preserves spikes
+        LTTB    // Largest-Triangle-Three-Buckets over min/max candidates, preserves visual shape
+    };
+
+    // Append-only (x, y) series which keeps a min/max pyramid over its points, so that any
+    // x-range can be reduced to a pixel's worth of points without visiting every point.
+    // x values must be non-decreasing, appending is amortized O(1).
+    struct TimeSeries
+    {
+        struct Summary
+        {
+            int32_t min = -1, max = -1; // point indices of the extremes in the block
+        };
+
+        std::vector<double> xs, ys;
+        std::vector<Summary> levels[GLIMMER_SERIES_MAX_LEVELS];
+
+        void Append(double x, double y);
+        void Append(const double* x, const double* y, int32_t count);
+        void Clear();
+        void Reserve(int32_t count);
+
+        // Reduces the points with x in [xmin, xmax] (plus one neighbor on either side so lines
+        // reach the plot edges) to at most `count` points, output replaces the contents of outx/outy
+        void Downsample(double xmin, double xmax, int32_t count, DownsampleMethod method,
+            std::vector<double>& outx, std::vector<double>& outy) const;
+
+        int32_t size() const { return (int32_t)xs.size(); }
+        bool empty() const { return xs.empty(); }
+    };
+
+    struct SeriesSample
+    {
+        double x = 0.0, y = 0.0;
+    };
+
+    // Contents of a StreamingSeries in push order, the ring may wrap so it is made of two spans
+    struct StreamingSeriesView
+    {
+        std::span<const SeriesSample> first, second;
+
+        int32_t size() const { return (int32_t)(first.size() + second.size()); }
+        bool empty() const { return first.empty() && second.empty(); }
+        const SeriesSample& operator[](int32_t idx) const 
+        { return idx < (int32_t)first.size() ? first[idx] : second[idx - first.size()]; }
+    };
+
+    // Single-producer/single-consumer lock-free ring of samples for real-time charts. One thread
+    // pushes samples and never blocks, samples pushed while the ring is full are dropped and counted.
+    // The UI thread views the samples in place and trims the oldest ones to the requested history.
+    // The ring has room for twice the history, so the producer only drops samples if the consumer
+    // stalls for longer than a history's worth of samples.
+    struct StreamingSeries
+    {
+        explicit StreamingSeries(int32_t history);
+        StreamingSeries(const StreamingSeries&) = delete;
+        StreamingSeries& operator=(const StreamingSeries&) = delete;
+
+        // Producer thread
+        bool Push(double x, double y);
+        int32_t Push(const SeriesSample* samples, int32_t count);
+
+        // Consumer thread, the view stays valid until the next Trim
+        [[nodiscard]] StreamingSeriesView View() const;
+        void Trim(int32_t keep);
+        void Trim() { Trim(history); }
+
+        uint64_t dropped() const { return drops.load(std::memory_order_relaxed); }
+
+        std::unique_ptr<SeriesSample[]> samples;
+        uint64_t capacity = 0;
+        int32_t history = 0;
+
+        // Producer and consumer indices live on separate cache lines, the producer keeps a
+        // cached copy of the consumer's index and only reloads it when the ring looks full
+        alignas(64) std::atomic<uint64_t> head{ 0 };
+        std::atomic<uint64_t> drops{ 0 };
+        uint64_t cachedTail = 0;
+        alignas(64) std::atomic<uint64_t> tail{ 0 };
+    };
+
+    // Plots the series as a line in the current plot (between StartPlot and EndPlot), only about
+    // GLIMMER_SERIES_POINTS_PER_PIXEL points per pixel of the visible x-range reach ImPlot.
+    void PlotTimeSeries(std::string_view label, const TimeSeries& series,
+        DownsampleMethod method = DownsampleMethod::MinMax, int32_t flags = 0);
+
+    // Trims the series to its history and plots it in the current plot, the samples are read in
+    // place from the ring, reduced to per-pixel min/max when there are more than fit the plot
+    void PlotStreamingSeries(std::string_view label, StreamingSeries& series, int32_t flags = 0);
+}
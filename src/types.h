@@ -129,6 +129,7 @@ namespace glimmer
         std::string_view tooltipFontFamily = IM_RICHTEXT_DEFAULT_FONTFAMILY;
         BoxShadowQuality shadowQuality = BoxShadowQuality::Balanced;
         LayoutPolicy layoutPolicy = LayoutPolicy::ImmediateMode;
+        bool parallelTessellation = false; // Tessellate large deferred ranges on worker threads
         IRenderer* renderer = nullptr;
         IPlatform* platform = nullptr;
         int32_t(*GetTotalWidgetCount)(WidgetType) = nullptr;
@@ -155,15 +156,16 @@ namespace glimmer
 
     enum class TextType { PlainText, RichText, SVG, ImagePath, SVGPath };
 
+    // Data common to all widgets, apart from the state flags (WS_*). These are read by every
+    // widget in every frame, and are kept contiguous per widget type (see WidgetConfigData::flags)
     struct CommonWidgetData
     {
-        int32_t state = WS_Default;
         std::string_view tooltip = "";
         float _hoverDuration = 0; // for tooltip, in seconds
         bool floating = false;
     };
 
-    struct ButtonState : public CommonWidgetData
+    struct ButtonState
     {
         std::string_view text;
         TextType type = TextType::PlainText;
@@ -171,7 +173,7 @@ namespace glimmer
 
     using LabelState = ButtonState;
 
-    struct ToggleButtonState : public CommonWidgetData
+    struct ToggleButtonState
     {
         bool checked = false;
     };
@@ -183,14 +185,14 @@ namespace glimmer
         Checked, Unchecked, Partial
     };
 
-    struct CheckboxState : public CommonWidgetData
+    struct CheckboxState
     {
         CheckState check = CheckState::Unchecked;
     };
 
     enum class SpinnerButtonPlacement { VerticalLeft, VerticalRight, EitherSide };
 
-    struct SpinnerState : public CommonWidgetData
+    struct SpinnerState
     {
         float data = 0.f;
         float min = 0.f, max = (float)INT_MAX, delta = 1.f;
@@ -201,7 +203,7 @@ namespace glimmer
         bool isInteger = true;
     };
 
-    struct SliderState : public CommonWidgetData
+    struct SliderState
     {
         float data = 0.f;
         float min = 0.f, max = FLT_MAX, delta = 1.f;
@@ -240,7 +242,7 @@ namespace glimmer
         ScrollBarState state;
     };
 
-    struct TextInputState : public CommonWidgetData
+    struct TextInputState
     {
         std::vector<char> text;
         std::string_view placeholder;
@@ -250,7 +252,7 @@ namespace glimmer
         float overlayHeight = FLT_MAX;
     };
 
-    struct DropDownState : public CommonWidgetData
+    struct DropDownState
     {
         std::string_view text;
         Direction dir;
@@ -353,7 +355,58 @@ namespace glimmer
         bool newTab = false;
     };
 
-    struct ItemGridState : public CommonWidgetData
+    // Key of a cell used to order rows, rows compare by number first and then by text
+    struct ItemGridSortKey
+    {
+        double number = 0.0;
+        std::string_view text;
+    };
+
+    struct ItemGridSortColumn
+    {
+        int16_t col = -1;
+        bool ascending = true;
+    };
+
+    enum class ItemGridFilterType
+    {
+        None,     // Removes the column's filter
+        Contains, // Cell text contains `text`
+        Prefix,   // Cell text starts with `text`
+        Range,    // Cell number lies in [min, max]
+        OneOf     // Cell text (or number, if it has no text) is one of `values`
+    };
+
+    struct ItemGridFilter
+    {
+        ItemGridFilterType type = ItemGridFilterType::None;
+        std::string_view text;
+        double min = -DBL_MAX, max = DBL_MAX;
+        std::vector<ItemGridSortKey> values;
+        bool caseSensitive = false;
+    };
+
+    enum class ItemGridCellKind
+    {
+        Widget, // Cells are built by cellprops/celldata
+        Text,   // Plain text cells drawn by the grid
+        Number  // Numeric cells formatted and drawn by the grid
+    };
+
+    // Contents of one column for a block of rows, requested from ItemGridState::columndata. The
+    // grid provides texts/numbers with room for every requested row, the source fills the one
+    // matching kind. Texts must stay valid until EndItemGrid returns.
+    struct ItemGridColumnData
+    {
+        ItemGridCellKind kind = ItemGridCellKind::Widget;
+        std::string_view* texts = nullptr;
+        double* numbers = nullptr;
+        int32_t precision = -1; // digits after the decimal point, -1 for the shortest exact form
+        int32_t alignment = TextAlignLeading;
+        uint32_t color = 0; // 0 uses the default style's foreground color
+    };
+
+    struct ItemGridState
     {
         struct CellData
         {
@@ -370,6 +423,7 @@ namespace glimmer
                 CellState() {}
                 ~CellState() {}
             } state;
+            int32_t flags = WS_Default; // WS_* state flags of the cell's widget
             int16_t colspan = 1;
             int16_t children = 0;
 
@@ -391,6 +445,7 @@ namespace glimmer
         {
             std::vector<std::vector<ColumnConfig>> headers;
             int32_t rows = 0;
+            int32_t pinnedRows = 0; // leading top-level rows which stay below the headers while scrolling
             float indent = 10.f;
         } config;
 
@@ -406,39 +461,56 @@ namespace glimmer
         WidgetDrawResult (*celldata)(std::pair<float, float>, int32_t, int16_t, int16_t) = nullptr;
         WidgetDrawResult (*header)(ImVec2, float, int16_t, int16_t, int16_t) = nullptr;
 
+        // When set, the grid owns the display order of top-level rows: clicking a sortable header
+        // sorts by that column (shift+click adds it as a further sort column), column filters hide
+        // rows whose key does not match and the rows passed to cellprops/celldata are logical (data)
+        // rows. Called with logical rows only.
+        ItemGridSortKey (*sortkey)(int32_t, int16_t) = nullptr;
+
+        // Optional columnar source, called once per visible column with a block of (logical) top-level
+        // rows: (col, rows, count, data). Text and Number cells are drawn directly, without invoking
+        // cellprops/celldata for them, they span one column and have no children.
+        void (*columndata)(int16_t, const int32_t*, int32_t, ItemGridColumnData&) = nullptr;
+
+        // Tree grids, when set the grid's rows are the visible nodes of a tree and the rows passed to
+        // cellprops/celldata/columndata are node ids (the depth passed to celldata is the node's).
+        // nodechildren appends the ids of a node's children, -1 for the roots, and is called once
+        // per node when it is first expanded. nodeexpandable tells if a node not yet expanded has
+        // children, all nodes are expandable when not set. Expansion is toggled by clicking the
+        // node's symbol in column 0, children/vstate from cellprops are not used.
+        void (*nodechildren)(int32_t, std::vector<int32_t>&) = nullptr;
+        bool (*nodeexpandable)(int32_t) = nullptr;
+
         void setColumnResizable(int16_t col, bool resizable);
         void setColumnProps(int16_t col, ColumnProperty prop, bool set = true);
     };
 
+    // Non-owning view of a widget's state, states themselves are stored in dense per-type
+    // arrays. Only the member of state corresponding to type is valid. The view is invalidated
+    // when new widget IDs are created, hence do not hold on to it across frames. Members are
+    // pointers i.e. GetWidgetConfig(id).state.label->text, state flags are in *flags.
     struct WidgetConfigData
     {
-        WidgetType type;
+        WidgetType type = WT_Invalid;
 
         union SharedWidgetState {
-            LabelState label;
-            ButtonState button;
-            ToggleButtonState toggle;
-            RadioButtonState radio;
-            CheckboxState checkbox;
-            SpinnerState spinner;
-            SliderState slider;
-            TextInputState input;
-            DropDownState dropdown;
-            TabBarState tab;
-            ItemGridState grid;
-            ScrollableRegion scroll;
-            // Add others...
-
-            SharedWidgetState() {}
-            ~SharedWidgetState() {}
+            LabelState* label;
+            ButtonState* button;
+            ToggleButtonState* toggle;
+            RadioButtonState* radio;
+            CheckboxState* checkbox;
+            SpinnerState* spinner;
+            SliderState* slider;
+            TextInputState* input;
+            DropDownState* dropdown;
+            TabBarState* tab;
+            ItemGridState* grid;
+            ScrollableRegion* scroll;
+            void* ptr = nullptr;
         } state;
 
-        CommonWidgetData data;
-
-        WidgetConfigData(WidgetType type);
-        WidgetConfigData(const WidgetConfigData& src);
-        WidgetConfigData& operator=(const WidgetConfigData& src);
-        ~WidgetConfigData();
+        int32_t* flags = nullptr; // WS_* state flags
+        CommonWidgetData* data = nullptr;
     };
 
     enum WidgetGeometry : int32_t
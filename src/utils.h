@@ -4,10 +4,12 @@
 #include <span>
 #include <optional>
 #include <stdint.h>
+#include <cstdlib>
 
 #ifdef _DEBUG
 #include <cstdio>
 #include <unordered_map>
+#include <mutex>
 #define LOG(FMT, ...) std::fprintf(stderr, FMT, __VA_ARGS__)
 #define HIGHLIGHT(FMT, ...) std::fprintf(stderr, "\x1B[93m" FMT "\x1B[0m", __VA_ARGS__)
 #define LOGERROR(FMT, ...) std::fprintf(stderr, "\x1B[31m" FMT "\x1B[0m", __VA_ARGS__)
@@ -40,61 +42,128 @@ namespace glimmer
         while (start != end) { ::new (&(*start)) T{}; ++start; }
     }
 
+    void RecordProfileAllocation(int64_t bytes);
+
+    // Subsystem which requested the allocation, used for accounting only
+    enum AllocationTag : int8_t
+    {
+        AT_General, AT_Layout, AT_Style, AT_Renderer, AT_WidgetState, AT_Total
+    };
+
+    // Implement this to supply memory to all containers in the library. Sizes are passed
+    // on reallocation/deallocation as well, so that implementations do not need headers
+    struct IAllocator
+    {
+        virtual void* Allocate(size_t amount, AllocationTag tag) = 0;
+        virtual void* Reallocate(void* ptr, size_t oldsz, size_t amount, AllocationTag tag) = 0;
+        virtual void Deallocate(void* ptr, size_t amount, AllocationTag tag) = 0;
+        virtual ~IAllocator() = default;
+    };
+
+    // Feeds the profiler's per-frame allocation counters, as do the debug allocator and
+    // (through their upstream) counting allocators
+    struct PassthroughAllocator final : public IAllocator
+    {
+        void* Allocate(size_t amount, AllocationTag) override
+        {
+#ifndef GLIMMER_DISABLE_PROFILER
+            RecordProfileAllocation((int64_t)amount);
+#endif
+            return std::malloc(amount);
+        }
+
+        void* Reallocate(void* ptr, size_t, size_t amount, AllocationTag) override
+        {
+#ifndef GLIMMER_DISABLE_PROFILER
+            RecordProfileAllocation((int64_t)amount);
+#endif
+            return std::realloc(ptr, amount);
+        }
+
+        void Deallocate(void* ptr, size_t, AllocationTag) override { std::free(ptr); }
+    };
+
+    inline PassthroughAllocator DefaultAllocator;
+
 #ifdef _DEBUG
     inline int32_t TotalMallocs = 0;
     inline int32_t TotalReallocs = 0;
     inline int32_t AllocatedBytes = 0;
     inline std::unordered_map<void*, size_t> Allocations;
+    inline std::mutex AllocationsLock; // UI trees can be built on several threads
 
-    inline void* AllocateImpl(size_t amount)
+    struct DebugAllocator final : public IAllocator
     {
-        TotalMallocs++;
-        AllocatedBytes += amount;
-        auto ptr = std::malloc(amount);
-        if (Allocations.find(ptr) != Allocations.end())
-            LOGERROR("Possibly overwriting memory @ %p\n", ptr);
-        Allocations[ptr] = amount;
-        return ptr;
-    }
-
-    inline void* ReallocateImpl(void* ptr, size_t amount)
-    {
-        auto result = std::realloc(ptr, amount);
-        auto it = Allocations.find(ptr);
-        if (it == Allocations.end()) {
-            AllocatedBytes += amount;
+        void* Allocate(size_t amount, AllocationTag) override
+        {
+            std::lock_guard<std::mutex> lock{ AllocationsLock };
             TotalMallocs++;
+            AllocatedBytes += amount;
+            RecordProfileAllocation((int64_t)amount);
+            auto ptr = std::malloc(amount);
+            if (Allocations.find(ptr) != Allocations.end())
+                LOGERROR("Possibly overwriting memory @ %p\n", ptr);
+            Allocations[ptr] = amount;
+            return ptr;
         }
-        else { 
-            AllocatedBytes += amount - it->second; 
-            TotalReallocs++;
-            Allocations.erase(ptr);
+
+        void* Reallocate(void* ptr, size_t, size_t amount, AllocationTag) override
+        {
+            std::lock_guard<std::mutex> lock{ AllocationsLock };
+            auto result = std::realloc(ptr, amount);
+            auto it = Allocations.find(ptr);
+            RecordProfileAllocation((int64_t)amount);
+            if (it == Allocations.end()) {
+                AllocatedBytes += amount;
+                TotalMallocs++;
+            }
+            else {
+                AllocatedBytes += amount - it->second;
+                TotalReallocs++;
+                Allocations.erase(ptr);
+            }
+            Allocations.emplace(result, amount);
+            return result;
         }
-        Allocations.emplace(result, amount);
-        return result;
-    }
 
-    inline void DeallocateImpl(void* ptr) 
-    { 
-        if (ptr != nullptr)
+        void Deallocate(void* ptr, size_t, AllocationTag) override
         {
-            --TotalMallocs;
-            std::free(ptr);
-            AllocatedBytes -= Allocations.at(ptr);
-            Allocations.erase(ptr);
+            if (ptr != nullptr)
+            {
+                std::lock_guard<std::mutex> lock{ AllocationsLock };
+                --TotalMallocs;
+                std::free(ptr);
+                AllocatedBytes -= Allocations.at(ptr);
+                Allocations.erase(ptr);
+            }
+            else LOGERROR("Unchecked de-allocation of nullptr...\n");
         }
-        else LOGERROR("Unchecked de-allocation of nullptr...\n");
-    }
-    
-    inline void* (*AllocateFunc)(size_t amount) = &AllocateImpl;
-    inline void* (*ReallocateFunc)(void* ptr, size_t amount) = &ReallocateImpl;
-    inline void (*DeallocateFunc)(void* ptr) = &DeallocateImpl;
+    };
+
+    inline DebugAllocator DebugTrackingAllocator;
+    inline IAllocator* GlobalAllocator = &DebugTrackingAllocator;
 #else
-    inline void* (*AllocateFunc)(size_t amount) = &std::malloc;
-    inline void* (*ReallocateFunc)(void* ptr, size_t amount) = &std::realloc;
-    inline void (*DeallocateFunc)(void* ptr) = &std::free;
+    inline IAllocator* GlobalAllocator = &DefaultAllocator;
 #endif
 
+    inline thread_local AllocationTag CurrentAllocationTag = AT_General;
+
+    // Containers capture the global allocator when constructed, hence this should
+    // be invoked at init, before creating any platform/context
+    inline void SetAllocator(IAllocator* allocator) 
+    { 
+        GlobalAllocator = allocator != nullptr ? allocator : &DefaultAllocator; 
+    }
+
+    // Attributes allocations made inside the scope to a subsystem
+    struct AllocationTagScope
+    {
+        AllocationTag previous;
+
+        explicit AllocationTagScope(AllocationTag tag) : previous{ CurrentAllocationTag } { CurrentAllocationTag = tag; }
+        ~AllocationTagScope() { CurrentAllocationTag = previous; }
+    };
+
     template <typename T, typename Sz, Sz blocksz = 128>
     struct Vector
     {
@@ -144,7 +213,7 @@ namespace glimmer
         ~Vector()
         {
             if constexpr (std::is_destructible_v<T>) for (auto idx = 0; idx < _size; ++idx) _data[idx].~T();
-            DeallocateFunc(_data);
+            if (_data != nullptr) _allocator->Deallocate(_data, sizeof(T) * _capacity, _tag);
         }
 
         explicit Vector(bool init = true)
@@ -152,7 +221,7 @@ namespace glimmer
             if (init)
             {
                 _capacity = blocksz;
-                _data = (T*)AllocateFunc(sizeof(T) * blocksz);
+                _data = _allocate(blocksz);
                 _default_init(0, _capacity);
             }
         }
@@ -160,13 +229,13 @@ namespace glimmer
         template <typename IntegralT, 
             typename = std::enable_if<!std::is_same_v<IntegralT, bool>, void>::type>
         explicit Vector(IntegralT initialsz)
-            : _capacity{ (Sz)initialsz }, _data{ (T*)AllocateFunc(sizeof(T) * (Sz)initialsz) }
+            : _capacity{ (Sz)initialsz }, _data{ _allocate((Sz)initialsz) }
         {
             _default_init(0, _capacity);
         }
 
         explicit Vector(Sz initialsz, const T& el)
-            : _capacity{ initialsz }, _size{ initialsz }, _data{ (T*)AllocateFunc(sizeof(T) * initialsz) }
+            : _capacity{ initialsz }, _size{ initialsz }, _data{ _allocate(initialsz) }
         {
             Fill(_data, _data + _capacity, el);
         }
@@ -175,13 +244,11 @@ namespace glimmer
         {
             if (_data == nullptr)
             {
-                _data = (T*)AllocateFunc(sizeof(T) * count);
+                _data = _allocate(count);
             }
             else if (_capacity < count)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * count);
-                if (ptr != _data) memmove(ptr, _data, sizeof(T) * _size);
-                _data = ptr;
+                _data = (T*)_allocator->Reallocate(_data, sizeof(T) * _capacity, sizeof(T) * count, _tag);
             }
 
             if (initialize) _default_init(_size, count);
@@ -192,13 +259,11 @@ namespace glimmer
         {
             if (_data == nullptr)
             {
-                _data = (T*)AllocateFunc(sizeof(T) * count);
+                _data = _allocate(count);
             }
             else if (_capacity < count)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * count);
-                if (ptr != _data) memmove(ptr, _data, sizeof(T) * _size);
-                _data = ptr;
+                _data = (T*)_allocator->Reallocate(_data, sizeof(T) * _capacity, sizeof(T) * count, _tag);
             }
 
             Fill(_data + _size, _data + count, el);
@@ -217,20 +282,19 @@ namespace glimmer
 
             if (_capacity < targetsz)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * targetsz);
-                if (ptr != _data) memmove(ptr, _data, sizeof(T) * _size);
-                _data = ptr;
+                _data = _data == nullptr ? _allocate(targetsz) :
+                    (T*)_allocator->Reallocate(_data, sizeof(T) * _capacity, sizeof(T) * targetsz, _tag);
                 _capacity = targetsz;
             }
-            else _size = targetsz;
 
             if (initialize) _default_init(_size, targetsz);
+            _size = targetsz;
         }
 
         template <typename... ArgsT>
         T& emplace_back(ArgsT&&... args)
         {
-            _reallocate(true);
+            _reallocate(false);
             ::new(_data + _size) T{ std::forward<ArgsT>(args)... };
             _size++;
             return _data[_size - 1];
@@ -240,7 +304,22 @@ namespace glimmer
         void pop_back(bool definit) { if constexpr (std::is_default_constructible_v<T>) if (definit) _data[_size - 1] = T{}; --_size; }
         void clear(bool definit) { if (definit) _default_init(0, _size); _size = 0; }
         void reset(const T& el) { Fill(_data, _data + _size, el); }
-        void shrink_to_fit() { _data = (T*)ReallocateFunc(_data, _size * sizeof(T)); _capacity = _size; }
+        void shrink_to_fit() { _data = (T*)_allocator->Reallocate(_data, _capacity * sizeof(T), _size * sizeof(T), _tag); _capacity = _size; }
+
+        // Move to a (reset) arena allocator, contents are discarded but capacity is retained.
+        // If current allocator is the same, it is assumed to have been reset already, hence
+        // the buffer is dropped without deallocation.
+        void rebind(IAllocator* allocator)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "Only trivial types can be arena allocated");
+
+            if (_data != nullptr && _allocator != allocator)
+                _allocator->Deallocate(_data, sizeof(T) * _capacity, _tag);
+
+            _allocator = allocator;
+            _size = 0;
+            _data = _capacity > 0 ? _allocate(_capacity) : nullptr;
+        }
 
         Iterator begin() { return _data; }
         Iterator end() { return _data + _size; }
@@ -273,20 +352,29 @@ namespace glimmer
                 Fill(_data + from, _data + to, T{ 0 });
         }
 
+        // The tag of the buffer is kept, so that it is reallocated and released under the same tag
+        T* _allocate(Sz count)
+        {
+            _tag = CurrentAllocationTag;
+            return (T*)_allocator->Allocate(sizeof(T) * count, _tag);
+        }
+
         void _reallocate(bool initialize)
         {
             T* ptr = nullptr;
-            if (_size == _capacity) ptr = (T*)ReallocateFunc(_data, (_capacity + blocksz) * sizeof(T));
+            if (_size == _capacity) ptr = _data == nullptr ? _allocate(blocksz) :
+                (T*)_allocator->Reallocate(_data, _capacity * sizeof(T), (_capacity + blocksz) * sizeof(T), _tag);
 
             if (ptr != nullptr)
             {
-                if (ptr != _data) memmove(ptr, _data, sizeof(T) * _capacity);
                 _data = ptr;
                 if (initialize) _default_init(_capacity, _capacity + blocksz);
                 _capacity += blocksz;
             }
         }
 
+        IAllocator* _allocator = GlobalAllocator;
+        AllocationTag _tag = AT_General;
         T* _data = nullptr;
         Sz _size = 0;
         Sz _capacity = 0;
@@ -295,6 +383,8 @@ namespace glimmer
     template <typename T, int16_t capacity>
     struct FixedSizeStack
     {
+        IAllocator* _allocator = GlobalAllocator;
+        AllocationTag _tag = CurrentAllocationTag;
         T* _data = nullptr;
         int16_t _size = 0;
         int16_t _max = 0;
@@ -304,7 +394,7 @@ namespace glimmer
 
         FixedSizeStack(bool init = true)
         {
-            _data = (T*)AllocateFunc(sizeof(T) * capacity);
+            _data = (T*)_allocator->Allocate(sizeof(T) * capacity, _tag);
 
             if (init)
             {
@@ -317,7 +407,7 @@ namespace glimmer
         {
             if constexpr (std::is_destructible_v<T>) 
                 for (int16_t idx = 0; idx < _size; ++idx) _data[idx].~T();
-            DeallocateFunc(_data);
+            _allocator->Deallocate(_data, sizeof(T) * capacity, _tag);
         }
 
         T& push()
@@ -357,6 +447,84 @@ namespace glimmer
         T const& next(int16_t amount) const { return _data[_size - (int16_t)1 - amount]; }
     };
 
+    // Stack without an upper bound, elements live in chunks of `chunksz` which are allocated
+    // when the stack first grows into them. Elements are constructed on first push and never
+    // move, so references to outer levels stay valid while inner levels are pushed.
+    template <typename T, int16_t chunksz = 4>
+    struct PooledStack
+    {
+        IAllocator* _allocator = GlobalAllocator;
+        AllocationTag _tag = AT_General; // of the first chunk, all chunks are released under it
+        Vector<T*, int16_t, 8> _chunks{ false };
+        int16_t _size = 0;
+        int16_t _max = 0; // Number of constructed elements
+
+        static_assert(chunksz > 0, "chunk size has to be a +ve value");
+        static_assert(std::is_default_constructible_v<T>, "Element type must be default constructible");
+
+        PooledStack() = default;
+        PooledStack(const PooledStack&) = delete;
+        PooledStack& operator=(const PooledStack&) = delete;
+
+        ~PooledStack()
+        {
+            if constexpr (std::is_destructible_v<T>)
+                for (int16_t idx = 0; idx < _max; ++idx) _at(idx).~T();
+            for (auto chunk : _chunks) _allocator->Deallocate(chunk, sizeof(T) * chunksz, _tag);
+        }
+
+        T& push()
+        {
+            if (_size == _max)
+            {
+                if (_max == _chunks.size() * chunksz)
+                {
+                    if (_chunks.empty()) _tag = CurrentAllocationTag;
+                    _chunks.push_back((T*)_allocator->Allocate(sizeof(T) * chunksz, _tag));
+                }
+                ::new(_slot(_max)) T{};
+                ++_max;
+            }
+
+            return _at(_size++);
+        }
+
+        void pop(int16_t depth, bool definit)
+        {
+            while (depth > 0 && _size > 0)
+            {
+                --_size;
+                if (definit)
+                {
+                    if constexpr (std::is_destructible_v<T>) _at(_size).~T();
+                    ::new(_slot(_size)) T{};
+                }
+                --depth;
+            }
+        }
+
+        void clear(bool definit) { pop(_size, definit); }
+
+        int size() const { return _size; }
+        int constructed() const { return _max; }
+        bool empty() const { return _size == 0; }
+
+        // Valid for idx < constructed(), not only for idx < size()
+        T& operator[](int16_t idx) { return _at(idx); }
+        T const& operator[](int16_t idx) const { return _at(idx); }
+
+        T& top(int16_t depth = 0) { return _at(_size - (int16_t)1 - depth); }
+        T const& top(int16_t depth = 0) const { return _at(_size - (int16_t)1 - depth); }
+
+        T& next(int16_t amount) { return _at(_size - (int16_t)1 - amount); }
+        T const& next(int16_t amount) const { return _at(_size - (int16_t)1 - amount); }
+
+    private:
+
+        T* _slot(int16_t idx) const { return _chunks[idx / chunksz] + (idx % chunksz); }
+        T& _at(int16_t idx) const { assert(idx >= 0 && idx < _max); return *_slot(idx); }
+    };
+
     template <typename T, typename Sz, Sz blocksz = 128>
     struct DynamicStack
     {
@@ -400,6 +568,7 @@ namespace glimmer
         }
 
         void clear(bool definit) { pop(_data._size, definit); }
+        void rebind(IAllocator* allocator) { _data.rebind(allocator); _max = 0; }
 
         Sz size() const { return _data.size(); }
         bool empty() const { return _data.size() == 0; }
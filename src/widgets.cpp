@@ -5,11 +5,18 @@
 #include <cmath>
 #include <cctype>
 #include <charconv>
+#include <numeric>
+#include <execution>
+#include <thread>
+#include <array>
+#include <bit>
 #include "style.h"
+#include "richtext.h"
 #include "draw.h"
 #include "context.h"
 #include "layout.h"
 #include "im_font_manager.h"
+#include "profiler.h"
 #include "libs/inc/implot/implot.h"
 
 namespace glimmer
@@ -20,86 +27,6 @@ namespace glimmer
     void AddExtent(LayoutItemDescriptor& layoutItem, const StyleDescriptor& style, const NeighborWidgets& neighbors,
         ImVec2 size, ImVec2 totalsz);
 
-    WidgetConfigData::WidgetConfigData(WidgetType ty)
-        : type{ ty }
-    {
-        switch (type)
-        {
-        case WT_Label: ::new (&state.label) LabelState{}; break;
-        case WT_Button: ::new (&state.button) ButtonState{}; break;
-        case WT_RadioButton: new (&state.radio) RadioButtonState{}; break;
-        case WT_ToggleButton: new (&state.toggle) ToggleButtonState{}; break;
-        case WT_Checkbox: new (&state.checkbox) CheckboxState{}; break;
-        case WT_Spinner: new (&state.spinner) SpinnerState{}; break;
-        case WT_Slider: new (&state.slider) SliderState{}; break;
-        case WT_TextInput: new (&state.input) TextInputState{}; break;
-        case WT_DropDown: new (&state.dropdown) DropDownState{}; break;
-        case WT_SplitterRegion: [[fallthrough]];
-        case WT_Scrollable: new (&state.scroll) ScrollableRegion{}; break;
-        case WT_TabBar: new (&state.tab) TabBarState{}; break;
-        case WT_ItemGrid: ::new (&state.grid) ItemGridState{}; break;
-        default: break;
-        }
-    }
-
-    WidgetConfigData::WidgetConfigData(const WidgetConfigData& src)
-        : WidgetConfigData{ src.type }
-    {
-        switch (type)
-        {
-        case WT_Label: state.label = src.state.label; break;
-        case WT_Button: state.button = src.state.button; break;
-        case WT_RadioButton: state.radio = src.state.radio; break;
-        case WT_ToggleButton: state.toggle = src.state.toggle; break;
-        case WT_Checkbox: state.checkbox = src.state.checkbox; break;
-        case WT_Spinner: state.spinner = src.state.spinner; break;
-        case WT_Slider: state.slider = src.state.slider; break;
-        case WT_TextInput: state.input = src.state.input; break;
-        case WT_DropDown: state.dropdown = src.state.dropdown; break;
-        case WT_SplitterRegion: [[fallthrough]];
-        case WT_Scrollable: state.scroll = src.state.scroll; break;
-        case WT_TabBar: state.tab = src.state.tab; break;
-        case WT_ItemGrid: state.grid = src.state.grid; break;
-        default: break;
-        }
-    }
-
-    WidgetConfigData& WidgetConfigData::operator=(const WidgetConfigData& src)
-    {
-        type = src.type;
-        switch (src.type)
-        {
-        case WT_Label: state.label = src.state.label; break;
-        case WT_Button: state.button = src.state.button; break;
-        case WT_RadioButton: state.radio = src.state.radio; break;
-        case WT_ToggleButton: state.toggle = src.state.toggle; break;
-        case WT_Checkbox: state.checkbox = src.state.checkbox; break;
-        case WT_Spinner: state.spinner = src.state.spinner; break;
-        case WT_Slider: state.slider = src.state.slider; break;
-        case WT_TextInput: state.input = src.state.input; break;
-        case WT_DropDown: state.dropdown = src.state.dropdown; break;
-        case WT_SplitterRegion: [[fallthrough]];
-        case WT_Scrollable: state.scroll = src.state.scroll; break;
-        case WT_TabBar: state.tab = src.state.tab; break;
-        case WT_ItemGrid: state.grid = src.state.grid; break;
-        default: break;
-        }
-        return *this;
-    }
-
-    WidgetConfigData::~WidgetConfigData()
-    {
-        switch (type)
-        {
-        case WT_Label: state.label.~LabelState(); break;
-        case WT_Button: state.button.~ButtonState(); break;
-        case WT_RadioButton: break;
-        case WT_ToggleButton: break;
-        case WT_ItemGrid: state.grid.~ItemGridState(); break;
-        default: break;
-        }
-    }
-
     WidgetDrawResult Widget(int32_t id, WidgetType type, int32_t geometry, const NeighborWidgets& neighbors);
 
     static bool IsBetween(float point, float min, float max, float tolerance = 0.f)
@@ -112,10 +39,12 @@ namespace glimmer
         switch (type)
         {
         case glimmer::TextType::PlainText: return renderer.GetTextSize(text, font.font, font.size, width);
-        case glimmer::TextType::RichText: return ImVec2{ 0, 0 }; // TODO...
+        case glimmer::TextType::RichText: return MeasureRichText(text, font, width, renderer);
         case glimmer::TextType::SVG: return ImVec2{ font.size, font.size };
         default: break;
         }
+
+        return ImVec2{ font.size, font.size };
     }
 
     void ShowTooltip(float& hoverDuration, const ImRect& margin, ImVec2 pos, std::string_view tooltip, const IODescriptor& io, IRenderer& renderer)
@@ -135,7 +64,7 @@ namespace glimmer
     template <typename StringT>
     static void CopyToClipboard(StringT& string, int start, int end)
     {
-        static char buffer[256] = { 0 };
+        static thread_local char buffer[256] = { 0 };
         auto dest = 0;
         auto sz = end - start + 2;
         IPlatform& platform = *Config.platform;
@@ -523,6 +452,7 @@ namespace glimmer
         std::string_view text, IRenderer& renderer, int32_t geometry, TextType type,
         const NeighborWidgets& neighbors, float width, float height)
     {
+        GLIMMER_PROFILE_SCOPE(PP_WidgetBounds);
         ImRect content, padding, border, margin;
         const auto& borderstyle = style.border;
         const auto& font = style.font;
@@ -857,13 +787,14 @@ namespace glimmer
         const ImRect& content, const ImRect& text, IRenderer& renderer, const IODescriptor& io, WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& common = *context.GetState(id).data;
         if (!context.deferEvents)
         {
-            auto& state = context.GetState(id).state.label;
-            auto ismouseover = padding.Contains(io.mousepos);
-            if (ismouseover && !state.tooltip.empty() && !io.isMouseDown())
-                ShowTooltip(state._hoverDuration, margin, margin.Min, state.tooltip, io, renderer);
-            else state._hoverDuration == 0;
+            auto& state = *context.GetState(id).state.label;
+            auto ismouseover = context.IsHovered(id, padding, io.mousepos);
+            if (ismouseover && !common.tooltip.empty() && !io.isMouseDown())
+                ShowTooltip(common._hoverDuration, margin, margin.Min, common.tooltip, io, renderer);
+            else common._hoverDuration == 0;
         }
         else context.deferedEvents.emplace_back(WT_Label, id, margin, border, padding, content, text);
     }
@@ -872,17 +803,19 @@ namespace glimmer
         const ImRect& content, const ImRect& text, IRenderer& renderer, const IODescriptor& io, WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
+        auto& common = *context.GetState(id).data;
         if (!context.deferEvents)
         {
-            auto& state = context.GetState(id).state.button;
-            auto ismouseover = padding.Contains(io.mousepos);
-            state.state = !ismouseover ? WS_Default :
+            auto& state = *context.GetState(id).state.button;
+            auto ismouseover = context.IsHovered(id, padding, io.mousepos);
+            flags = !ismouseover ? WS_Default :
                 io.isLeftMouseDown() ? WS_Pressed | WS_Hovered : WS_Hovered;
             if (ismouseover && io.clicked())
                 result.event = WidgetEvent::Clicked;
-            else if (ismouseover && !state.tooltip.empty() && !io.isMouseDown())
-                ShowTooltip(state._hoverDuration, margin, margin.Min, state.tooltip, io, renderer);
-            else state._hoverDuration == 0;
+            else if (ismouseover && !common.tooltip.empty() && !io.isMouseDown())
+                ShowTooltip(common._hoverDuration, margin, margin.Min, common.tooltip, io, renderer);
+            else common._hoverDuration == 0;
         }
         else context.deferedEvents.emplace_back(WT_Button, id, margin, border, padding, content, text);
     }
@@ -891,15 +824,16 @@ namespace glimmer
         const ImRect& content, const ImRect& text, IRenderer& renderer, const IODescriptor& io, int32_t textflags)
     {
         auto& context = GetContext();
-        assert((id & 0xffff) <= (int)context.states[WT_Label].size());
+        auto& flags = context.states.flags(id);
+        assert((id & 0xffff) <= context.states.size(WT_Label));
 
         WidgetDrawResult result;
-        auto& state = context.GetState(id).state.label;
+        auto& state = *context.GetState(id).state.label;
 
         DrawBoxShadow(border.Min, border.Max, style, renderer);
         DrawBackground(border.Min, border.Max, style, renderer);
         DrawBorderRect(border.Min, border.Max, style.border, style.bgcolor, renderer);
-        DrawText(content.Min, content.Max, text, state.text, state.state & WS_Disabled, style, renderer, textflags | style.font.flags);
+        DrawText(content.Min, content.Max, text, state.text, flags & WS_Disabled, style, renderer, textflags | style.font.flags);
         HandleLabelEvent(id, margin, border, padding, content, text, renderer, io, result);
         
         result.geometry = margin;
@@ -911,12 +845,13 @@ namespace glimmer
     {
         WidgetDrawResult result;
         auto& context = GetContext();
-        auto& state = context.GetState(id).state.button;
+        auto& flags = context.states.flags(id);
+        auto& state = *context.GetState(id).state.button;
 
         DrawBoxShadow(border.Min, border.Max, style, renderer);
         DrawBackground(border.Min, border.Max, style, renderer);
         DrawBorderRect(border.Min, border.Max, style.border, style.bgcolor, renderer);
-        DrawText(content.Min, content.Max, text, state.text, state.state & WS_Disabled, style, renderer);
+        DrawText(content.Min, content.Max, text, state.text, flags & WS_Disabled, style, renderer);
         HandleButtonEvent(id, margin, border, padding, content, text, renderer, io, result);
 
         result.geometry = margin;
@@ -927,11 +862,11 @@ namespace glimmer
 
 #pragma region Toggle Button
 
-    static std::pair<ImRect, ImVec2> ToggleButtonBounds(ToggleButtonState& state, const ImRect& extent, IRenderer& renderer)
+    static std::pair<ImRect, ImVec2> ToggleButtonBounds(int32_t flags, const ImRect& extent, IRenderer& renderer)
     {
         auto& context = GetContext();
-        auto style = WidgetContextData::GetStyle(state.state);
-        auto& specificStyle = context.toggleButtonStyles[log2((unsigned)state.state)].top();
+        auto style = WidgetContextData::GetStyle(flags);
+        auto& specificStyle = context.toggleButtonStyles[log2((unsigned)flags)].top();
         ImRect result;
         ImVec2 text;
         result.Min = result.Max = extent.Min;
@@ -963,12 +898,13 @@ namespace glimmer
         WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
         if (!context.deferEvents)
         {
             auto& toggle = context.ToggleState(id);
-            auto& state = context.GetState(id).state.toggle;
+            auto& state = *context.GetState(id).state.toggle;
             auto mousepos = io.mousepos;
-            auto mouseover = extent.Contains(mousepos);
+            auto mouseover = context.IsHovered(id, extent, mousepos);
 
             if (mouseover && io.clicked())
             {
@@ -979,9 +915,9 @@ namespace glimmer
             }
 
             toggle.btnpos = toggle.animate ? center.x : -1.f;
-            state.state = mouseover && io.isLeftMouseDown() ? WS_Hovered | WS_Pressed :
+            flags = mouseover && io.isLeftMouseDown() ? WS_Hovered | WS_Pressed :
                 mouseover ? WS_Hovered : WS_Default;
-            state.state = state.checked ? state.state | WS_Checked : state.state & ~WS_Checked;
+            flags = state.checked ? flags | WS_Checked : flags & ~WS_Checked;
         }
         else context.deferedEvents.emplace_back(WT_ToggleButton, id, center, extent);
     }
@@ -991,7 +927,8 @@ namespace glimmer
     {
         WidgetDrawResult result;
         auto& context = GetContext();
-        auto& specificStyle = context.toggleButtonStyles[log2((unsigned)state.state)].top();
+        auto& flags = context.states.flags(id);
+        auto& specificStyle = context.toggleButtonStyles[log2((unsigned)flags)].top();
         auto& toggle = context.ToggleState(id);
 
         auto extra = (-specificStyle.thumbOffset + specificStyle.trackBorderThickness);
@@ -1047,10 +984,10 @@ namespace glimmer
 
 #pragma region Radio Button
 
-    static ImRect RadioButtonBounds(const RadioButtonState& state, const ImRect& extent)
+    static ImRect RadioButtonBounds(int32_t flags, const ImRect& extent)
     {
         auto& context = GetContext();
-        const auto style = WidgetContextData::GetStyle(state.state);
+        const auto style = WidgetContextData::GetStyle(flags);
         return ImRect{ extent.Min, extent.Min + ImVec2{ style.font.size, style.font.size } };
     }
 
@@ -1058,12 +995,13 @@ namespace glimmer
         WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
         if (!context.deferEvents)
         {
             auto& radio = context.RadioState(id);
-            auto& state = context.GetState(id).state.radio;
+            auto& state = *context.GetState(id).state.radio;
             auto mousepos = io.mousepos;
-            auto mouseover = extent.Contains(mousepos);
+            auto mouseover = context.IsHovered(id, extent, mousepos);
 
             if (mouseover && io.clicked())
             {
@@ -1074,9 +1012,9 @@ namespace glimmer
                 radio.radius = state.checked ? 0.f : maxrad;
             }
 
-            state.state = mouseover && io.isLeftMouseDown() ? WS_Hovered | WS_Pressed :
+            flags = mouseover && io.isLeftMouseDown() ? WS_Hovered | WS_Pressed :
                 mouseover ? WS_Hovered : WS_Default;
-            state.state = state.checked ? state.state | WS_Checked : state.state & ~WS_Checked;
+            flags = state.checked ? flags | WS_Checked : flags & ~WS_Checked;
         }
         else context.deferedEvents.emplace_back(WT_RadioButton, id, extent, maxrad);
     }
@@ -1086,7 +1024,8 @@ namespace glimmer
     {
         WidgetDrawResult result;
         auto& context = GetContext();
-        auto& specificStyle = context.radioButtonStyles[log2((unsigned)state.state)].top();
+        auto& flags = context.states.flags(id);
+        auto& specificStyle = context.radioButtonStyles[log2((unsigned)flags)].top();
         auto& radio = context.RadioState(id);
 
         auto radius = (extent.GetWidth() - 2.f) * 0.5f;
@@ -1112,10 +1051,10 @@ namespace glimmer
 
 #pragma region Checkbox
 
-    static ImRect CheckboxBounds(const CheckboxState& state, const ImRect& extent)
+    static ImRect CheckboxBounds(int32_t flags, const ImRect& extent)
     {
         auto& context = GetContext();
-        const auto style = WidgetContextData::GetStyle(state.state);
+        const auto style = WidgetContextData::GetStyle(flags);
         return ImRect{ extent.Min, extent.Min + ImVec2{ style.font.size, style.font.size } };
     }
 
@@ -1123,22 +1062,23 @@ namespace glimmer
         WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
 
         if (!context.deferEvents)
         {
             auto& check = context.CheckboxState(id);
-            auto& state = context.GetState(id).state.checkbox;
+            auto& state = *context.GetState(id).state.checkbox;
 
             auto mousepos = io.mousepos;
-            auto mouseover = extent.Contains(mousepos);
+            auto mouseover = context.IsHovered(id, extent, mousepos);
             auto isclicked = mouseover && io.isLeftMouseDown();
-            state.state = isclicked ? state.state | WS_Hovered | WS_Pressed :
-                mouseover ? state.state & ~WS_Pressed : state.state & ~WS_Hovered;
+            flags = isclicked ? flags | WS_Hovered | WS_Pressed :
+                mouseover ? flags & ~WS_Pressed : flags & ~WS_Hovered;
 
             if (mouseover && io.clicked())
             {
                 state.check = state.check == CheckState::Unchecked ? CheckState::Checked : CheckState::Unchecked;
-                state.state = state.check == CheckState::Unchecked ? state.state & ~WS_Checked : state.state | WS_Checked;
+                flags = state.check == CheckState::Unchecked ? flags & ~WS_Checked : flags | WS_Checked;
                 result.event = WidgetEvent::Clicked;
                 check.animate = state.check != CheckState::Unchecked;
                 check.progress = 0.f;
@@ -1195,9 +1135,10 @@ namespace glimmer
     {
         auto digits = (int)(std::ceilf(std::log10f(state.max) + 1.f)) + (!state.isInteger ? state.precision + 1 : 0);
         auto& context = GetContext();
-        const auto style = WidgetContextData::GetStyle(state.state);
+        auto& flags = context.states.flags(id);
+        const auto style = WidgetContextData::GetStyle(flags);
 
-        static char buffer[32] = { 0 };
+        static thread_local char buffer[32] = { 0 };
         assert(digits < 31);
         memset(buffer, '0', digits);
         buffer[digits] = 0;
@@ -1233,17 +1174,18 @@ namespace glimmer
         WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
 
         if (!context.deferEvents)
         {
-            auto& state = context.GetState(id).state.spinner;
+            auto& state = *context.GetState(id).state.spinner;
             auto& spinner = context.SpinnerState(id);
 
             if (incbtn.Contains(io.mousepos))
             {
                 if (io.isLeftMouseDown())
                 {
-                    if (!(state.state & WS_Pressed))
+                    if (!(flags & WS_Pressed))
                     {
                         spinner.lastChangeTime = 0.f;
                         spinner.repeatRate = state.repeatTrigger;
@@ -1257,11 +1199,11 @@ namespace glimmer
                     }
                     else spinner.lastChangeTime += io.deltaTime;
 
-                    state.state |= WS_Pressed;
+                    flags |= WS_Pressed;
                 }
                 else 
                 {
-                    state.state &= ~WS_Pressed;
+                    flags &= ~WS_Pressed;
 
                     if (io.clicked())
                     {
@@ -1274,7 +1216,7 @@ namespace glimmer
             {
                 if (io.isLeftMouseDown())
                 {
-                    if (!(state.state & WS_Pressed))
+                    if (!(flags & WS_Pressed))
                     {
                         spinner.lastChangeTime = 0.f;
                         spinner.repeatRate = state.repeatTrigger;
@@ -1288,11 +1230,11 @@ namespace glimmer
                     }
                     else spinner.lastChangeTime += io.deltaTime;
 
-                    state.state |= WS_Pressed;
+                    flags |= WS_Pressed;
                 }
                 else
                 {
-                    state.state &= ~WS_Pressed;
+                    flags &= ~WS_Pressed;
 
                     if (io.clicked())
                     {
@@ -1313,8 +1255,9 @@ namespace glimmer
         WidgetDrawResult result;
         ImRect incbtn, decbtn;
         auto& context = GetContext();
-        const auto& specificStyle = context.spinnerStyles[log2((unsigned)state.state)].top();
-        static char buffer[32] = { 0 };
+        auto& flags = context.states.flags(id);
+        const auto& specificStyle = context.spinnerStyles[log2((unsigned)flags)].top();
+        static thread_local char buffer[32] = { 0 };
 
         ImRect border{ extent.Min - ImVec2{ style.border.left.thickness, style.border.top.thickness }, 
             extent.Max + ImVec2{ style.border.right.thickness, style.border.bottom.thickness } };
@@ -1428,8 +1371,9 @@ namespace glimmer
     {
         ImRect result;
         auto& context = GetContext();
-        auto& state = context.GetState(id).state.slider;
-        const auto style = WidgetContextData::GetStyle(state.state);
+        auto& flags = context.states.flags(id);
+        auto& state = *context.GetState(id).state.slider;
+        const auto style = WidgetContextData::GetStyle(flags);
         auto slidersz = std::max(Config.sliderSize, style.font.size);
         auto width = (style.dimension.x > 0.f) ? style.dimension.x : 
             (state.dir == DIR_Horizontal ? extent.GetWidth() : slidersz);
@@ -1445,12 +1389,13 @@ namespace glimmer
     void HandleSliderEvent(int32_t id, const ImRect& extent, const ImRect& thumb, const IODescriptor& io, WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
         
         if (!context.deferEvents)
         {
-            auto& state = context.GetState(id).state.slider;
-            const auto style = WidgetContextData::GetStyle(state.state);
-            const auto& specificStyle = context.sliderStyles[log2((unsigned)state.state)].top();
+            auto& state = *context.GetState(id).state.slider;
+            const auto style = WidgetContextData::GetStyle(flags);
+            const auto& specificStyle = context.sliderStyles[log2((unsigned)flags)].top();
             auto center = thumb.Min + ImVec2{ thumb.GetWidth(), thumb.GetWidth() };
             auto width = extent.GetWidth(), height = extent.GetHeight();
             auto horizontal = width > height;
@@ -1460,7 +1405,7 @@ namespace glimmer
             {
                 auto offset = radius + specificStyle.thumbOffset + specificStyle.trackBorderThickness;
                 auto inthumb = thumb.Contains(io.mousepos);
-                state.state |= WS_Hovered;
+                flags |= WS_Hovered;
 
                 if (io.clicked() && !inthumb)
                 {
@@ -1468,27 +1413,27 @@ namespace glimmer
                     auto where = horizontal ? io.mousepos.x - extent.Min.x - offset : io.mousepos.y - extent.Min.y - offset;
                     auto relative = where / space;
                     state.data = relative * (state.max - state.min);
-                    state.state &= ~WS_Dragged;
+                    flags &= ~WS_Dragged;
                 }
-                else if (io.isLeftMouseDown() && ((state.state & WS_Dragged) || inthumb))
+                else if (io.isLeftMouseDown() && ((flags & WS_Dragged) || inthumb))
                 {
                     // If the drag is starting for first time, consider the center of thumb
                     // otherwise, follow mouse position
-                    auto where = (state.state & WS_Dragged) ? (horizontal ? io.mousepos.x : io.mousepos.y) :
+                    auto where = (flags & WS_Dragged) ? (horizontal ? io.mousepos.x : io.mousepos.y) :
                         (horizontal ? center.x : center.y);
                     auto space = horizontal ? width - (2.f * offset) : height - (2.f * offset);
                     where = horizontal ? where - extent.Min.x - offset : where - extent.Min.y - offset;
                     auto relative = where / space;
                     state.data = relative * (state.max - state.min);
-                    state.state |= WS_Dragged;
+                    flags |= WS_Dragged;
                 }
                 else
-                    state.state &= ~WS_Dragged;
+                    flags &= ~WS_Dragged;
             }
             else
             {
-                state.state &= ~WS_Hovered;
-                state.state &= ~WS_Dragged;
+                flags &= ~WS_Hovered;
+                flags &= ~WS_Dragged;
             }  
         }
         else context.deferedEvents.emplace_back(WT_Slider, id, extent, thumb);
@@ -1499,7 +1444,8 @@ namespace glimmer
     {
         WidgetDrawResult result;
         auto& context = GetContext();
-        const auto& specificStyle = context.sliderStyles[log2((unsigned)state.state)].top();
+        auto& flags = context.states.flags(id);
+        const auto& specificStyle = context.sliderStyles[log2((unsigned)flags)].top();
 
         auto bgcolor = state.TrackColor ? state.TrackColor(state.data) : style.bgcolor;
         DrawBackground(extent.Min, extent.Max, bgcolor, style.gradient, style.border, renderer);
@@ -1602,21 +1548,22 @@ namespace glimmer
         IRenderer& renderer, WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
 
         if (!context.deferEvents)
         {
-            auto& state = context.GetState(id).state.input;
+            auto& state = *context.GetState(id).state.input;
             auto& input = context.InputTextState(id);
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto style = WidgetContextData::GetStyle(flags);
 
             auto mousepos = io.mousepos;
-            auto mouseover = content.Contains(mousepos) || (state.state & WS_Pressed);
+            auto mouseover = content.Contains(mousepos) || (flags & WS_Pressed);
             auto ispressed = mouseover && io.isLeftMouseDown();
             auto hasclick = io.clicked();
-            auto isclicked = (hasclick && mouseover) || (!hasclick && (state.state & WS_Focused));
-            mouseover ? state.state |= WS_Hovered : state.state &= ~WS_Hovered;
-            ispressed ? state.state |= WS_Pressed : state.state &= ~WS_Pressed;
-            isclicked ? state.state |= WS_Focused : state.state &= ~WS_Focused;
+            auto isclicked = (hasclick && mouseover) || (!hasclick && (flags & WS_Focused));
+            mouseover ? flags |= WS_Hovered : flags &= ~WS_Hovered;
+            ispressed ? flags |= WS_Pressed : flags &= ~WS_Pressed;
+            isclicked ? flags |= WS_Focused : flags &= ~WS_Focused;
             if (input.lastClickTime != -1.f) input.lastClickTime += io.deltaTime;
 
             if (mouseover) 
@@ -1627,7 +1574,7 @@ namespace glimmer
             // If mouse gets released at the same position, it is a click and not a selection,
             // in which case, move the caret to the respective char position.
             // If mouse gets dragged, select the region of text
-            if (state.state & WS_Pressed)
+            if (flags & WS_Pressed)
             {
                 if (!state.text.empty() && mousepos.y < (content.Max.y - (1.5f * 5.f)))
                 {
@@ -1746,7 +1693,7 @@ namespace glimmer
                     input.selectionStart = -1.f;
                 }
 
-                if (state.state & WS_Focused)
+                if (flags & WS_Focused)
                 {
                     if (input.lastCaretShowTime > 0.5f && state.selection.second == -1)
                     {
@@ -1755,9 +1702,14 @@ namespace glimmer
                     }
                     else input.lastCaretShowTime += io.deltaTime;
 
-                    for (auto kidx = 0; io.key[kidx] != Key_Invalid; ++kidx)
+                    // Events are consumed in arrival order, so that keystrokes which land within one
+                    // frame are all applied and each with the modifiers held at the time
+                    for (const auto& event : io.events)
                     {
-                        auto key = io.key[kidx];
+                        if (event.type != InputEventType::KeyPressed && event.type != InputEventType::Character)
+                            continue;
+
+                        auto key = event.type == InputEventType::KeyPressed ? event.key : Key_Invalid;
                         input.lastCaretShowTime = 0.f;
                         input.caretVisible = true;
 
@@ -1765,7 +1717,7 @@ namespace glimmer
                         {
                             auto prevpos = input.caretpos;
 
-                            if (io.modifiers & ShiftKeyMod)
+                            if (event.modifiers & ShiftKeyMod)
                             {
                                 if (state.selection.second == -1)
                                 {
@@ -1791,7 +1743,7 @@ namespace glimmer
                         {
                             auto prevpos = input.caretpos;
 
-                            if (io.modifiers & ShiftKeyMod)
+                            if (event.modifiers & ShiftKeyMod)
                             {
                                 if (state.selection.second == -1)
                                 {
@@ -1861,11 +1813,51 @@ namespace glimmer
 
                             result.event = WidgetEvent::Edited;
                         }
-                        else if (key == Key_Space || (key >= Key_0 && key <= Key_Z) ||
-                            (key >= Key_Apostrophe && key <= Key_GraveAccent) ||
-                            (key >= Key_Keypad0 && key <= Key_KeypadEqual))
+                        else if (event.type == InputEventType::Character)
+                        {
+                            // Only single byte characters are supported, the text and caret positions are per byte
+                            if (event.codepoint < 32u || event.codepoint > 126u) continue;
+
+                            std::string_view text{ state.text.data(), state.text.size() };
+                            auto ch = (char)event.codepoint;
+                            auto caretAtEnd = input.caretpos == (int)text.size();
+
+                            if (caretAtEnd)
+                            {
+                                state.text.push_back(ch);
+                                std::string_view newtext{ state.text.data(), state.text.size() };
+                                auto lastpos = (int)state.text.size() - 1;
+                                auto width = renderer.GetTextSize(newtext.substr(lastpos, 1), style.font.font, style.font.size).x;
+                                auto nextw = width + (lastpos > 0 ? input.pixelpos[lastpos - 1] : 0.f);
+                                input.pixelpos.push_back(nextw);
+                                input.scroll.state.pos.x = std::max(0.f, input.pixelpos.back() - content.GetWidth());
+                            }
+                            else
+                            {
+                                if (!io.insert)
+                                {
+                                    state.text.push_back(0);
+                                    input.pixelpos.push_back(0.f);
+                                    for (auto from = (int)state.text.size() - 2; from >= input.caretpos; --from)
+                                        state.text[from + 1] = state.text[from];
+                                    state.text[input.caretpos] = (char)ch;
+                                    UpdatePosition(state, input.caretpos, input, style, renderer);
+                                }
+                                else
+                                {
+                                    // TODO: Position update is not required for monospace fonts, can optimize this
+                                    state.text[input.caretpos] = (char)ch;
+                                    UpdatePosition(state, input.caretpos, input, style, renderer);
+
+                                }
+                            }
+
+                            input.caretpos++;
+                            result.event = WidgetEvent::Edited;
+                        }
+                        else if (key >= Key_0 && key <= Key_Z && (event.modifiers & CtrlKeyMod))
                         {
-                            if (key == Key_V && io.modifiers & CtrlKeyMod)
+                            if (key == Key_V)
                             {
                                 auto content = Config.platform->GetClipboardText();
                                 auto length = (int)content.size();
@@ -1904,16 +1896,16 @@ namespace glimmer
                                     result.event = WidgetEvent::Edited;
                                 }
                             }
-                            else if (key == Key_C && (io.modifiers & CtrlKeyMod) && state.selection.second != -1)
+                            else if (key == Key_C && state.selection.second != -1)
                             {
                                 CopyToClipboard(state.text, state.selection.first, state.selection.second);
                             }
-                            else if (key == Key_X && (io.modifiers & CtrlKeyMod) && state.selection.second != -1)
+                            else if (key == Key_X && state.selection.second != -1)
                             {
                                 CopyToClipboard(state.text, state.selection.first, state.selection.second);
                                 DeleteSelectedText(state, input, style, renderer);
                             }
-                            else if (key == Key_A && (io.modifiers & CtrlKeyMod))
+                            else if (key == Key_A)
                             {
                                 if (!state.text.empty())
                                 {
@@ -1923,7 +1915,7 @@ namespace glimmer
                                     input.caretVisible = false;
                                 }
                             }
-                            else if (key == Key_Z && (io.modifiers & CtrlKeyMod))
+                            else if (key == Key_Z)
                             {
                                 if (!input.ops.empty())
                                 {
@@ -1951,46 +1943,6 @@ namespace glimmer
                                     }
                                 }
                             }
-                            else
-                            {
-                                std::string_view text{ state.text.data(), state.text.size() };
-                                auto ch = io.modifiers & ShiftKeyMod ? KeyMappings[key].second : KeyMappings[key].first;
-                                ch = io.capslock ? std::toupper(ch) : std::tolower(ch);
-                                auto caretAtEnd = input.caretpos == (int)text.size();
-
-                                if (caretAtEnd)
-                                {
-                                    state.text.push_back(ch);
-                                    std::string_view newtext{ state.text.data(), state.text.size() };
-                                    auto lastpos = (int)state.text.size() - 1;
-                                    auto width = renderer.GetTextSize(newtext.substr(lastpos, 1), style.font.font, style.font.size).x;
-                                    auto nextw = width + (lastpos > 0 ? input.pixelpos[lastpos - 1] : 0.f);
-                                    input.pixelpos.push_back(nextw);
-                                    input.scroll.state.pos.x = std::max(0.f, input.pixelpos.back() - content.GetWidth());
-                                }
-                                else
-                                {
-                                    if (!io.insert)
-                                    {
-                                        state.text.push_back(0);
-                                        input.pixelpos.push_back(0.f);
-                                        for (auto from = (int)state.text.size() - 2; from >= input.caretpos; --from)
-                                            state.text[from + 1] = state.text[from];
-                                        state.text[input.caretpos] = (char)ch;
-                                        UpdatePosition(state, input.caretpos, input, style, renderer);
-                                    }
-                                    else
-                                    {
-                                        // TODO: Position update is not required for monospace fonts, can optimize this
-                                        state.text[input.caretpos] = (char)ch;
-                                        UpdatePosition(state, input.caretpos, input, style, renderer);
-
-                                    }
-                                }
-
-                                input.caretpos++;
-                                result.event = WidgetEvent::Edited;
-                            }
                         }
                     }
                 }
@@ -2032,23 +1984,24 @@ namespace glimmer
     {
         WidgetDrawResult result;
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
         auto& input = context.InputTextState(id);
 
-        if (state.state & WS_Focused)
+        if (flags & WS_Focused)
             renderer.DrawRect(extent.Min, extent.Max, Config.focuscolor, false, 2.f);
 
         DrawBackground(extent.Min, extent.Max, style, renderer);
         DrawBorderRect(extent.Min, extent.Max, style.border, style.bgcolor, renderer);
         renderer.SetCurrentFont(style.font.font, style.font.size);
 
-        if (state.text.empty() && !(state.state & WS_Focused))
+        if (state.text.empty() && !(flags & WS_Focused))
         {
             auto phstyle = style;
             auto [fr, fg, fb, fa] = DecomposeColor(phstyle.fgcolor);
             fa = 150;
             phstyle.fgcolor = ToRGBA(fr, fg, fb, fa);
             auto sz = renderer.GetTextSize(state.placeholder, style.font.font, style.font.size);
-            DrawText(content.Min, content.Max, { content.Min, content.Min + sz }, state.placeholder, state.state & WS_Disabled,
+            DrawText(content.Min, content.Max, { content.Min, content.Min + sz }, state.placeholder, flags & WS_Disabled,
                 phstyle, renderer, FontStyleOverflowMarquee);
         }
         else
@@ -2091,7 +2044,7 @@ namespace glimmer
             }
         }
 
-        if ((state.state & WS_Focused) && input.caretVisible)
+        if ((flags & WS_Focused) && input.caretVisible)
         {
             auto isCaretAtEnd = input.caretpos == (int)state.text.size();
             auto offset = isCaretAtEnd && (input.scroll.state.pos.x == 0.f) ? 1.f : 0.f;
@@ -2113,7 +2066,8 @@ namespace glimmer
     static std::pair<ImRect, ImRect> DropDownBounds(int32_t id, DropDownState& state, const ImRect& content, IRenderer& renderer)
     {
         auto& context = GetContext();
-        auto style = WidgetContextData::GetStyle(state.state);
+        auto& flags = context.states.flags(id);
+        auto style = WidgetContextData::GetStyle(flags);
         auto size = renderer.GetTextSize(state.text, style.font.font, style.font.size);
         ImRect bounds = content;
 
@@ -2123,16 +2077,138 @@ namespace glimmer
         return { bounds, { content.Min, content.Min + size } };
     }
 
+    static DropDownListState& GetDropDownList(WidgetContextData& context, int32_t id)
+    {
+        auto index = id & 0xffff;
+        if ((int32_t)context.dropDownLists.size() <= index)
+            context.dropDownLists.resize(index + 1);
+        return context.dropDownLists[index];
+    }
+
+    // Renders the built-in option list inside the drop-down popup. Only the visible window of
+    // (filtered) options is backed by widgets, the row widgets are rebound as the list scrolls.
+    // Hit testing uses the row geometry of the last frame, as the popup position is only known
+    // once it is rendered.
+    static void ShowDropDownList(int32_t id, DropDownState& state, float maxh, float width, WidgetDrawResult& result)
+    {
+        auto& popup = GetContext();
+        auto& list = GetDropDownList(*popup.parentContext, id);
+        auto& renderer = popup.GetRenderer();
+        auto io = Config.platform->CurrentIO();
+        auto mousepos = io.mousepos - list.region.Min;
+        auto top = 0.f;
+
+        if (list.region.Contains(io.mousepos))
+        {
+            if (io.mouseWheel != 0.f)
+                list.first -= (int32_t)io.mouseWheel;
+
+            if (io.clicked())
+            {
+                for (const auto& [optidx, rect] : list.visible)
+                {
+                    if (rect.Contains(mousepos))
+                    {
+                        state.selected = optidx;
+                        state.text = state.options[optidx].second;
+                        state.opened = false;
+                        result.event = WidgetEvent::Clicked;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (state.isComboBox)
+        {
+            if (state.inputId == -1) state.inputId = GetNextId(WT_TextInput);
+            top = Widget(state.inputId, WT_TextInput, ToBottomRight, {}).geometry.Max.y;
+            Move(FD_Vertical);
+            popup.adhocLayout.top().nextpos.x = 0.f;
+
+            const auto& text = GetWidgetConfig(state.inputId).state.input->text;
+            if (text != state.input.text) state.input.text = text;
+            list.filter.Filter(state.options, std::string_view{ text.data(), text.size() });
+        }
+        else list.filter.Filter(state.options, {});
+
+        auto total = list.filter.size();
+        auto rowh = list.rowHeight > 0.f ? list.rowHeight : 
+            WidgetContextData::GetStyle(WS_Default).font.size * 1.5f;
+        auto fit = std::max(1, (int32_t)((maxh - top) / rowh));
+        auto count = std::min({ total, (int32_t)GLIMMER_DROPDOWN_MAX_ROWS, fit });
+        list.first = std::clamp(list.first, 0, std::max(0, total - count));
+        if ((int32_t)list.rows.size() < count) list.rows.resize(count);
+        if ((int32_t)list.visible.size() > count) list.visible.resize(count);
+
+        for (auto row = 0; row < count; ++row)
+        {
+            auto optidx = list.filter[list.first + row];
+            const auto& option = state.options[optidx];
+            auto& widgets = list.rows[row];
+            auto selected = state.selected == optidx;
+            ImRect geometry;
+
+            // Highlight with the last frame's row slot, drawn first to stay behind the row
+            if (row < (int32_t)list.visible.size())
+            {
+                const auto& rect = list.visible[row].second;
+                if (selected || rect.Contains(mousepos))
+                    renderer.DrawRect(rect.Min, rect.Max, selected ? Config.focuscolor : 
+                        ToRGBA(0, 0, 0, 20), true);
+            }
+
+            if (option.first == WT_Checkbox)
+            {
+                if (widgets.checkbox == -1) widgets.checkbox = GetNextId(WT_Checkbox);
+                GetWidgetConfig(widgets.checkbox).state.checkbox->check = selected ? 
+                    CheckState::Checked : CheckState::Unchecked;
+                geometry = Widget(widgets.checkbox, WT_Checkbox, ToBottomRight, {}).geometry;
+                Move(FD_Horizontal);
+            }
+            else if (option.first == WT_ToggleButton)
+            {
+                if (widgets.toggle == -1) widgets.toggle = GetNextId(WT_ToggleButton);
+                GetWidgetConfig(widgets.toggle).state.toggle->checked = selected;
+                geometry = Widget(widgets.toggle, WT_ToggleButton, ToBottomRight, {}).geometry;
+                Move(FD_Horizontal);
+            }
+
+            if (widgets.label == -1) widgets.label = GetNextId(WT_Label);
+            GetWidgetConfig(widgets.label).state.label->text = option.second;
+            auto label = Widget(widgets.label, WT_Label, ToBottomRight, {}).geometry;
+            geometry = geometry.GetArea() > 0.f ? ImRect{ ImMin(geometry.Min, label.Min), ImMax(geometry.Max, label.Max) } : label;
+            Move(FD_Vertical);
+            popup.adhocLayout.top().nextpos.x = 0.f;
+
+            ImRect rect{ { 0.f, geometry.Min.y }, { width, geometry.Max.y } };
+            if (row < (int32_t)list.visible.size()) list.visible[row] = { optidx, rect };
+            else list.visible.emplace_back(optidx, rect);
+            list.rowHeight = std::max(list.rowHeight, geometry.GetHeight());
+        }
+
+        // Scroll thumb when not all options fit
+        if (count > 0 && count < total)
+        {
+            auto extent = list.visible.back().second.Max.y - top;
+            auto thumbh = std::max(extent * (float)count / (float)total, rowh * 0.5f);
+            auto thumby = top + (extent - thumbh) * (float)list.first / (float)(total - count);
+            renderer.DrawRect({ width - 4.f, thumby }, { width - 1.f, thumby + thumbh }, ToRGBA(100, 100, 100, 150), true);
+        }
+    }
+
     void HandleDropDownEvent(int32_t id, const ImRect& margin, const ImRect& border, const ImRect& padding,
         const ImRect& content, const IODescriptor& io, IRenderer& renderer, WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
+        auto& common = *context.GetState(id).data;
 
         if (!context.deferEvents)
         {
-            auto& state = context.GetState(id).state.dropdown;
+            auto& state = *context.GetState(id).state.dropdown;
             auto ismouseover = padding.Contains(io.mousepos);
-            state.state = !ismouseover ? WS_Default :
+            flags = !ismouseover ? WS_Default :
                 io.isLeftMouseDown() ? WS_Pressed | WS_Hovered : WS_Hovered;
             if (ismouseover) Config.platform->SetMouseCursor(MouseCursor::Grab);
             if (ismouseover && io.clicked())
@@ -2146,7 +2222,7 @@ namespace glimmer
                    /* if (state.inputId == -1)
                     {
                         state.inputId = GetNextId(WT_TextInput);
-                        auto& text = GetWidgetConfig(state.inputId).state.input.text;
+                        auto& text = GetWidgetConfig(state.inputId).state.input->text;
                         for (auto ch : state.text) text.push_back(ch);
                     }
 
@@ -2157,9 +2233,9 @@ namespace glimmer
                     // Create per dropdown input id
                 }
             }
-            else if (ismouseover && !state.tooltip.empty() && !io.isLeftMouseDown())
-                ShowTooltip(state._hoverDuration, margin, margin.Min, state.tooltip, io, renderer);
-            else state._hoverDuration == 0;
+            else if (ismouseover && !common.tooltip.empty() && !io.isLeftMouseDown())
+                ShowTooltip(common._hoverDuration, margin, margin.Min, common.tooltip, io, renderer);
+            else common._hoverDuration == 0;
 
             if (state.opened)
             {
@@ -2176,61 +2252,10 @@ namespace glimmer
                     if (state.ShowList)
                         state.ShowList(available1, available2, state);
                     else
-                    {
-                        auto& optstates = GetContext().parentContext->dropDownOptions[id & 0xffff];
-                        if (optstates.empty()) optstates.reserve(state.options.size());
-                        auto optidx = 0;
-
-                        for (const auto& option : state.options)
-                        {
-                            if ((int)optstates.size() <= optidx)
-                            {
-                                auto& optstate = optstates.emplace_back();
-                                switch (option.first)
-                                {
-                                case WT_Checkbox:
-                                {
-                                    optstate.first = GetNextId(WT_Checkbox);
-                                    optstate.second = GetNextId(WT_Label);
-                                    GetWidgetConfig(optstate.first).state.checkbox.check = state.selected == optidx ?
-                                        CheckState::Checked : CheckState::Unchecked;
-                                    GetWidgetConfig(optstate.second).state.label.text = option.second;
-                                    break;
-                                }
-                                case WT_ToggleButton:
-                                {
-                                    optstate.first = GetNextId(WT_ToggleButton);
-                                    optstate.second = GetNextId(WT_Label);
-                                    GetWidgetConfig(optstate.first).state.toggle.checked = state.selected == optidx;
-                                    GetWidgetConfig(optstate.second).state.label.text = option.second;
-                                    break;
-                                }
-                                case WT_Invalid:
-                                {
-                                    optstate.first = -1;
-                                    optstate.second = GetNextId(WT_Label);
-                                    GetWidgetConfig(optstate.first).state.toggle.checked = state.selected == optidx;
-                                    break;
-                                }
-                                default: break;
-                                }
-                            }
-
-                            auto& optstate = optstates[optidx];
-                            if (optstate.first != -1)
-                            {
-                                auto type = (WidgetType)(optstate.first >> 16);
-                                Widget(optstate.first, type, ToBottomRight, {});
-                                Move(FD_Horizontal);
-                            }
-                            Widget(optstate.second, WT_Label, ToBottomRight, {});
-                            Move(FD_Vertical);
-                            GetContext().adhocLayout.top().nextpos.x = 0.f;
-                            optidx++;
-                        }
-                    }
+                        ShowDropDownList(id, state, std::max(available1.y, available2.y), border.GetWidth(), result);
 
                     EndPopUp();
+                    GetDropDownList(context, id).region = context.activePopUpRegion;
                 }
             }
             else context.activePopUpRegion = ImRect{};
@@ -2243,13 +2268,14 @@ namespace glimmer
     {
         WidgetDrawResult result;
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
 
         DrawBoxShadow(border.Min, border.Max, style, renderer);
         DrawBackground(border.Min, border.Max, style, renderer);
         DrawBorderRect(border.Min, border.Max, style.border, style.bgcolor, renderer);
 
         if (!(state.opened && state.isComboBox))
-            DrawText(content.Min, content.Max, text, state.text, state.state & WS_Disabled, style, renderer);
+            DrawText(content.Min, content.Max, text, state.text, flags & WS_Disabled, style, renderer);
 
         auto arrowh = style.font.size * 0.33333f;
         auto arroww = style.font.size * 0.25f;
@@ -2266,13 +2292,52 @@ namespace glimmer
 
 #pragma region TabBar
 
+    // A tab bar only uses a handful of style states, resolve each once per pass over the tabs
+    struct TabStyleCache
+    {
+        StyleDescriptor styles[4];
+        int32_t flags[4] = { -1, -1, -1, -1 };
+
+        const StyleDescriptor& get(int32_t flag)
+        {
+            auto idx = 0;
+            for (; idx < 3 && flags[idx] != -1; ++idx)
+                if (flags[idx] == flag) return styles[idx];
+            if (flags[idx] != flag)
+            {
+                styles[idx] = WidgetContextData::GetStyle(flag);
+                flags[idx] = flag;
+            }
+            return styles[idx];
+        }
+    };
+
+    static ImVec2 MeasureTab(TabBarInternalState::ItemDescriptor& tab, const TabItemDescriptor& item,
+        const StyleDescriptor& style, IRenderer& renderer)
+    {
+        auto hash = std::hash<std::string_view>{}(item.name);
+
+        if (tab.nameHash != hash || tab.nameType != item.nameType || tab.font != style.font.font ||
+            tab.fontsz != style.font.size)
+        {
+            tab.textsz = GetTextSize(item.nameType, item.name, style.font, -1.f, renderer);
+            tab.nameHash = hash;
+            tab.nameType = item.nameType;
+            tab.font = style.font.font;
+            tab.fontsz = style.font.size;
+        }
+
+        return tab.textsz;
+    }
+
     // TODO: Find a faster bounds computation method, move detailed computation to draw method?
     ImRect TabBarBounds(int32_t id, const ImRect& content, IRenderer& renderer)
     {
         ImRect result;
         auto& context = GetContext();
         auto& state = context.TabBarState(id);
-        const auto& config = context.GetState(id).state.tab;
+        const auto& config = *context.GetState(id).state.tab;
+        TabStyleCache styles;
         int16_t tabidx = 0, lastRowStart = 0;
         auto height = 0.f, width = 0.f;
         auto fontsz = 0.f;
@@ -2286,8 +2351,8 @@ namespace glimmer
                 auto& tab = state.tabs[tabidx];
                 auto flag = tabidx == state.current ? WS_Focused : tabidx == state.hovered ? WS_Hovered :
                     (tab.state & TI_Disabled) ? WS_Disabled : WS_Default;
-                const auto style = WidgetContextData::GetStyle(flag);
-                auto txtsz = renderer.GetTextSize(item.name, style.font.font, style.font.size);
+                const auto& style = styles.get(flag);
+                auto txtsz = MeasureTab(tab, item, style, renderer);
                 tab.extent.Min = offset;
 
                 switch (context.currentTab.sizing)
@@ -2453,9 +2518,8 @@ namespace glimmer
                 auto& tab = state.tabs[tabidx];
                 auto flag = tabidx == state.current ? WS_Selected : tabidx == state.hovered ? WS_Hovered :
                     (tab.state & TI_Disabled) ? WS_Disabled : WS_Default;
-                const auto style = WidgetContextData::GetStyle(flag);
-                auto txtsz = item.nameType == TextType::PlainText ? renderer.GetTextSize(item.name, style.font.font, style.font.size) : 
-                    ImVec2{ style.font.size, style.font.size };
+                const auto& style = styles.get(flag);
+                auto txtsz = MeasureTab(tab, item, style, renderer);
                 tab.extent.Min = offset;
 
                 switch (context.currentTab.sizing)
@@ -2550,10 +2614,7 @@ namespace glimmer
             for (auto& tab : state.tabs)
             {
                 auto& rect = tab.extent;
-                auto flag = tabidx == state.current ? WS_Selected : tabidx == state.hovered ? WS_Hovered :
-                    (state.tabs[tabidx].state & TI_Disabled) ? WS_Disabled : WS_Default;
-                const auto style = WidgetContextData::GetStyle(flag);
-                
+
                 if (tab.close.Contains(io.mousepos) && io.clicked())
                 {
                     result.event = WidgetEvent::Clicked;
@@ -2616,17 +2677,24 @@ namespace glimmer
         WidgetDrawResult result;
         auto& context = GetContext();
         auto& state = context.TabBarState(id);
-        const auto& config = context.GetState(id).state.tab;
-        auto tabidx = 0;
+        const auto& config = *context.GetState(id).state.tab;
+        TabStyleCache styles;
+        auto tabidx = -1;
         
         for (const auto& tab : state.tabs)
         {
             auto& rect = tab.extent;
+            tabidx++;
+
+            // Tabs scrolled out or moved to the overflow drop-down have nothing to draw
+            if (rect.GetArea() <= 0.f || rect.Max.x < content.Min.x || rect.Min.x > content.Max.x ||
+                rect.Max.y < content.Min.y || rect.Min.y > content.Max.y) continue;
+
             auto flag = tabidx == state.current ? WS_Selected : tabidx == state.hovered ? WS_Hovered :
                 (tab.state & TI_Disabled) ? WS_Disabled : WS_Default;
             //BREAK_IF(flag & WS_Selected);
 
-            const auto style = WidgetContextData::GetStyle(flag);
+            const auto& style = styles.get(flag);
             const auto& specificStyle = context.tabBarStyles[log2((unsigned)flag)].top();
             auto darker = DarkenColor(style.bgcolor);
             
@@ -2677,7 +2745,6 @@ namespace glimmer
             }
 
             renderer.ResetClipRect();
-            tabidx++;
         }
 
         if (state.create.GetArea() > 0.f)
@@ -2713,7 +2780,7 @@ namespace glimmer
         tab.id = context.layouts.empty() ? id : (int32_t)(context.layouts.top().tabbars.size() - 1);
         tab.geometry = geometry; tab.neighbors = neighbors;
 
-        const auto& config = context.GetState(id).state.tab;
+        const auto& config = *context.GetState(id).state.tab;
         tab.sizing = config.sizing;
         tab.newTabButton = config.createNewTabs;
         return true;
@@ -2830,8 +2897,8 @@ namespace glimmer
         const auto style = WidgetContextData::GetStyle(state.hstates[accordion.totalRegions]);
         auto haswrap = !(style.font.flags & FontStyleNoWrap) && !(style.font.flags & FontStyleOverflowEllipsis) &&
             !(style.font.flags & FontStyleOverflowMarquee);
-        accordion.textsz = Config.renderer->GetTextSize(content, style.font.font, style.font.size, 
-            haswrap ? accordion.content.GetWidth() : -1.f);
+        accordion.textsz = GetTextSize(isRichText ? TextType::RichText : TextType::PlainText, content, style.font,
+            haswrap ? accordion.content.GetWidth() : -1.f, *Config.renderer);
         accordion.headerHeight = accordion.textsz.y;
         accordion.text = content;
         accordion.isRichText = isRichText;
@@ -3026,7 +3093,7 @@ namespace glimmer
         content.Max = { accordion.content.Max.x, accordion.content.Min.y + offset.y };
         content.Max += ImVec2{ accordion.spacing.right, accordion.spacing.bottom };
         content.Min -= ImVec2{ accordion.spacing.left, accordion.spacing.top };
-        context.deferedEvents.clear(true);
+        context.deferedEvents.clear(false);
         context.ToggleDeferedRendering(false, true);
         context.AddItemGeometry(accordion.id, content);
         context.accordions.pop(1, false);
@@ -3242,16 +3309,17 @@ namespace glimmer
         const IODescriptor& io, IRenderer& renderer, WidgetDrawResult& result)
     {
         auto& context = GetContext();
+        auto& flags = context.states.flags(id);
 
         if (!context.deferEvents)
         {
-            auto& state = context.GetState(id).state.grid;
+            auto& state = *context.GetState(id).state.grid;
             auto& headers = state.config.headers;
             auto& gridstate = context.GridState(id);
 
             auto mousepos = io.mousepos;
             auto ismouseover = padding.Contains(mousepos);
-            state.state = !ismouseover ? WS_Default :
+            flags = !ismouseover ? WS_Default :
                 io.isLeftMouseDown() ? WS_Pressed | WS_Hovered : WS_Hovered;
             HandleScrollBars(gridstate.scroll, renderer, content, gridstate.totalsz, io);
 
@@ -3302,7 +3370,7 @@ namespace glimmer
         {
         case WT_Label:
         {
-            auto itemstyle = context.GetStyle(model.state.label.state);
+            auto itemstyle = context.GetStyle(model.flags);
             if (itemstyle.font.font == nullptr) itemstyle.font.font = GetFont(itemstyle.font.family,
                 itemstyle.font.size, FT_Normal);
 
@@ -3323,7 +3391,7 @@ namespace glimmer
             DrawBackground(itemcontent.Min, itemcontent.Max, itemstyle, renderer);
             renderer.DrawRect(itemcontent.Min, itemcontent.Max, ToRGBA(100, 100, 100), false);
             DrawText(textstart, textend, { textstart, textstart + textsz }, model.state.label.text,
-                model.state.label.state & WS_Disabled, itemstyle, renderer);
+                model.flags & WS_Disabled, itemstyle, renderer);
             break;
         }
         /*case WT_Custom:
@@ -3347,7 +3415,7 @@ namespace glimmer
     {
         WidgetDrawResult result;
         auto& context = GetContext();
-        auto& state = context.GetState(id).state.grid;
+        auto& state = *context.GetState(id).state.grid;
         auto& gridstate = context.GridState(id);
         auto mousepos = io.mousepos;
 
@@ -3375,11 +3443,10 @@ namespace glimmer
                     auto totalEx = 0;
                     auto height = 0.f;
 
+                    gridstate.ensureColumns(level, (int16_t)headers[level].size());
+
                     for (int16_t vcol = 0; vcol < (int16_t)headers[level].size(); ++vcol)
                     {
-                        if (gridstate.cols[level].empty())
-                            gridstate.cols[level].fill(ItemGridInternalState::HeaderCellResizeState{});
-
                         if (gridstate.colmap[level].vtol[vcol] == -1)
                         {
                             gridstate.colmap[level].ltov[vcol] = vcol;
@@ -3389,7 +3456,7 @@ namespace glimmer
                         auto col = gridstate.colmap[level].vtol[vcol];
                         auto& hdr = headers[level][col];
 
-                        static char buffer[256];
+                        static thread_local char buffer[256];
                         memset(buffer, ' ', 255);
                         buffer[255] = 0;
 
@@ -3458,8 +3525,7 @@ namespace glimmer
                 else
                 {
                     float lastx = 0.f, height = 0.f;
-                    if (gridstate.cols[level].empty())
-                        gridstate.cols[level].fill(ItemGridInternalState::HeaderCellResizeState{});
+                    gridstate.ensureColumns(level, (int16_t)headers[level].size());
 
                     for (int16_t vcol = 0; vcol < (int16_t)headers[level].size(); ++vcol)
                     {
@@ -3838,8 +3904,6 @@ namespace glimmer
     void StartSplitRegion(int32_t id, Direction dir, const std::initializer_list<SplitRegion>& splits,
         int32_t geometry, const NeighborWidgets& neighbors)
     {
-        assert((int)splits.size() < GLIMMER_MAX_SPLITTER_REGIONS);
-
         LayoutItemDescriptor layoutItem;
         AddExtent(layoutItem, neighbors);
         auto& context = GetContext();
@@ -3851,6 +3915,7 @@ namespace glimmer
         auto& state = context.SplitterState(id);
         const auto style = WidgetContextData::GetStyle(WS_Default);
         state.current = 0;
+        if (state.regions.size() < splits.size()) state.regions.resize(splits.size());
 
         auto& renderer = context.GetRenderer();
         renderer.SetClipRect(layoutItem.margin.Min, layoutItem.margin.Max);
@@ -3865,21 +3930,22 @@ namespace glimmer
 
         for (const auto& split : splits)
         {
-            if (state.spacing[idx].curr == -1.f)
+            auto& region = state.regions[idx];
+            if (region.spacing.curr == -1.f)
             {
-                state.spacing[idx].curr = split.initial;      
+                region.spacing.curr = split.initial;      
             }
 
-            auto regionEnd = prev + (el.dir == DIR_Vertical ? ImVec2{ width, state.spacing[idx].curr * height } :
-                ImVec2{ state.spacing[idx].curr * width, height });
+            auto regionEnd = prev + (el.dir == DIR_Vertical ? ImVec2{ width, region.spacing.curr * height } :
+                ImVec2{ region.spacing.curr * width, height });
 
             auto scid = GetNextId(WT_SplitterRegion);
-            state.viewport[idx] = ImRect{ prev, regionEnd };
-            state.containers[idx] = scid;
-            context.AddItemGeometry(state.containers[idx], state.viewport[idx], true);
+            region.viewport = ImRect{ prev, regionEnd };
+            region.container = scid;
+            context.AddItemGeometry(region.container, region.viewport, true);
 
-            state.spacing[idx].min = split.min;
-            state.spacing[idx].max = split.max;
+            region.spacing.min = split.min;
+            region.spacing.max = split.max;
             prev = regionEnd;
             el.dir == DIR_Vertical ? prev.x = layoutItem.margin.Min.x : prev.y = layoutItem.margin.Min.y;
             el.dir == DIR_Vertical ? prev.y += splittersz : prev.x += splittersz;
@@ -3887,9 +3953,9 @@ namespace glimmer
         }
 
         auto& layout = context.adhocLayout.top();
-        layout.nextpos = state.viewport[state.current].Min;
-        context.containerStack.push() = state.containers[state.current];
-        renderer.SetClipRect(state.viewport[state.current].Min, state.viewport[state.current].Max);
+        layout.nextpos = state.regions[state.current].viewport.Min;
+        context.containerStack.push() = state.regions[state.current].container;
+        renderer.SetClipRect(state.regions[state.current].viewport.Min, state.regions[state.current].viewport.Max);
     }
 
     void NextSplitRegion()
@@ -3903,16 +3969,17 @@ namespace glimmer
         const auto width = el.extent.GetWidth(), height = el.extent.GetHeight();
         auto& renderer = context.GetRenderer();
 
-        assert(state.current < GLIMMER_MAX_SPLITTER_REGIONS);
+        assert(state.current + 1 < (int)state.regions.size());
+        auto& region = state.regions[state.current];
 
         auto splittersz = el.dir == DIR_Vertical ? (style.dimension.y > 0.f ? style.dimension.y : Config.splitterSize) :
             style.dimension.x > 0.f ? style.dimension.x : Config.splitterSize;
-        auto scid = state.containers[state.current];
+        auto scid = region.container;
         renderer.ResetClipRect();
         context.containerStack.pop(1, true);
 
-        auto nextpos = el.dir == DIR_Vertical ? ImVec2{ el.extent.Min.x, state.viewport[state.current].Max.y } :
-            ImVec2{ state.viewport[state.current].Max.x, el.extent.Min.y };
+        auto nextpos = el.dir == DIR_Vertical ? ImVec2{ el.extent.Min.x, region.viewport.Max.y } :
+            ImVec2{ region.viewport.Max.x, el.extent.Min.y };
         auto sz = (el.dir == DIR_Vertical ? ImVec2{ width, splittersz } : ImVec2{ splittersz, height });
 
         renderer.SetClipRect(nextpos, nextpos + sz);
@@ -3943,50 +4010,49 @@ namespace glimmer
         }
         renderer.ResetClipRect();
 
-        if (ImRect{ nextpos, nextpos + sz }.Contains(mousepos) || state.isdragged[state.current])
+        if (ImRect{ nextpos, nextpos + sz }.Contains(mousepos) || region.isdragged)
         {
             Config.platform->SetMouseCursor(el.dir == DIR_Vertical ? MouseCursor::ResizeVertical :
                 MouseCursor::ResizeHorizontal);
             auto isDrag = io.isLeftMouseDown();
-            state.states[state.current] = isDrag ? WS_Pressed | WS_Hovered : WS_Hovered;
+            region.state = isDrag ? WS_Pressed | WS_Hovered : WS_Hovered;
 
             if (isDrag)
             {
-                if (!state.isdragged[state.current])
+                if (!region.isdragged)
                 {
-                    state.isdragged[state.current] = true;
-                    state.dragstart[state.current] = el.dir == DIR_Vertical ? mousepos.y : mousepos.x;
+                    region.isdragged = true;
+                    region.dragstart = el.dir == DIR_Vertical ? mousepos.y : mousepos.x;
                 }
                 else
                 {
-                    auto amount = el.dir == DIR_Vertical ? (mousepos.y - state.dragstart[state.current]) / height :
-                        (mousepos.x - state.dragstart[state.current]) / width;
-                    auto prev = state.spacing[state.current].curr;
-                    state.spacing[state.current].curr = clamp(prev + amount, state.spacing[state.current].min, state.spacing[state.current].max);
-                    auto diff = prev - state.spacing[state.current].curr;
+                    auto amount = el.dir == DIR_Vertical ? (mousepos.y - region.dragstart) / height :
+                        (mousepos.x - region.dragstart) / width;
+                    auto prev = region.spacing.curr;
+                    region.spacing.curr = clamp(prev + amount, region.spacing.min, region.spacing.max);
+                    auto diff = prev - region.spacing.curr;
 
                     if (diff != 0.f)
                     {
-                        state.dragstart[state.current] = el.dir == DIR_Vertical ? mousepos.y : mousepos.x;
-                        state.spacing[state.current + 1].curr += diff;
+                        region.dragstart = el.dir == DIR_Vertical ? mousepos.y : mousepos.x;
+                        state.regions[state.current + 1].spacing.curr += diff;
                     } 
                 }
             }
-            else state.isdragged[state.current] = false;
+            else region.isdragged = false;
         }
         else if (!io.isLeftMouseDown())
         {
-            state.states[state.current] = WS_Default;
-            state.isdragged[state.current] = false;
+            region.state = WS_Default;
+            region.isdragged = false;
         }
 
         state.current++;
-        assert(state.current < GLIMMER_MAX_SPLITTER_REGIONS);
 
         auto& layout = context.adhocLayout.top();
-        layout.nextpos = state.viewport[state.current].Min;
-        context.containerStack.push() = state.containers[state.current];
-        renderer.SetClipRect(state.viewport[state.current].Min, state.viewport[state.current].Max);
+        layout.nextpos = state.regions[state.current].viewport.Min;
+        context.containerStack.push() = state.regions[state.current].container;
+        renderer.SetClipRect(state.regions[state.current].viewport.Min, state.regions[state.current].viewport.Max);
     }
 
     void EndSplitRegion()
@@ -4058,145 +4124,815 @@ namespace glimmer
         }
 
         overlayctx.ToggleDeferedRendering(false);
-        overlayctx.deferedEvents.clear(true);
+        overlayctx.deferedEvents.clear(false);
         PopContext();
         return result;
     }
 
 #pragma endregion
 
-#pragma region Dynamic ItemGrid
+#pragma region ItemGrid Row Order
 
-    void RecordItemGeometry(const LayoutItemDescriptor& layoutItem)
+    struct RowSortEntry
     {
-        auto& context = GetContext();
-
-        if (context.CurrentItemGridContext != nullptr)
-        {
-            auto& grid = context.CurrentItemGridContext->itemGrids.top();
-            if (grid.phase == ItemGridConstructPhase::HeaderCells)
-            {
-                grid.maxHeaderExtent.x = std::max(grid.maxHeaderExtent.x, layoutItem.margin.Max.x);
-                grid.maxHeaderExtent.y = std::max(grid.maxHeaderExtent.y, layoutItem.margin.Max.y);
-            }
-            else
-            {
-                grid.maxCellExtent.x = std::max(grid.maxCellExtent.x, layoutItem.margin.Max.x);
-                grid.maxCellExtent.y = std::max(grid.maxCellExtent.y, layoutItem.margin.Max.y);
-            }
-        }
-    }
+        ItemGridSortKey key; // key of the first sort column, kept inline for locality
+        int32_t row = 0;
+    };
 
-    bool StartItemGrid(int32_t id, int32_t geometry, const NeighborWidgets& neighbors)
+    // Keys of all sort columns travel with the row, so radix passes never gather keys at random
+    template <int Cols>
+    struct RowRadixEntry
     {
-        auto& context = GetContext();
-        auto& state = context.itemGrids.push();
-        const auto style = WidgetContextData::GetStyle(WS_Default);
-
-        state.id = id;
-        state.geometry = geometry;
-        state.neighbors = neighbors;
-        state.origin = context.NextAdHocPos() + ImVec2{ style.margin.left + style.border.left.thickness + style.padding.left,
-            style.margin.top + style.border.top.thickness + style.padding.top };
-        state.nextpos = state.origin;
-
-        LayoutItemDescriptor item;
-        AddExtent(item, style, neighbors);
-        state.size = item.content.GetSize();
+        uint64_t keys[Cols];
+        int32_t row;
+    };
 
-        context.CurrentItemGridContext = &context;
-        auto& ctx = PushContext(id);
-        auto& el = ctx.nestedContextStack.push();
-        el.base = &context;
-        el.source = NestedContextSourceType::ItemGrid;
+    static thread_local std::vector<ItemGridSortKey> RowSortKeys;
+    static thread_local std::vector<RowSortEntry> RowSortEntries;
+    static thread_local std::vector<int32_t> RowSortChunks;
+    static thread_local std::vector<std::array<uint32_t, 256>> RowRadixCounts;
 
-        return true;
+    static int CompareSortKeys(const ItemGridSortKey& lhs, const ItemGridSortKey& rhs, bool ascending)
+    {
+        auto res = lhs.number < rhs.number ? -1 : lhs.number > rhs.number ? 1 : 
+            lhs.text.compare(rhs.text);
+        return ascending ? res : -res;
     }
 
-    bool StartItemGridHeader(int levels)
+    // Maps a double to an unsigned integer with the same ordering, negative values have all
+    // their bits flipped and positive values only the sign bit
+    static uint64_t OrderedBits(double value, bool ascending)
     {
-        assert(levels > 0 && levels <= 4);
-        auto& context = *WidgetContextData::CurrentItemGridContext;
-        auto& state = context.itemGrids.top();
-        auto& itemcfg = context.GetState(state.id).state.grid;
-
-        state.phase = ItemGridConstructPhase::Headers;
-        state.levels = levels;
-        state.currlevel = state.levels - 1;
-        state.currCol = 0;
-        state.nextpos = state.origin + ImVec2{ itemcfg.gridwidth, itemcfg.gridwidth };
-
-        auto& ctx = GetContext();
-        ctx.ToggleDeferedRendering(true, false);
-        ctx.deferEvents = true;
-
-        return true;
+        auto bits = std::bit_cast<uint64_t>(value == 0.0 ? 0.0 : value);
+        bits = (bits >> 63) ? ~bits : bits | (1ull << 63);
+        return ascending ? bits : ~bits;
     }
 
-    static void InitColumnResizeData(WidgetContextData& context, CurrentItemGridState& state, ColumnProps& header)
+    static void PrepareRowChunks(int32_t total)
     {
-        auto& gridstate = context.GridState(state.id);
-        if (gridstate.cols[state.currlevel].empty())
-            gridstate.cols[state.currlevel].fill(ItemGridInternalState::HeaderCellResizeState{});
-        if (gridstate.cols[state.currlevel].size() <= state.currCol)
-            gridstate.cols[state.currlevel].expand(128, true);
+        auto chunks = total >= GLIMMER_PARALLEL_SORT_MIN ? std::clamp((int32_t)std::thread::hardware_concurrency(),
+            1, GLIMMER_MAX_SORT_THREADS) : 1;
+        RowSortChunks.resize(chunks);
+        std::iota(RowSortChunks.begin(), RowSortChunks.end(), 0);
     }
 
-    static void AddUserColumnResize(WidgetContextData& context, CurrentItemGridState& state, ColumnProps& header)
+    // Splits [0, total) into contiguous chunks, one per hardware thread for large grids (see
+    // PrepareRowChunks), and invokes fn(chunk, from, to) for each of them in parallel
+    template <typename FnT>
+    static void ForEachRowChunk(int32_t total, FnT&& fn)
     {
-        auto& gridstate = context.GridState(state.id);
-        InitColumnResizeData(context, state, header);
-        auto modified = gridstate.cols[state.currlevel][state.currCol].modified;
-        header.extent.Max.x += modified;
+        auto chunks = (int32_t)RowSortChunks.size();
+        auto invoke = [&fn, chunks, total](int32_t chunk) {
+            fn(chunk, (int32_t)((int64_t)total * chunk / chunks), (int32_t)((int64_t)total * (chunk + 1) / chunks));
+        };
+
+        if (chunks == 1) invoke(0);
+        else std::for_each(std::execution::par, RowSortChunks.begin(), RowSortChunks.end(), invoke);
     }
 
-    // Only compute bounds, position them in header end (for visual order)
-    // Integrate layout mechanism, add max computation?
-    void StartHeaderColumn(const ItemGridState::ColumnConfig& config)
+    // LSD radix sort over the bytes of the sort keys, from the last sort column's lowest byte to the
+    // first column's highest byte. Every pass is stable, so ties stay in logical row order. Bytes in
+    // which all keys agree are skipped, so integral or low precision keys take only a few passes.
+    // Each pass histograms and scatters contiguous chunks in parallel, chunk c writes its rows of
+    // digit d after those of all lower digits and those of digit d in chunks before c.
+    template <int Cols>
+    static void RadixSortRows(ItemGridInternalState::RowPermutation& rowmap, int32_t total)
     {
-        auto& context = *WidgetContextData::CurrentItemGridContext;
-        auto& state = context.itemGrids.top();
-        auto& header = state.headers[state.currlevel].emplace_back(config);
-        auto& itemcfg = context.GetState(state.id).state.grid;
-        auto& renderer = GetContext().GetRenderer();
-        const auto style = WidgetContextData::GetStyle(itemcfg.state);
+        using EntryT = RowRadixEntry<Cols>;
+        static thread_local std::vector<EntryT> entries, scratch;
+        auto chunks = (int32_t)RowSortChunks.size();
+        auto keys = RowSortKeys.data();
+        auto sortcols = rowmap.sortcols;
+        entries.resize(total);
+        scratch.resize(total);
+        RowRadixCounts.resize((size_t)chunks * Cols * 8);
+        auto counts = RowRadixCounts.data();
+        auto source = entries.data(), dest = scratch.data();
+        auto moved = false;
+
+        ForEachRowChunk(total, [=](int32_t chunk, int32_t from, int32_t to) {
+            auto histograms = counts + (size_t)chunk * Cols * 8;
+            for (auto idx = 0; idx < Cols * 8; ++idx) histograms[idx].fill(0);
+
+            for (auto row = from; row < to; ++row)
+            {
+                source[row].row = row;
 
-        state.phase = ItemGridConstructPhase::HeaderCells;
-        header.extent.Min = state.nextpos;
-        header.content.Min = header.extent.Min + itemcfg.cellpadding;
-        static char buffer[256] = { 0 };
+                for (auto col = 0; col < Cols; ++col)
+                {
+                    auto key = OrderedBits(keys[(size_t)col * total + row].number, sortcols[col].ascending);
+                    source[row].keys[col] = key;
+                    for (auto byte = 0; byte < 8; ++byte) histograms[col * 8 + byte][(key >> (byte * 8)) & 255]++;
+                }
+            }
+        });
 
-        if (state.currlevel == (state.levels - 1))
+        for (auto col = Cols - 1; col >= 0; --col)
         {
-            memset(buffer, ' ', 255);
-
-            auto width = (config.props & COL_WidthAbsolute) ? config.width :
-                config.width > 0.f ? renderer.GetTextSize(std::string_view{ buffer, (size_t)config.width },
-                    style.font.font, style.font.size).x : FLT_MAX;
+            for (auto byte = 0; byte < 8; ++byte)
+            {
+                auto pass = col * 8 + byte;
+                auto shift = byte * 8;
+                uint32_t totals[256] = {};
+                for (auto chunk = 0; chunk < chunks; ++chunk)
+                    for (auto digit = 0; digit < 256; ++digit)
+                        totals[digit] += counts[(size_t)chunk * Cols * 8 + pass][digit];
+                if (totals[(source[0].keys[col] >> shift) & 255] == (uint32_t)total) continue;
+
+                // Chunk histograms of the remaining passes are stale once rows move, recount this one
+                if (moved)
+                    ForEachRowChunk(total, [=](int32_t chunk, int32_t from, int32_t to) {
+                        auto& histogram = counts[(size_t)chunk * Cols * 8 + pass];
+                        histogram.fill(0);
+                        for (auto row = from; row < to; ++row) histogram[(source[row].keys[col] >> shift) & 255]++;
+                    });
+
+                uint32_t sum = 0;
+                for (auto digit = 0; digit < 256; ++digit)
+                    for (auto chunk = 0; chunk < chunks; ++chunk)
+                    {
+                        auto& count = counts[(size_t)chunk * Cols * 8 + pass][digit];
+                        auto current = count;
+                        count = sum;
+                        sum += current;
+                    }
 
-            header.content.Max.x = header.content.Min.x + width;
-            header.extent.Max.x = width == FLT_MAX ? FLT_MAX : header.content.Max.x + itemcfg.cellpadding.x;
-            if (width != FLT_MAX) AddUserColumnResize(context, state, header);
-        }
-        else assert(false); // For higher levels, use column category APIs
+                ForEachRowChunk(total, [=](int32_t chunk, int32_t from, int32_t to) {
+                    auto& offsets = counts[(size_t)chunk * Cols * 8 + pass];
+                    for (auto row = from; row < to; ++row)
+                        dest[offsets[(source[row].keys[col] >> shift) & 255]++] = source[row];
+                });
 
-        if (config.width != 0.f)
-        {
-            auto& ctx = GetContext();
-            auto& id = ctx.containerStack.push();
-            id = state.id;
-            state.addedBounds = true;
+                std::swap(source, dest);
+                moved = true;
+            }
         }
 
-        GetContext().adhocLayout.top().nextpos = state.nextpos;
+        rowmap.vtol.resize(total);
+        auto order = rowmap.vtol.data();
+        ForEachRowChunk(total, [=](int32_t, int32_t from, int32_t to) {
+            for (auto idx = from; idx < to; ++idx) order[idx] = source[idx].row;
+        });
     }
 
-    void EndHeaderColumn()
+    // Comparison sort of (first key, row) pairs for keys with text, ties are broken by logical
+    // row which makes the order stable without paying for a stable sort
+    static void CompareSortRows(ItemGridInternalState::RowPermutation& rowmap, int32_t total)
     {
-        auto& context = *WidgetContextData::CurrentItemGridContext;
-        auto& state = context.itemGrids.top();
-        const auto& itemcfg = context.GetState(state.id).state.grid;
-        const auto& header = state.currentHeader();
+        auto ncols = rowmap.totalSortCols;
+        RowSortEntries.resize(total);
+        for (auto row = 0; row < total; ++row)
+            RowSortEntries[row] = RowSortEntry{ RowSortKeys[row], row };
+
+        // Comparisons may run on worker threads, hence capture the key storage and not the thread_local
+        auto keys = RowSortKeys.data();
+        auto sortcols = rowmap.sortcols;
+        auto precedes = [keys, sortcols, ncols, total](const RowSortEntry& lhs, const RowSortEntry& rhs) {
+            auto res = CompareSortKeys(lhs.key, rhs.key, sortcols[0].ascending);
+
+            for (auto idx = 1; idx < ncols && res == 0; ++idx)
+            {
+                auto column = keys + (size_t)idx * total;
+                res = CompareSortKeys(column[lhs.row], column[rhs.row], sortcols[idx].ascending);
+            }
+
+            return res != 0 ? res < 0 : lhs.row < rhs.row;
+        };
+
+        if (total >= GLIMMER_PARALLEL_SORT_MIN)
+            std::sort(std::execution::par, RowSortEntries.begin(), RowSortEntries.end(), precedes);
+        else
+            std::sort(RowSortEntries.begin(), RowSortEntries.end(), precedes);
+
+        rowmap.vtol.resize(total);
+        for (auto idx = 0; idx < total; ++idx)
+            rowmap.vtol[idx] = RowSortEntries[idx].row;
+    }
+
+    // Extracts every row's keys once (column-wise), numeric keys are radix sorted while keys
+    // with text fall back to a (parallel for large grids) comparison sort
+    static void SortAllRows(ItemGridInternalState::RowPermutation& rowmap, const ItemGridState& config,
+        int32_t total)
+    {
+        auto numeric = true;
+        RowSortKeys.resize((size_t)total * rowmap.totalSortCols);
+
+        for (auto idx = 0; idx < rowmap.totalSortCols; ++idx)
+        {
+            auto column = RowSortKeys.data() + (size_t)idx * total;
+
+            for (auto row = 0; row < total; ++row)
+            {
+                column[row] = config.sortkey(row, rowmap.sortcols[idx].col);
+                numeric = numeric && column[row].text.empty();
+            }
+        }
+
+        PrepareRowChunks(total);
+        static_assert(GLIMMER_MAX_GRID_SORT_COLUMNS <= 4);
+        if (!numeric) CompareSortRows(rowmap, total);
+        else switch (rowmap.totalSortCols)
+        {
+        case 1: RadixSortRows<1>(rowmap, total); break;
+        case 2: RadixSortRows<2>(rowmap, total); break;
+        case 3: RadixSortRows<3>(rowmap, total); break;
+        default: RadixSortRows<4>(rowmap, total); break;
+        }
+
+        rowmap.ltov.resize(total);
+        auto order = rowmap.vtol.data();
+        auto inverse = rowmap.ltov.data();
+        ForEachRowChunk(total, [=](int32_t, int32_t from, int32_t to) {
+            for (auto idx = from; idx < to; ++idx) inverse[order[idx]] = idx;
+        });
+    }
+
+    // Removes the changed rows from the display order, sorts them among themselves and merges them
+    // back in one pass. The position of each is found by binary search in the remaining rows, starting
+    // from the previous one's, so only O(k log n) keys are extracted and the merge is O(n).
+    static void ResortRows(ItemGridInternalState::RowPermutation& rowmap, const ItemGridState& config,
+        int32_t total)
+    {
+        static thread_local std::vector<int32_t> order, merged;
+        auto& changed = rowmap.changed;
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+        while (!changed.empty() && changed.back() >= total) changed.pop_back();
+
+        rowmap.ltov.resize(total, 0);
+        for (auto row : changed) rowmap.ltov[row] = -1;
+        std::erase_if(rowmap.vtol, [&rowmap](int32_t row) { return rowmap.ltov[row] == -1; });
+
+        auto ncols = rowmap.totalSortCols;
+        auto count = (int32_t)changed.size();
+        RowSortKeys.resize((size_t)count * ncols);
+
+        for (auto cidx = 0; cidx < count; ++cidx)
+            for (auto idx = 0; idx < ncols; ++idx)
+                RowSortKeys[(size_t)cidx * ncols + idx] = config.sortkey(changed[cidx], rowmap.sortcols[idx].col);
+
+        auto keysOf = [ncols](int32_t cidx) { return RowSortKeys.data() + (size_t)cidx * ncols; };
+
+        order.resize(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int32_t lhs, int32_t rhs) {
+            auto lkeys = keysOf(lhs), rkeys = keysOf(rhs);
+            for (auto idx = 0; idx < ncols; ++idx)
+            {
+                auto res = CompareSortKeys(lkeys[idx], rkeys[idx], rowmap.sortcols[idx].ascending);
+                if (res != 0) return res < 0;
+            }
+
+            return changed[lhs] < changed[rhs];
+        });
+
+        auto precedes = [&](int32_t cidx, int32_t other) {
+            auto keys = keysOf(cidx);
+            for (auto idx = 0; idx < ncols; ++idx)
+            {
+                auto res = CompareSortKeys(keys[idx], config.sortkey(other, rowmap.sortcols[idx].col),
+                    rowmap.sortcols[idx].ascending);
+                if (res != 0) return res < 0;
+            }
+
+            return changed[cidx] < other;
+        };
+
+        merged.clear();
+        merged.reserve(total);
+        auto from = rowmap.vtol.begin();
+
+        for (auto cidx : order)
+        {
+            auto pos = std::upper_bound(from, rowmap.vtol.end(), cidx, precedes);
+            merged.insert(merged.end(), from, pos);
+            merged.push_back(changed[cidx]);
+            from = pos;
+        }
+
+        merged.insert(merged.end(), from, rowmap.vtol.end());
+        rowmap.vtol.swap(merged);
+
+        for (auto idx = 0; idx < total; ++idx)
+            rowmap.ltov[rowmap.vtol[idx]] = idx;
+    }
+
+    static bool ContainsText(std::string_view text, std::string_view pattern, bool caseSensitive, bool prefix)
+    {
+        if (pattern.empty()) return true;
+        if (prefix && text.size() < pattern.size()) return false;
+        auto end = prefix ? text.begin() + pattern.size() : text.end();
+        auto pos = caseSensitive ? std::search(text.begin(), end, pattern.begin(), pattern.end()) :
+            std::search(text.begin(), end, pattern.begin(), pattern.end(), [](char lhs, char rhs) {
+                return std::tolower((unsigned char)lhs) == rhs; });
+        return prefix ? pos == text.begin() : pos != end;
+    }
+
+    static bool MatchesFilter(const ItemGridInternalState::ColumnFilter& filter, const ItemGridSortKey& key)
+    {
+        switch (filter.type)
+        {
+        case ItemGridFilterType::Contains: return ContainsText(key.text, filter.text, filter.caseSensitive, false);
+        case ItemGridFilterType::Prefix: return ContainsText(key.text, filter.text, filter.caseSensitive, true);
+        case ItemGridFilterType::Range: return key.number >= filter.min && key.number <= filter.max;
+        case ItemGridFilterType::OneOf:
+            return key.text.empty() ? std::binary_search(filter.numbers.begin(), filter.numbers.end(), key.number) :
+                std::binary_search(filter.texts.begin(), filter.texts.end(), key.text,
+                    [](std::string_view lhs, std::string_view rhs) { return lhs < rhs; });
+        default: return true;
+        }
+    }
+
+    // Keys are extracted on this thread, as the callback need not be thread safe, the predicate
+    // is then evaluated in parallel over chunks of whole bitmap words
+    static void EvaluateFilter(ItemGridInternalState::ColumnFilter& filter, const ItemGridState& config,
+        int32_t total)
+    {
+        RowSortKeys.resize(total);
+        for (auto row = 0; row < total; ++row)
+            RowSortKeys[row] = config.sortkey(row, filter.col);
+
+        auto words = (total + 63) / 64;
+        filter.bits.resize(words);
+        PrepareRowChunks(total);
+
+        auto keys = RowSortKeys.data();
+        auto bits = filter.bits.data();
+        const auto& predicate = filter;
+        ForEachRowChunk(words, [=, &predicate](int32_t, int32_t from, int32_t to) {
+            for (auto word = from; word < to; ++word)
+            {
+                uint64_t mask = 0;
+                auto end = std::min(total - word * 64, 64);
+                for (auto bit = 0; bit < end; ++bit)
+                    if (MatchesFilter(predicate, keys[word * 64 + bit])) mask |= 1ull << bit;
+                bits[word] = mask;
+            }
+        });
+
+        filter.dirty = false;
+    }
+
+    // Rebuilds the visible rows from the filter bitmaps combined word by word, rows are listed in
+    // sorted order if the grid is sorted, otherwise by scanning the set bits of the combined bitmap
+    static void BuildVisibleRows(ItemGridInternalState::RowPermutation& rowmap, int32_t total)
+    {
+        static thread_local std::vector<uint64_t> combined;
+        auto words = (total + 63) / 64;
+        combined.assign(words, rowmap.matchAny ? 0ull : ~0ull);
+
+        for (const auto& filter : rowmap.filters)
+            for (auto word = 0; word < words; ++word)
+                combined[word] = rowmap.matchAny ? combined[word] | filter.bits[word] : 
+                    combined[word] & filter.bits[word];
+
+        rowmap.visible.clear();
+
+        if (!rowmap.vtol.empty())
+        {
+            for (auto row : rowmap.vtol)
+                if (combined[row / 64] & (1ull << (row % 64))) rowmap.visible.push_back(row);
+        }
+        else
+        {
+            for (auto word = 0; word < words; ++word)
+                for (auto mask = combined[word]; mask != 0; mask &= mask - 1)
+                {
+                    auto row = word * 64 + std::countr_zero(mask);
+                    if (row < total) rowmap.visible.push_back(row);
+                }
+        }
+    }
+
+    // Brings the display rows up to date before the grid is populated: re-sorts all or only the
+    // changed rows, re-evaluates edited filters fully and the other filters for changed rows only
+    static void UpdateRowOrder(ItemGridInternalState::RowPermutation& rowmap, const ItemGridState& config,
+        int32_t total)
+    {
+        if (config.sortkey == nullptr)
+        {
+            rowmap.vtol.clear();
+            rowmap.ltov.clear();
+            rowmap.visible.clear();
+            rowmap.filters.clear();
+            rowmap.changed.clear();
+            rowmap.dirty = false;
+            rowmap.rows = total;
+            return;
+        }
+
+        if (rowmap.rows > total)
+        {
+            rowmap.dirty = true;
+            for (auto& filter : rowmap.filters) filter.dirty = true;
+        }
+        else for (auto row = rowmap.rows; row < total; ++row) rowmap.changed.push_back(row);
+
+        auto update = rowmap.dirty || rowmap.refilter || !rowmap.changed.empty();
+
+        if (rowmap.totalSortCols == 0)
+        {
+            rowmap.vtol.clear();
+            rowmap.ltov.clear();
+        }
+        else if (rowmap.dirty || (int32_t)rowmap.changed.size() > GLIMMER_INCREMENTAL_SORT_MAX)
+            SortAllRows(rowmap, config, total);
+        else if (!rowmap.changed.empty())
+            ResortRows(rowmap, config, total);
+
+        for (auto& filter : rowmap.filters)
+        {
+            if (filter.dirty || (int32_t)rowmap.changed.size() > GLIMMER_INCREMENTAL_SORT_MAX)
+            {
+                EvaluateFilter(filter, config, total);
+                update = true;
+            }
+            else
+            {
+                filter.bits.resize((total + 63) / 64, 0);
+
+                for (auto row : rowmap.changed)
+                {
+                    if (row >= total) continue;
+                    auto& word = filter.bits[row / 64];
+                    auto bit = 1ull << (row % 64);
+                    word = MatchesFilter(filter, config.sortkey(row, filter.col)) ? word | bit : word & ~bit;
+                }
+            }
+        }
+
+        if (rowmap.filtered() && update) BuildVisibleRows(rowmap, total);
+
+        rowmap.changed.clear();
+        rowmap.dirty = rowmap.refilter = false;
+        rowmap.rows = total;
+    }
+
+    static void ToggleSortColumn(ItemGridInternalState::RowPermutation& rowmap, int16_t col, bool append)
+    {
+        auto existing = -1;
+        for (auto idx = 0; idx < rowmap.totalSortCols; ++idx)
+            if (rowmap.sortcols[idx].col == col) existing = idx;
+
+        if (!append)
+        {
+            auto ascending = existing == 0 ? !rowmap.sortcols[0].ascending : true;
+            rowmap.sortcols[0] = ItemGridSortColumn{ col, ascending };
+            rowmap.totalSortCols = 1;
+        }
+        else if (existing != -1)
+            rowmap.sortcols[existing].ascending = !rowmap.sortcols[existing].ascending;
+        else if (rowmap.totalSortCols < GLIMMER_MAX_GRID_SORT_COLUMNS)
+            rowmap.sortcols[rowmap.totalSortCols++] = ItemGridSortColumn{ col, true };
+
+        rowmap.dirty = true;
+    }
+
+    void SortItemGrid(int32_t id, const std::initializer_list<ItemGridSortColumn>& columns)
+    {
+        assert((int)columns.size() <= GLIMMER_MAX_GRID_SORT_COLUMNS);
+        auto& rowmap = GetContext().GridState(id).rowmap;
+        rowmap.totalSortCols = 0;
+
+        for (const auto& column : columns)
+            rowmap.sortcols[rowmap.totalSortCols++] = column;
+
+        GetContext().GetState(id).state.grid->sortedcol = rowmap.totalSortCols > 0 ? 
+            rowmap.sortcols[0].col : -1;
+        rowmap.dirty = true;
+    }
+
+    void InvalidateItemGridRows(int32_t id, Span<const int32_t> rows)
+    {
+        auto& gridstate = GetContext().GridState(id);
+        auto& cache = gridstate.pinned;
+
+        for (auto idx = 0; idx < rows.sz; ++idx)
+            gridstate.rowmap.changed.push_back(rows.source[idx]);
+
+        // Pinned cells of these rows are recorded again when next drawn
+        for (auto it = cache.cells.begin(); it != cache.cells.end();)
+        {
+            auto row = (int32_t)(it->first >> 16);
+            if (std::find(rows.source, rows.source + rows.sz, row) != rows.source + rows.sz)
+                it = cache.drop(it);
+            else ++it;
+        }
+
+        for (auto idx = 0; idx < rows.sz; ++idx)
+            gridstate.rowheights.heights.erase(rows.source[idx]);
+    }
+
+    void SetItemGridFilter(int32_t id, int16_t col, const ItemGridFilter& filter)
+    {
+        auto& rowmap = GetContext().GridState(id).rowmap;
+        auto it = std::find_if(rowmap.filters.begin(), rowmap.filters.end(), 
+            [col](const ItemGridInternalState::ColumnFilter& existing) { return existing.col == col; });
+
+        if (filter.type == ItemGridFilterType::None)
+        {
+            if (it != rowmap.filters.end())
+            {
+                rowmap.filters.erase(it);
+                rowmap.refilter = true;
+            }
+
+            return;
+        }
+
+        auto& target = it != rowmap.filters.end() ? *it : rowmap.filters.emplace_back();
+        target.type = filter.type;
+        target.col = col;
+        target.caseSensitive = filter.caseSensitive;
+        target.min = filter.min;
+        target.max = filter.max;
+        target.text = filter.text;
+        target.texts.clear();
+        target.numbers.clear();
+        target.dirty = true;
+
+        // Patterns are lowered once so that matching only lowers the cell text
+        if (!filter.caseSensitive)
+            for (auto& ch : target.text) ch = (char)std::tolower((unsigned char)ch);
+
+        for (const auto& value : filter.values)
+        {
+            if (value.text.empty()) target.numbers.push_back(value.number);
+            else target.texts.emplace_back(value.text);
+        }
+
+        std::sort(target.texts.begin(), target.texts.end());
+        std::sort(target.numbers.begin(), target.numbers.end());
+    }
+
+    void ClearItemGridFilters(int32_t id)
+    {
+        auto& rowmap = GetContext().GridState(id).rowmap;
+        rowmap.filters.clear();
+        rowmap.visible.clear();
+    }
+
+    void CombineItemGridFilters(int32_t id, bool matchAny)
+    {
+        auto& rowmap = GetContext().GridState(id).rowmap;
+        if (rowmap.matchAny != matchAny) rowmap.refilter = true;
+        rowmap.matchAny = matchAny;
+    }
+
+#pragma endregion
+
+#pragma region ItemGrid Tree
+
+    // Loads the children of a node (-1 for the roots) at the end of the loaded nodes
+    static void LoadTreeNodes(ItemGridInternalState::TreeRows& tree, const ItemGridState& config, int32_t parent)
+    {
+        tree.ids.clear();
+        config.nodechildren(parent == -1 ? -1 : tree.nodes[parent].id, tree.ids);
+        auto first = (int32_t)tree.nodes.size();
+        auto depth = parent == -1 ? (int16_t)0 : (int16_t)(tree.nodes[parent].depth + 1);
+        // Grow geometrically, an exact reserve would reallocate on every expansion
+        auto required = tree.nodes.size() + tree.ids.size();
+        if (required > tree.nodes.capacity())
+            tree.nodes.reserve(std::max(required, tree.nodes.capacity() * 2));
+
+        for (auto id : tree.ids)
+        {
+            auto& node = tree.nodes.emplace_back();
+            node.id = id;
+            node.parent = parent;
+            node.depth = depth;
+            node.expandable = config.nodeexpandable == nullptr || config.nodeexpandable(id);
+        }
+
+        if (parent == -1) tree.roots = (int32_t)tree.ids.size();
+        else
+        {
+            auto& node = tree.nodes[parent];
+            node.firstChild = first;
+            node.childCount = (int32_t)tree.ids.size();
+            node.expandable = node.childCount > 0;
+            node.loaded = true;
+        }
+    }
+
+    // Visible nodes in [first, first + count) and their visible descendents in display order,
+    // descendents which were expanded before their ancestor was collapsed are expanded again
+    static void AppendVisibleNodes(const ItemGridInternalState::TreeRows& tree, int32_t first, int32_t count,
+        std::vector<int32_t>& out)
+    {
+        for (auto idx = first; idx < first + count; ++idx)
+        {
+            out.push_back(idx);
+            const auto& node = tree.nodes[idx];
+            if (node.expanded) AppendVisibleNodes(tree, node.firstChild, node.childCount, out);
+        }
+    }
+
+    // Expands or collapses the node at a display row, only its descendents are inserted into
+    // or erased from the visible nodes
+    static void ToggleTreeNode(ItemGridInternalState::TreeRows& tree, const ItemGridState& config, int32_t row)
+    {
+        static thread_local std::vector<int32_t> descendents;
+
+        auto index = tree.visible[row];
+        if (!tree.nodes[index].expandable) return;
+
+        if (tree.nodes[index].expanded)
+        {
+            auto depth = tree.nodes[index].depth;
+            auto end = row + 1;
+            while (end < (int32_t)tree.visible.size() && tree.nodes[tree.visible[end]].depth > depth) ++end;
+            tree.visible.erase(tree.visible.begin() + row + 1, tree.visible.begin() + end);
+            tree.nodes[index].expanded = false;
+        }
+        else
+        {
+            if (!tree.nodes[index].loaded) LoadTreeNodes(tree, config, index);
+            if (!tree.nodes[index].expandable) return;
+
+            const auto& node = tree.nodes[index];
+            descendents.clear();
+            AppendVisibleNodes(tree, node.firstChild, node.childCount, descendents);
+            tree.visible.insert(tree.visible.begin() + row + 1, descendents.begin(), descendents.end());
+            tree.nodes[index].expanded = true;
+        }
+    }
+
+    static void UpdateTreeRows(ItemGridInternalState::TreeRows& tree, const ItemGridState& config)
+    {
+        if (!tree.loaded)
+        {
+            tree.nodes.clear();
+            tree.visible.clear();
+            LoadTreeNodes(tree, config, -1);
+            tree.visible.resize(tree.roots);
+            std::iota(tree.visible.begin(), tree.visible.end(), 0);
+            tree.loaded = true;
+        }
+
+        if (tree.toggled >= 0 && tree.toggled < (int32_t)tree.visible.size())
+            ToggleTreeNode(tree, config, tree.toggled);
+        tree.toggled = -1;
+    }
+
+    // Data row passed to the grid's callbacks for a top-level display row
+    static int32_t DataRow(const ItemGridInternalState& gridstate, const ItemGridState& config, int32_t row)
+    {
+        return config.nodechildren != nullptr ? gridstate.tree.id(row) : gridstate.rowmap.logical(row);
+    }
+
+    static ItemDescendentVisualState TreeNodeVisualState(const ItemGridInternalState::TreeRows::Node& node)
+    {
+        return !node.expandable ? ItemDescendentVisualState::NoDescendent : node.expanded ?
+            ItemDescendentVisualState::Expanded : ItemDescendentVisualState::Collapsed;
+    }
+
+    void ToggleItemGridNode(int32_t id, int32_t row)
+    {
+        auto& context = GetContext();
+        auto& tree = context.GridState(id).tree;
+        if (tree.loaded && row >= 0 && row < (int32_t)tree.visible.size())
+            ToggleTreeNode(tree, *context.GetState(id).state.grid, row);
+    }
+
+    void ResetItemGridTree(int32_t id)
+    {
+        auto& tree = GetContext().GridState(id).tree;
+        tree.loaded = false;
+        tree.toggled = -1;
+    }
+
+#pragma endregion
+
+#pragma region Dynamic ItemGrid
+
+    void RecordItemGeometry(const LayoutItemDescriptor& layoutItem)
+    {
+        auto& context = GetContext();
+
+        if (context.CurrentItemGridContext != nullptr)
+        {
+            auto& grid = context.CurrentItemGridContext->itemGrids.top();
+            if (grid.phase == ItemGridConstructPhase::HeaderCells)
+            {
+                grid.maxHeaderExtent.x = std::max(grid.maxHeaderExtent.x, layoutItem.margin.Max.x);
+                grid.maxHeaderExtent.y = std::max(grid.maxHeaderExtent.y, layoutItem.margin.Max.y);
+            }
+            else
+            {
+                grid.maxCellExtent.x = std::max(grid.maxCellExtent.x, layoutItem.margin.Max.x);
+                grid.maxCellExtent.y = std::max(grid.maxCellExtent.y, layoutItem.margin.Max.y);
+            }
+        }
+    }
+
+    bool StartItemGrid(int32_t id, int32_t geometry, const NeighborWidgets& neighbors)
+    {
+        auto& context = GetContext();
+        auto& state = context.itemGrids.push();
+        const auto style = WidgetContextData::GetStyle(WS_Default);
+
+        state.id = id;
+        state.geometry = geometry;
+        state.neighbors = neighbors;
+        state.origin = context.NextAdHocPos() + ImVec2{ style.margin.left + style.border.left.thickness + style.padding.left,
+            style.margin.top + style.border.top.thickness + style.padding.top };
+        state.nextpos = state.origin;
+
+        LayoutItemDescriptor item;
+        AddExtent(item, style, neighbors);
+        state.size = item.content.GetSize();
+
+        context.CurrentItemGridContext = &context;
+        auto& ctx = PushContext(id);
+        auto& el = ctx.nestedContextStack.push();
+        el.base = &context;
+        el.source = NestedContextSourceType::ItemGrid;
+
+        return true;
+    }
+
+    bool StartItemGridHeader(int levels)
+    {
+        assert(levels > 0 && levels <= 4);
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& state = context.itemGrids.top();
+        auto& itemcfg = *context.GetState(state.id).state.grid;
+
+        state.phase = ItemGridConstructPhase::Headers;
+        state.levels = levels;
+        state.currlevel = state.levels - 1;
+        state.currCol = 0;
+        state.nextpos = state.origin + ImVec2{ itemcfg.gridwidth, itemcfg.gridwidth };
+
+        auto& ctx = GetContext();
+        ctx.ToggleDeferedRendering(true, false);
+        ctx.deferEvents = true;
+
+        return true;
+    }
+
+    static void InitColumnResizeData(WidgetContextData& context, CurrentItemGridState& state, ColumnProps& header)
+    {
+        auto& gridstate = context.GridState(state.id);
+        gridstate.ensureColumns(state.currlevel, state.currCol + 1);
+    }
+
+    static void AddUserColumnResize(WidgetContextData& context, CurrentItemGridState& state, ColumnProps& header)
+    {
+        auto& gridstate = context.GridState(state.id);
+        InitColumnResizeData(context, state, header);
+        auto modified = gridstate.cols[state.currlevel][state.currCol].modified;
+        header.extent.Max.x += modified;
+    }
+
+    // Only compute bounds, position them in header end (for visual order)
+    // Integrate layout mechanism, add max computation?
+    void StartHeaderColumn(const ItemGridState::ColumnConfig& config)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& state = context.itemGrids.top();
+        auto& header = state.headers[state.currlevel].emplace_back(config);
+        auto& itemcfg = *context.GetState(state.id).state.grid;
+        auto& renderer = GetContext().GetRenderer();
+        const auto style = WidgetContextData::GetStyle(context.states.flags(state.id));
+
+        state.phase = ItemGridConstructPhase::HeaderCells;
+        header.extent.Min = state.nextpos;
+        header.content.Min = header.extent.Min + itemcfg.cellpadding;
+        static thread_local char buffer[256] = { 0 };
+
+        if (state.currlevel == (state.levels - 1))
+        {
+            memset(buffer, ' ', 255);
+
+            auto width = (config.props & COL_WidthAbsolute) ? config.width :
+                config.width > 0.f ? renderer.GetTextSize(std::string_view{ buffer, (size_t)config.width },
+                    style.font.font, style.font.size).x : FLT_MAX;
+
+            header.content.Max.x = header.content.Min.x + width;
+            header.extent.Max.x = width == FLT_MAX ? FLT_MAX : header.content.Max.x + itemcfg.cellpadding.x;
+            if (width != FLT_MAX) AddUserColumnResize(context, state, header);
+        }
+        else assert(false); // For higher levels, use column category APIs
+
+        if (config.width != 0.f)
+        {
+            auto& ctx = GetContext();
+            auto& id = ctx.containerStack.push();
+            id = state.id;
+            state.addedBounds = true;
+        }
+
+        GetContext().adhocLayout.top().nextpos = state.nextpos;
+    }
+
+    void EndHeaderColumn()
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& state = context.itemGrids.top();
+        const auto& itemcfg = *context.GetState(state.id).state.grid;
+        const auto& header = state.currentHeader();
 
         state.phase = ItemGridConstructPhase::Headers;
         state.headerHeights[state.currlevel] = std::max(state.headerHeights[state.currlevel], header.extent.GetHeight());
@@ -4218,9 +4954,9 @@ namespace glimmer
         StartHeaderColumn(config);
         auto& context = *WidgetContextData::CurrentItemGridContext;
         auto& state = context.itemGrids.top();
-        auto& itemcfg = context.GetState(state.id).state.grid;
+        auto& itemcfg = *context.GetState(state.id).state.grid;
         auto& renderer = *GetContext().deferedRenderer;
-        const auto style = WidgetContextData::GetStyle(itemcfg.state);
+        const auto style = WidgetContextData::GetStyle(context.states.flags(state.id));
         auto& header = state.currentHeader();
 
         header.range.primitives.first = renderer.TotalEnqueued();
@@ -4248,7 +4984,7 @@ namespace glimmer
     {
         auto& context = *WidgetContextData::CurrentItemGridContext;
         auto& state = context.itemGrids.top();
-        auto& itemcfg = context.GetState(state.id).state.grid;
+        auto& itemcfg = *context.GetState(state.id).state.grid;
 
         state.nextpos.x = state.origin.x + itemcfg.gridwidth;
         state.nextpos.y = state.origin.y + itemcfg.gridwidth;
@@ -4262,7 +4998,7 @@ namespace glimmer
         auto& context = *WidgetContextData::CurrentItemGridContext;
         auto& state = context.itemGrids.top();
         auto& renderer = *GetContext().deferedRenderer;
-        auto& itemcfg = context.GetState(state.id).state.grid;
+        auto& itemcfg = *context.GetState(state.id).state.grid;
         auto& header = state.headers[state.currlevel].emplace_back(config);
 
         auto parent = state.headers[state.currlevel].size() - 1;
@@ -4306,27 +5042,39 @@ namespace glimmer
         EndHeaderColumn();
     }
 
+    // Whether a column (translated by the horizontal scroll) overlaps the grid's viewport, columns
+    // scrolled entirely under the pinned ones are not visible
+    static bool IsColumnVisible(const CurrentItemGridState& state, const ColumnProps& column)
+    {
+        auto left = column.frozen ? state.origin.x : state.pinnedRight;
+        return column.extent.Max.x >= left && column.extent.Min.x <= state.origin.x + state.size.x;
+    }
+
     WidgetDrawResult EndItemGridHeader()
     {
         WidgetDrawResult result;
         auto& context = *WidgetContextData::CurrentItemGridContext;
         auto& state = context.itemGrids.top();
         auto& gridstate = context.GridState(state.id);
-        auto& config = context.GetState(state.id).state.grid;
+        auto& config = *context.GetState(state.id).state.grid;
         auto& headers = state.headers;
         auto& renderer = context.GetRenderer();
-        const auto style = WidgetContextData::GetStyle(config.state);
+        const auto style = WidgetContextData::GetStyle(context.states.flags(state.id));
         auto io = Config.platform->CurrentIO();
 
         CategorizeColumns();
         assert(state.currlevel < 0);
 
-        // Center align header contents
+        // Center align header contents, and place them at the horizontal scroll position unless
+        // they are pinned, pinned columns are the leading (in display order) COL_Pinned columns
         auto ypos = state.origin.y + config.gridwidth;
+        auto hshift = -gridstate.scroll.state.pos.x;
+        state.pinnedRight = state.origin.x;
 
         for (auto level = 0; level < state.levels; ++level)
         {
             auto totalw = 0.f;
+            gridstate.ensureColumns(level, state.headers[level].size());
 
             for (auto col = 0; col < state.headers[level].size(); ++col)
             {
@@ -4335,8 +5083,19 @@ namespace glimmer
                     gridstate.colmap[level].ltov[col] = col;
                     gridstate.colmap[level].vtol[col] = col;
                 }
+            }
+
+            for (int16_t vcol = 0; vcol < state.headers[level].size(); ++vcol)
+            {
+                auto& header = state.headers[level][gridstate.colmap[level].vtol[vcol]];
+                if (!(header.props & COL_Pinned)) break;
+                header.frozen = true;
+            }
 
+            for (auto col = 0; col < state.headers[level].size(); ++col)
+            {
                 auto& header = state.headers[level][col];
+                auto shift = header.frozen ? 0.f : hshift;
                 auto hdiff = header.extent.GetWidth() - header.content.GetWidth() - (2.f * config.cellpadding.x);
                 auto vdiff = state.headerHeights[level] - header.content.GetHeight() - (2.f * config.cellpadding.y);
 
@@ -4353,18 +5112,27 @@ namespace glimmer
                 if (hdiff >= 2.f) header.content.TranslateX(hdiff * 0.5f);
                 if (vdiff >= 2.f) header.content.TranslateY(vdiff * 0.5f);
 
-                header.offset.x = header.content.Min.x - header.offset.x;
+                header.offset.x = header.content.Min.x - header.offset.x + shift;
                 header.offset.y = header.content.Min.y - header.offset.y;
 
+                // Grids narrower than the available width shrink to fit, wider ones scroll
                 if (level == 0 && ((state.headers[level].size() - 1) == col))
-                    state.size.x = header.extent.Max.x - state.origin.x + config.gridwidth;
+                {
+                    state.totalsz.x = header.extent.Max.x + config.gridwidth;
+                    state.size.x = std::min(state.size.x, state.totalsz.x - state.origin.x);
+                }
+
+                header.extent.TranslateX(shift);
+                header.content.TranslateX(shift);
+
+                if (header.frozen && level == state.levels - 1)
+                    state.pinnedRight = std::max(state.pinnedRight, header.extent.Max.x + config.gridwidth);
             }
 
             ypos += state.headerHeights[level] + config.gridwidth;
             state.headerHeight += state.headerHeights[level] + config.gridwidth;
         }
 
-        auto hshift = -gridstate.scroll.state.pos.x;
         auto& ctx = GetContext();
         state.phase = ItemGridConstructPhase::HeaderPlacement;
         std::pair<int16_t, int16_t> movingColRange = { INT16_MAX, -1 }, nextMovingRange = { INT16_MAX, -1 };
@@ -4399,17 +5167,23 @@ namespace glimmer
                     if (level == state.levels - 1)
                         state.movingCols = nextMovingRange;
                 }
-                else
+                else if (IsColumnVisible(state, hdr))
                 {
+                    // Scrolled headers slide under the pinned ones
+                    auto clipped = !hdr.frozen && state.pinnedRight > state.origin.x;
+                    if (clipped) Config.renderer->SetClipRect({ state.pinnedRight, state.origin.y }, 
+                        state.origin + state.size);
+
                     Config.renderer->DrawRect(hdr.extent.Min - ImVec2{ config.gridwidth, config.gridwidth },
                         hdr.extent.Max + ImVec2{ config.gridwidth, config.gridwidth }, config.gridcolor, false,
                         config.gridwidth);
                     renderer.SetClipRect(hdr.extent.Min, hdr.extent.Max);
-                    ctx.deferedRenderer->Render(*Config.renderer, hdr.offset + ImVec2{ hshift, 0.f },
+                    ctx.deferedRenderer->Render(*Config.renderer, hdr.offset,
                         hdr.range.primitives.first, hdr.range.primitives.second);
                     auto res = ctx.HandleEvents(hdr.offset, hdr.range.events.first, hdr.range.events.second);
                     auto interacted = res.event != WidgetEvent::None;
                     renderer.ResetClipRect();
+                    if (clipped) Config.renderer->ResetClipRect();
 
                     if (!interacted)
                     {
@@ -4427,6 +5201,12 @@ namespace glimmer
                         {
                             result.event = WidgetEvent::Clicked;
                             result.col = col;
+
+                            if (config.sortkey != nullptr && level == state.levels - 1)
+                            {
+                                ToggleSortColumn(gridstate.rowmap, col, io.modifiers & ShiftKeyMod);
+                                config.sortedcol = gridstate.rowmap.sortcols[0].col;
+                            }
                         }
                     }
                 }
@@ -4434,7 +5214,7 @@ namespace glimmer
         }
 
         state.nextpos.y = ypos - gridstate.scroll.state.pos.y;
-        state.nextpos.x = state.origin.x + hshift;
+        state.nextpos.x = state.origin.x - gridstate.scroll.state.pos.x;
         state.phase = ItemGridConstructPhase::Headers;
         state.currlevel = state.levels - 1;
         ctx.ToggleDeferedRendering(false, false);
@@ -4449,9 +5229,12 @@ namespace glimmer
         state.inRow = byRows;
     }
 
-    static void DrawItemDescendentSymbol(WidgetContextData& context, CurrentItemGridState& state,
+    // Draws the expand/collapse symbol of column 0, returns true if it was clicked
+    static bool DrawItemDescendentSymbol(WidgetContextData& context, CurrentItemGridState& state,
         ItemDescendentVisualState descendents)
     {
+        auto clicked = false;
+
         if (state.currCol == 0)
         {
             ImVec2 start = state.nextpos;
@@ -4467,37 +5250,43 @@ namespace glimmer
                     SymbolIcon::RightTriangle : SymbolIcon::DownTriangle, style.fgcolor, style.fgcolor, 1.f,
                     renderer);
                 renderer.ResetClipRect();
+
+                auto io = Config.platform->CurrentIO();
+                clicked = io.clicked() && ImRect{ start, end }.Contains(io.mousepos);
             }
 
             state.nextpos.x = end.x;
         }
+
+        return clicked;
     }
 
     static WidgetDrawResult PopulateData(int totalRows);
 
-    static float HAlignCellContent(CurrentItemGridState& state, const ItemGridState& config, int16_t col, float width)
+    static float HAlignCellContent(int32_t alignment, float totalw, float width)
     {
-        auto alignment = state.headers[state.levels - 1][col].alignment;
         auto hdiff = 0.f;
 
         if (alignment & TextAlignHCenter)
         {
-            auto totalw = state.headers[state.currlevel][col].extent.GetWidth() - (2.f * config.cellpadding.x);
             hdiff = std::max(0.f, totalw - width) * 0.5f;
         }
         else if (alignment & TextAlignRight)
         {
-            auto totalw = state.headers[state.currlevel][col].extent.GetWidth() - (2.f * config.cellpadding.x);
             hdiff = std::max(0.f, totalw - width);
         }
 
         return hdiff;
     }
 
-    static float VAlignCellContent(CurrentItemGridState& state, const ItemGridState& config, int16_t col,
-        float maxh, float height)
+    static float HAlignCellContent(CurrentItemGridState& state, const ItemGridState& config, int16_t col, float width)
+    {
+        auto totalw = state.headers[state.currlevel][col].extent.GetWidth() - (2.f * config.cellpadding.x);
+        return HAlignCellContent(state.headers[state.levels - 1][col].alignment, totalw, width);
+    }
+
+    static float VAlignCellContent(int32_t alignment, float maxh, float height)
     {
-        auto alignment = state.headers[state.levels - 1][col].alignment;
         auto vdiff = 0.f;
 
         if (alignment & TextAlignVCenter)
@@ -4512,53 +5301,446 @@ namespace glimmer
         return vdiff;
     }
 
+    static float VAlignCellContent(CurrentItemGridState& state, const ItemGridState& config, int16_t col,
+        float maxh, float height)
+    {
+        return VAlignCellContent(state.headers[state.levels - 1][col].alignment, maxh, height);
+    }
+
+    // Records a cell's content by invoking celldata, into the pinned cell cache if cacheable.
+    // Returns true if the cell's expand/collapse symbol was clicked.
+    static bool RecordCellData(WidgetContextData& context, CurrentItemGridState& state,
+        ItemGridInternalState& gridstate, const ItemGridState& config, WidgetDrawResult& result,
+        std::pair<float, float> bounds, ItemDescendentVisualState vstate, int32_t lrow, int16_t col,
+        int16_t depth, bool cacheable)
+    {
+        auto& cache = gridstate.pinned;
+        auto& cell = state.headers[state.levels][col];
+        auto frame = context.deferedRenderer;
+        auto io = Config.platform->CurrentIO();
+        ImVec2 origin{ bounds.first, state.nextpos.y };
+
+        if (cacheable)
+        {
+            if (!cache.renderer) cache.renderer.reset(CreateRetainedRenderer(&ImGuiMeasureText));
+            context.deferedRenderer = cache.renderer.get();
+        }
+
+        cell.range.events.first = context.deferedEvents.size();
+        cell.range.primitives.first = context.deferedRenderer->TotalEnqueued();
+
+        // Column 0 is indented by depth, its content follows the expand/collapse symbol
+        state.nextpos.x = bounds.first + (col == 0 ? state.cellIndent : 0.f);
+        auto toggled = vstate != ItemDescendentVisualState::NoDescendent &&
+            DrawItemDescendentSymbol(context, state, vstate);
+
+        GetContext().adhocLayout.top().nextpos.x = state.nextpos.x;
+        auto res = config.celldata(bounds, lrow, col, depth);
+        if (res.event != WidgetEvent::None) result = res;
+
+        cell.range.events.second = context.deferedEvents.size();
+        cell.range.primitives.second = context.deferedRenderer->TotalEnqueued();
+        context.deferedRenderer = frame;
+
+        // Hovered cells are drawn live so that their widgets reflect the pointer, and are
+        // recorded again once the pointer leaves them
+        auto key = ItemGridInternalState::PinnedCellCache::key(lrow, col);
+        auto hovered = ImRect{ origin, ImVec2{ bounds.second, state.maxCellExtent.y } }.Contains(io.mousepos);
+
+        if (cacheable && !hovered)
+        {
+            auto& cached = cache.cells[key];
+            cached.used = cache.frame;
+            cached.origin = origin;
+            cached.width = bounds.second - bounds.first;
+            cached.bottom = state.maxCellExtent.y - origin.y;
+            cached.range.primitives = cell.range.primitives;
+            cached.range.events.first = (int)cache.events.size();
+
+            for (auto idx = cell.range.events.first; idx < cell.range.events.second; ++idx)
+                cache.events.push_back(context.deferedEvents[idx]);
+
+            cached.range.events.second = (int)cache.events.size();
+            cell.source = cache.renderer.get();
+        }
+        else if (cacheable)
+        {
+            // Recorded once while hovered, the commands are left for the next reclaim
+            ++cache.stale;
+            cache.hovered = key;
+            cell.source = cache.renderer.get();
+        }
+        else if (cache.hovered == key && !hovered)
+            cache.hovered = -1;
+
+        return toggled;
+    }
+
+    // Adds the recorded events of a cached cell to this frame's events, returns its height
+    static float ReplayCellData(WidgetContextData& context, CurrentItemGridState& state,
+        ItemGridInternalState& gridstate, const ItemGridInternalState::CachedCell& cached,
+        int16_t col, ImVec2 origin)
+    {
+        auto& cache = gridstate.pinned;
+        auto& cell = state.headers[state.levels][col];
+        cell.source = cache.renderer.get();
+        cell.shift = origin - cached.origin;
+        cell.range.primitives = cached.range.primitives;
+        cell.range.events.first = context.deferedEvents.size();
+
+        for (auto idx = cached.range.events.first; idx < cached.range.events.second; ++idx)
+            context.deferedEvents.emplace_back(cache.events[idx]);
+
+        cell.range.events.second = context.deferedEvents.size();
+        GetContext().adhocLayout.top().nextpos.x = state.nextpos.x = origin.x;
+        return origin.y + cached.bottom - state.headers[state.levels - 1][col].content.Min.y;
+    }
+
+    // Cells which were not drawn in the grid's last draw (scrolled out of view) are dropped, so the
+    // cache is bounded by the visible pinned cells. Commands of dropped cells are reclaimed by
+    // recording every pinned cell afresh once they outnumber the cells in use.
+    static void ReclaimPinnedCells(ItemGridInternalState::PinnedCellCache& cache)
+    {
+        for (auto it = cache.cells.begin(); it != cache.cells.end();)
+        {
+            if (it->second.used != cache.frame) it = cache.drop(it);
+            else ++it;
+        }
+
+        ++cache.frame;
+        if (cache.stale <= std::max(64, (int32_t)cache.cells.size())) return;
+
+        if (cache.renderer) cache.renderer->Reset();
+        cache.events.clear();
+        cache.cells.clear();
+        cache.stale = 0;
+    }
+
+    // Requests the contents of visible columns (or only of column `only`) for up to
+    // GLIMMER_GRID_FETCH_ROWS top-level rows starting at display row `from`, numbers are formatted once here
+    static void FetchColumnBlock(CurrentItemGridState& state, ItemGridInternalState& gridstate,
+        const ItemGridState& config, int32_t from, int32_t remaining, int16_t only = -1)
+    {
+        constexpr int32_t DigitsSz = 32;
+        auto& block = gridstate.block;
+        auto& leaves = state.headers[state.levels - 1];
+        auto totalcols = (size_t)leaves.size();
+
+        block.from = from;
+        block.count = std::min(GLIMMER_GRID_FETCH_ROWS, remaining);
+        block.rows.resize(block.count);
+        block.cols.assign(totalcols, ItemGridColumnData{});
+        block.texts.resize(totalcols * GLIMMER_GRID_FETCH_ROWS);
+        block.numbers.resize(totalcols * GLIMMER_GRID_FETCH_ROWS);
+        block.digits.resize(totalcols * GLIMMER_GRID_FETCH_ROWS * DigitsSz);
+        block.plainOnly = true;
+
+        for (auto idx = 0; idx < block.count; ++idx)
+            block.rows[idx] = DataRow(gridstate, config, from + idx);
+
+        for (int16_t col = 0; col < leaves.size(); ++col)
+        {
+            if (!IsColumnVisible(state, leaves[col]) || (only != -1 && col != only)) continue;
+
+            auto& data = block.cols[col];
+            data.texts = block.texts.data() + col * GLIMMER_GRID_FETCH_ROWS;
+            data.numbers = block.numbers.data() + col * GLIMMER_GRID_FETCH_ROWS;
+            config.columndata(col, block.rows.data(), block.count, data);
+            block.plainOnly = block.plainOnly && data.kind != ItemGridCellKind::Widget;
+
+            if (data.kind == ItemGridCellKind::Number)
+            {
+                for (auto idx = 0; idx < block.count; ++idx)
+                {
+                    auto buffer = block.digits.data() + (col * GLIMMER_GRID_FETCH_ROWS + idx) * DigitsSz;
+                    auto res = data.precision < 0 ? std::to_chars(buffer, buffer + DigitsSz, data.numbers[idx]) :
+                        std::to_chars(buffer, buffer + DigitsSz, data.numbers[idx], std::chars_format::fixed, 
+                            data.precision);
+                    if (res.ec != std::errc{}) res = std::to_chars(buffer, buffer + DigitsSz, data.numbers[idx]);
+                    data.texts[idx] = std::string_view{ buffer, (size_t)(res.ptr - buffer) };
+                }
+            }
+        }
+    }
+
+    // Advances of the printable ASCII glyphs of a font, each is measured over a run of the glyph
+    // so that sums of them keep sub-pixel precision
+    struct AsciiAdvances
+    {
+        void* font = nullptr;
+        float size = 0.f;
+        float advance[95];
+    };
+
+    // Width of a plain cell's text, glyph advances are measured once per font and summed for ASCII
+    // text (which is exact for renderers without kerning), other text is measured by the renderer
+    static float PlainTextWidth(std::string_view text, const FontStyle& font)
+    {
+        static thread_local AsciiAdvances advances;
+        constexpr int RunSz = 64;
+        auto& renderer = *Config.renderer;
+
+        if (advances.font != font.font || advances.size != font.size)
+        {
+            char run[RunSz];
+            advances.font = font.font;
+            advances.size = font.size;
+
+            for (auto ch = 32; ch < 127; ++ch)
+            {
+                std::memset(run, ch, RunSz);
+                advances.advance[ch - 32] = renderer.GetTextSize(std::string_view{ run, RunSz },
+                    font.font, font.size).x / (float)RunSz;
+            }
+        }
+
+        auto width = 0.f;
+
+        for (auto ch : text)
+        {
+            auto code = (unsigned char)ch;
+            if (code < 32 || code >= 127) return renderer.GetTextSize(text, font.font, font.size).x;
+            width += advances.advance[code - 32];
+        }
+
+        return width;
+    }
+
+    // Plain cells have no widgets, a single hit-test reports hover and clicks on them. Only the part
+    // of the cell left visible by the clip rects it is drawn with is tested, so cells scrolled under
+    // the headers, pinned rows or pinned columns do not take events from the cells drawn over them.
+    static void HitTestPlainCell(CurrentItemGridState& state, const ItemGridState& config, const ColumnProps& column,
+        const ImRect& extent, int32_t lrow, int16_t col, int16_t depth)
+    {
+        auto io = Config.platform->CurrentIO();
+        ImRect visible{ state.origin + ImVec2{ 0.f, state.headerHeight }, state.origin + state.size };
+        if (!column.frozen && state.pinnedRight > state.origin.x) visible.Min.x = std::max(visible.Min.x, state.pinnedRight);
+        if (!state.inPinnedRow && config.config.pinnedRows > 0) visible.Min.y = std::max(visible.Min.y, state.pinnedBottom);
+
+        auto hit = extent;
+        hit.ClipWithFull(visible);
+        if (!hit.Contains(io.mousepos)) return;
+
+        state.event.id = state.id;
+        state.event.event = io.clicked() ? WidgetEvent::Clicked : WidgetEvent::Hovered;
+        state.event.row = lrow;
+        state.event.col = col;
+        state.event.depth = depth;
+        state.event.geometry = extent;
+    }
+
+    // Draws a Text/Number cell directly, the current font is the default style's. Text starts
+    // `lead` pixels into the cell, after the indent and symbol of tree nodes.
+    static void DrawPlainCell(const ItemGridState& config, const ItemGridColumnData& data, std::string_view text,
+        const ImRect& extent, float maxh, const StyleDescriptor& style, float lead)
+    {
+        auto& renderer = *Config.renderer;
+        auto width = PlainTextWidth(text, style.font);
+        auto avail = extent.GetWidth() - (2.f * config.cellpadding.x) - lead;
+        auto hdiff = HAlignCellContent(data.alignment, avail, width);
+        auto vdiff = VAlignCellContent(data.alignment, maxh, extent.GetHeight());
+
+        auto overflows = width > avail;
+        if (overflows) renderer.SetClipRect(extent.Min, ImVec2{ extent.Max.x - config.cellpadding.x, 
+            extent.Min.y + maxh });
+        renderer.DrawText(text, extent.Min + config.cellpadding + ImVec2{ lead + hdiff, vdiff },
+            data.color != 0 ? data.color : style.fgcolor);
+        if (overflows) renderer.ResetClipRect();
+    }
+
     static void AddRowData(WidgetContextData& context, CurrentItemGridState& state,
         ItemGridInternalState& gridstate, const ItemGridState& config, WidgetDrawResult& result,
         int totalRows)
     {
         auto row = 0;
+        auto& cache = gridstate.pinned;
+        auto& leaves = state.headers[state.levels - 1];
+        auto scrolly = gridstate.scroll.state.pos.y;
+        auto io = Config.platform->CurrentIO();
         state.phase = ItemGridConstructPhase::Rows;
 
+        // Top-level rows are fetched in blocks from the columnar source if there is one, rows
+        // which only have plain cells are one line high and are skipped when not in view
+        auto& block = gridstate.block;
+        auto columnar = state.depth == 0 && config.columndata != nullptr;
+        auto tree = state.depth == 0 && config.nodechildren != nullptr;
+        const auto style = WidgetContextData::GetStyle(WS_Default);
+        const auto plainh = style.font.size + config.cellpadding.y;
+        const auto plainRowh = plainh + config.cellpadding.y + config.gridwidth;
+        auto& rowheights = gridstate.rowheights;
+        if (columnar) block.count = 0;
+
+        // Cell contents wrap to their column's width, heights measured at other widths or for a
+        // different set of rows are stale
+        if (state.depth == 0)
+        {
+            auto widths = 0.f;
+            for (auto col = 0; col < leaves.size(); ++col) widths += leaves[col].extent.GetWidth();
+            if (widths != rowheights.widths || totalRows != rowheights.rows) rowheights.heights.clear();
+            rowheights.widths = widths;
+            rowheights.rows = totalRows;
+        }
+
+        // Height a skipped top-level row takes, as last drawn or a plain row if it was not taller
+        auto skippedRowh = [&](int32_t display) {
+            auto it = rowheights.heights.find(DataRow(gridstate, config, display));
+            return it != rowheights.heights.end() ? it->second.height + config.cellpadding.y + config.gridwidth :
+                plainRowh;
+        };
+
         while (totalRows > 0)
         {
             auto coloffset = 1;
             auto maxh = 0.f;
+            int16_t tallest = -1;
+
+            // Pinned rows are placed as if the grid was not scrolled vertically, rows below
+            // them scroll under them
+            auto pinnedRow = state.depth == 0 && row < config.config.pinnedRows;
+
+            if (columnar && block.plainOnly && !pinnedRow)
+            {
+                auto top = std::max(state.origin.y + state.headerHeight, state.pinnedBottom);
+                auto below = state.nextpos.y > state.origin.y + state.size.y;
+                auto skipped = 0;
+                auto skippedh = 0.f;
+
+                if (rowheights.heights.empty())
+                {
+                    skipped = below ? totalRows : state.nextpos.y + plainRowh < top ? std::min(totalRows,
+                        (int)((top - state.nextpos.y) / plainRowh)) : 0;
+                    skippedh = (float)skipped * plainRowh;
+                }
+                else
+                {
+                    for (; skipped < totalRows; ++skipped)
+                    {
+                        auto rowh = skippedRowh(row + skipped);
+                        if (!below && state.nextpos.y + skippedh + rowh >= top) break;
+                        skippedh += rowh;
+                    }
+                }
+
+                if (skipped > 0)
+                {
+                    state.nextpos.y += skippedh;
+                    GetContext().adhocLayout.top().nextpos.y = state.nextpos.y;
+                    totalRows -= skipped;
+                    row += skipped;
+                    continue;
+                }
+            }
 
-            for (auto vcol = 0; vcol < state.headers[state.levels - 1].size(); vcol += coloffset)
+            if (columnar && (row < block.from || row >= block.from + block.count))
+                FetchColumnBlock(state, gridstate, config, row, totalRows);
+
+            if (pinnedRow)
+            {
+                state.nextpos.y += scrolly;
+                state.inPinnedRow = true;
+                GetContext().adhocLayout.top().nextpos.y = state.nextpos.y;
+            }
+
+            // Tree grids are flat, every display row is a visible node indented by its depth
+            const auto* node = tree ? &gridstate.tree.nodes[gridstate.tree.visible[row]] : nullptr;
+            if (node != nullptr) state.cellIndent = (float)node->depth * config.config.indent;
+
+            for (auto vcol = 0; vcol < leaves.size(); vcol += coloffset)
             {
                 auto col = gridstate.colmap[state.levels - 1].vtol[vcol];
+                coloffset = 1;
+
+                if (!IsColumnVisible(state, leaves[col])) continue;
 
                 if (col < state.movingCols.first || col > state.movingCols.second)
                 {
-                    auto [rowspan, colspan, children, vstate, align] = config.cellprops(row, col);
+                    if (columnar && block.plain(col) != nullptr)
+                    {
+                        auto& extent = leaves[col].extent;
+                        extent.Min.y = state.nextpos.y;
+                        extent.Max.y = state.nextpos.y + plainh;
+                        if (plainh > maxh) tallest = col;
+                        maxh = std::max(maxh, plainh);
+
+                        if (node != nullptr && col == 0 && node->expandable && io.clicked())
+                        {
+                            auto start = extent.Min + config.cellpadding + ImVec2{ state.cellIndent, 0.f };
+                            if (ImRect{ start, start + ImVec2{ style.font.size, style.font.size } }.Contains(io.mousepos))
+                                gridstate.tree.toggled = row;
+                        }
+
+                        continue;
+                    }
+
+                    auto lrow = state.depth == 0 ? DataRow(gridstate, config, row) : row;
+                    auto [rowspan, colspan, children, vstate, align] = config.cellprops(lrow, col);
+
+                    if (node != nullptr)
+                    {
+                        vstate = TreeNodeVisualState(*node);
+                        children = 0;
+                    }
+
                     state.currCol = col;
-                    state.currRow = row;
+                    state.currRow = lrow;
 
                     context.ToggleDeferedRendering(true, false);
                     context.deferEvents = true;
                     std::pair<float, float> bounds;
-                    bounds.first = state.headers[state.levels - 1][col].extent.Min.x;
-                    bounds.second = state.headers[state.levels - 1][col + coloffset - 1].extent.Max.x;
-                    state.headers[state.levels][col].range.events.first = context.deferedEvents.size();
-                    state.headers[state.levels][col].range.primitives.first = context.deferedRenderer->TotalEnqueued();
-
-                    if (vstate != ItemDescendentVisualState::NoDescendent)
-                        DrawItemDescendentSymbol(context, state, vstate);
-
-                    GetContext().adhocLayout.top().nextpos.x = state.nextpos.x = bounds.first;
-                    auto res = config.celldata(bounds, row, col, state.depth);
-                    if (res.event != WidgetEvent::None) result = res;
-                    auto height = state.maxCellExtent.y - state.headers[state.levels - 1][col].content.Min.y;
+                    bounds.first = leaves[col].extent.Min.x;
+                    bounds.second = leaves[col + coloffset - 1].extent.Max.x;
+                    ImVec2 origin{ bounds.first, state.nextpos.y };
+                    auto& cell = state.headers[state.levels][col];
+                    cell.source = nullptr;
+                    cell.shift = ImVec2{};
+
+                    // Cells of pinned rows and columns are recorded once and replayed at their
+                    // current position, until they are resized, hovered or their row is invalidated
+                    auto expanded = vstate == ItemDescendentVisualState::Expanded && children > 0;
+                    auto key = ItemGridInternalState::PinnedCellCache::key(lrow, col);
+                    auto cacheable = (pinnedRow || leaves[col].frozen) && state.depth == 0 && !expanded &&
+                        cache.hovered != key && (node == nullptr || col != 0);
+                    auto cached = cacheable ? cache.cells.find(key) : cache.cells.end();
+
+                    if (cached != cache.cells.end())
+                    {
+                        const auto& entry = cached->second;
+                        auto hovered = ImRect{ origin, origin + ImVec2{ entry.width, entry.bottom } }.Contains(io.mousepos);
+
+                        if (hovered || entry.width != bounds.second - bounds.first)
+                        {
+                            cache.drop(cached);
+                            cached = cache.cells.end();
+                            if (hovered) cache.hovered = key;
+                            cacheable = !hovered;
+                        }
+                    }
+
+                    auto height = 0.f;
+
+                    if (cached != cache.cells.end())
+                    {
+                        cached->second.used = cache.frame;
+                        height = ReplayCellData(context, state, gridstate, cached->second, col, origin);
+                    }
+                    else
+                    {
+                        auto depth = node != nullptr ? node->depth : state.depth;
+                        if (RecordCellData(context, state, gridstate, config, result, bounds, vstate, lrow, col,
+                            depth, cacheable) && node != nullptr)
+                            gridstate.tree.toggled = row;
+                        height = state.maxCellExtent.y - leaves[col].content.Min.y;
+                    }
+
+                    if (height > maxh) tallest = col;
                     maxh = std::max(maxh, height);
 
-                    auto& extent = state.headers[state.levels - 1][col].extent;
+                    auto& extent = leaves[col].extent;
                     extent.Min = ImVec2{ bounds.first, state.nextpos.y };
                     extent.Max = ImVec2{ bounds.second, height + state.nextpos.y };
-                    state.headers[state.levels][col].alignment = align;
-                    state.headers[state.levels][col].range.events.second = context.deferedEvents.size();
-                    state.headers[state.levels][col].range.primitives.second = context.deferedRenderer->TotalEnqueued();
+                    cell.alignment = align;
 
-                    if (vstate == ItemDescendentVisualState::Expanded && children > 0)
+                    if (expanded)
                     {
                         state.cellIndent += config.config.indent;
                         state.depth++;
@@ -4573,36 +5755,110 @@ namespace glimmer
                 }
             }
 
-            for (auto vcol = 0; vcol < state.headers[state.levels - 1].size(); vcol += coloffset)
+            // The row's current height is recorded, unless it was taller due to a column which is
+            // now scrolled out of view
+            if (state.depth == 0 && (maxh > plainh || !rowheights.heights.empty()))
+            {
+                auto lrow = DataRow(gridstate, config, row);
+                auto it = rowheights.heights.find(lrow);
+
+                if (it != rowheights.heights.end() && it->second.height > maxh && it->second.col < leaves.size() &&
+                    !IsColumnVisible(state, leaves[it->second.col]))
+                    maxh = it->second.height;
+                else if (maxh > plainh) rowheights.heights[lrow] = { maxh, tallest };
+                else if (it != rowheights.heights.end()) rowheights.heights.erase(it);
+            }
+
+            // Rows below the pinned ones are clipped to below them, scrolled columns to the right
+            // of the pinned columns (which lead the display order)
+            auto clips = 0;
+            auto clippedCols = false;
+            auto fontSet = false;
+
+            if (!state.inPinnedRow && config.config.pinnedRows > 0)
+            {
+                Config.renderer->SetClipRect({ state.origin.x, state.pinnedBottom }, state.origin + state.size);
+                ++clips;
+            }
+
+            for (auto vcol = 0; vcol < leaves.size(); vcol += coloffset)
             {
                 auto col = gridstate.colmap[state.levels - 1].vtol[vcol];
+                if (!IsColumnVisible(state, leaves[col])) continue;
 
                 if (col < state.movingCols.first || col > state.movingCols.second)
                 {
-                    auto& extent = state.headers[state.levels - 1][col].extent;
+                    auto& extent = leaves[col].extent;
                     auto hdiff = HAlignCellContent(state, config, col, extent.GetWidth());
                     auto vdiff = VAlignCellContent(state, config, col, maxh, extent.GetHeight());
-                    const auto& range = state.headers[state.levels][col].range;
+                    const auto& cell = state.headers[state.levels][col];
+                    const auto& range = cell.range;
+                    auto& source = cell.source != nullptr ? *cell.source : *context.deferedRenderer;
+                    auto offset = cell.shift + ImVec2{ hdiff, vdiff };
+
+                    if (!leaves[col].frozen && !clippedCols && state.pinnedRight > state.origin.x)
+                    {
+                        Config.renderer->SetClipRect({ state.pinnedRight, state.origin.y }, state.origin + state.size);
+                        clippedCols = true;
+                        ++clips;
+                    }
+
+                    if (!state.inPinnedRow && config.config.pinnedRows > 0 && extent.Max.y < state.pinnedBottom) continue;
 
                     context.ToggleDeferedRendering(false, false);
                     context.deferEvents = false;
                     Config.renderer->DrawRect(extent.Min - ImVec2{ config.gridwidth, config.gridwidth },
                         extent.Max + ImVec2{ config.gridwidth, config.gridwidth }, config.gridcolor, false,
                         config.gridwidth);
-                    context.deferedRenderer->Render(*Config.renderer, ImVec2{ hdiff, vdiff },
-                        range.primitives.first, range.primitives.second);
-                    auto res = context.HandleEvents(ImVec2{ hdiff, vdiff }, range.events.first, range.events.second);
+
+                    if (auto plain = columnar ? block.plain(col) : nullptr; plain != nullptr)
+                    {
+                        auto lead = 0.f;
+                        if (!fontSet) fontSet = Config.renderer->SetCurrentFont(style.font.font, style.font.size);
+
+                        if (node != nullptr && col == 0)
+                        {
+                            auto start = extent.Min + config.cellpadding + ImVec2{ state.cellIndent, 0.f };
+                            lead = state.cellIndent + style.font.size;
+
+                            if (node->expandable)
+                                DrawSymbol(start, start + ImVec2{ style.font.size, style.font.size }, { 2.f, 2.f },
+                                    node->expanded ? SymbolIcon::DownTriangle : SymbolIcon::RightTriangle,
+                                    style.fgcolor, style.fgcolor, 1.f, *Config.renderer);
+                        }
+
+                        DrawPlainCell(config, *plain, plain->texts[row - block.from], extent, maxh, style, lead);
+                        HitTestPlainCell(state, config, leaves[col], ImRect{ extent.Min, ImVec2{ extent.Max.x, 
+                            extent.Min.y + maxh + config.cellpadding.y } }, block.rows[row - block.from], col, 
+                            node != nullptr ? node->depth : 0);
+                        continue;
+                    }
+
+                    source.Render(*Config.renderer, offset, range.primitives.first, range.primitives.second);
+                    auto res = context.HandleEvents(offset, range.events.first, range.events.second);
                     if (res.event != WidgetEvent::None) state.event = res;
                 }
             }
 
+            if (fontSet) Config.renderer->ResetFont();
+            while (clips-- > 0) Config.renderer->ResetClipRect();
+            if (node != nullptr) state.cellIndent = 0.f;
+
             state.nextpos.y += maxh + config.cellpadding.y + config.gridwidth;
+
+            if (pinnedRow)
+            {
+                state.pinnedBottom = state.nextpos.y;
+                state.nextpos.y -= scrolly;
+                state.inPinnedRow = false;
+            }
+
             GetContext().adhocLayout.top().nextpos.y = state.nextpos.y;
             --totalRows;
             ++row;
         }
 
-        state.totalsz = state.nextpos;
+        state.totalsz.y = state.nextpos.y;
     }
 
     static void AddColumnData(WidgetContextData& context, CurrentItemGridState& state,
@@ -4615,16 +5871,54 @@ namespace glimmer
         bounds.first = extent.Min.x + config.cellpadding.x;
         bounds.second = extent.Max.x - config.cellpadding.x;
 
+        auto tree = state.depth == 0 && config.nodechildren != nullptr;
+        auto columnar = state.depth == 0 && config.columndata != nullptr;
+        auto& block = gridstate.block;
+        const auto style = WidgetContextData::GetStyle(WS_Default);
+        auto fontSet = false;
+        if (columnar) block.count = 0;
+
         for (auto row = 0; row < totalRows; ++row)
         {
-            auto [rowspan, colspan, children, vstate, alignment] = config.cellprops(row, col);
+            if (columnar && (row < block.from || row >= block.from + block.count))
+                FetchColumnBlock(state, gridstate, config, row, totalRows - row, (int16_t)col);
+
+            if (auto plain = columnar && !(tree && col == 0) ? block.plain(col) : nullptr; plain != nullptr)
+            {
+                // Plain cells are one line high and drawn directly
+                extent.Min.y = state.nextpos.y;
+                extent.Max.y = state.nextpos.y + style.font.size + (2.f * config.cellpadding.y);
+                Config.renderer->DrawRect(extent.Min - ImVec2{ config.gridwidth, config.gridwidth },
+                    extent.Max + ImVec2{ config.gridwidth, config.gridwidth }, config.gridcolor, false,
+                    config.gridwidth);
+
+                if (!fontSet) fontSet = Config.renderer->SetCurrentFont(style.font.font, style.font.size);
+                DrawPlainCell(config, *plain, plain->texts[row - block.from], extent, extent.GetHeight(), style, 0.f);
+                HitTestPlainCell(state, config, state.headers[state.levels - 1][col], extent,
+                    block.rows[row - block.from], (int16_t)col, tree ? gridstate.tree.nodes[gridstate.tree.visible[row]].depth : 0);
+                state.nextpos.y = extent.Max.y + config.gridwidth;
+                continue;
+            }
+
+            auto lrow = state.depth == 0 ? DataRow(gridstate, config, row) : row;
+            auto [rowspan, colspan, children, vstate, alignment] = config.cellprops(lrow, col);
+            auto depth = state.depth;
             state.currCol = col;
-            state.currRow = row;
+            state.currRow = lrow;
             state.nextpos.y += config.cellpadding.y;
             context.adhocLayout.top().nextpos = state.nextpos;
 
-            if (vstate != ItemDescendentVisualState::NoDescendent)
-                DrawItemDescendentSymbol(context, state, vstate);
+            if (tree)
+            {
+                const auto& node = gridstate.tree.nodes[gridstate.tree.visible[row]];
+                vstate = TreeNodeVisualState(node);
+                children = 0;
+                depth = node.depth;
+            }
+
+            if (vstate != ItemDescendentVisualState::NoDescendent &&
+                DrawItemDescendentSymbol(context, state, vstate) && tree)
+                gridstate.tree.toggled = row;
 
             int32_t ws = WS_Default;
             for (auto idx = 0; idx < WSI_Total; ++idx)
@@ -4640,7 +5934,7 @@ namespace glimmer
             RendererEventIndexRange range;
             range.events.first = context.deferedEvents.size();
             range.primitives.first = context.deferedRenderer->TotalEnqueued();
-            auto res = config.celldata(bounds, row, col, state.depth);
+            auto res = config.celldata(bounds, lrow, col, depth);
             if (res.event != WidgetEvent::None) result = res;
             range.events.second = context.deferedEvents.size();
             range.primitives.second = context.deferedRenderer->TotalEnqueued();
@@ -4690,6 +5984,7 @@ namespace glimmer
             state.maxCellExtent = ImVec2{};
         }
 
+        if (fontSet) Config.renderer->ResetFont();
         state.totalsz.y = state.nextpos.y;
     }
 
@@ -4699,7 +5994,7 @@ namespace glimmer
         auto& context = *WidgetContextData::CurrentItemGridContext;
         auto& state = context.itemGrids.top();
         auto& gridstate = context.GridState(state.id);
-        auto& config = context.GetState(state.id).state.grid;
+        auto& config = *context.GetState(state.id).state.grid;
         auto& renderer = context.GetRenderer();
         auto io = Config.platform->CurrentIO();
         auto& ctx = GetContext();
@@ -4716,15 +6011,23 @@ namespace glimmer
             {
                 auto col = gridstate.colmap[state.levels - 1].vtol[vcol];
                 auto ystart = state.nextpos.y;
-                if (col < state.movingCols.first || col > state.movingCols.second)
+                const auto& header = state.headers[state.levels - 1][col];
+
+                if ((col < state.movingCols.first || col > state.movingCols.second) &&
+                    IsColumnVisible(state, header))
+                {
+                    auto clipped = !header.frozen && state.pinnedRight > state.origin.x;
+                    if (clipped) Config.renderer->SetClipRect({ state.pinnedRight, state.origin.y },
+                        state.origin + state.size);
                     AddColumnData(ctx, state, gridstate, config, result, io, totalRows, col);
+                    if (clipped) Config.renderer->ResetClipRect();
+                }
                 state.nextpos.y = ystart;
                 state.nextpos.x += state.headers[state.levels - 1][col].extent.GetWidth() +
                     config.gridwidth - config.cellpadding.x;
                 ctx.adhocLayout.top().nextpos = state.nextpos;
             }
 
-            state.totalsz.x = state.nextpos.x;
             Config.renderer->ResetClipRect();
         }
 
@@ -4766,7 +6069,7 @@ namespace glimmer
                     {
                         renderer.SetClipRect(hdr.extent.Min, hdr.extent.Max);
                         state.phase = ItemGridConstructPhase::HeaderPlacement;
-                        ctx.deferedRenderer->Render(*Config.renderer, hdr.offset + ImVec2{ hshift, 0.f },
+                        ctx.deferedRenderer->Render(*Config.renderer, hdr.offset,
                             hdr.range.primitives.first, hdr.range.primitives.second);
                         auto res = ctx.HandleEvents(hdr.offset, hdr.range.events.first, hdr.range.events.second);
                         auto interacted = res.event != WidgetEvent::None;
@@ -4800,13 +6103,17 @@ namespace glimmer
         auto& context = *WidgetContextData::CurrentItemGridContext;
         auto& state = context.itemGrids.top();
         auto& gridstate = context.GridState(state.id);
-        const auto& config = context.GetState(state.id).state.grid;
+        const auto& config = *context.GetState(state.id).state.grid;
         auto& renderer = context.GetRenderer();
         auto io = Config.platform->CurrentIO();
 
         ImRect viewport{ state.origin + ImVec2{ 0.f, state.headerHeight }, state.origin + state.size };
+        auto tree = config.nodechildren != nullptr;
+        if (tree) UpdateTreeRows(gridstate.tree, config);
+        else UpdateRowOrder(gridstate.rowmap, config, totalRows);
+        ReclaimPinnedCells(gridstate.pinned);
         renderer.SetClipRect(viewport.Min, viewport.Max);
-        result = PopulateData(totalRows);
+        result = PopulateData(tree ? (int)gridstate.tree.visible.size() : gridstate.rowmap.displayed(totalRows));
         state.phase = ItemGridConstructPhase::None;
         HandleScrollBars(gridstate.scroll, renderer, viewport,
             state.totalsz - state.origin - ImVec2{ 0.f, state.headerHeight }, io);
@@ -4847,7 +6154,7 @@ namespace glimmer
         size.y = (size.y == FLT_MAX) ? extent.y - pos.y : size.y * Config.scaling;
 
         auto id = GetNextId(WT_Charts);
-        auto style = WidgetContextData::GetStyle(context.GetState(id).data.state);
+        auto style = WidgetContextData::GetStyle(context.states.flags(id));
         ImRect bounds{ pos, pos + size };
         bounds.Min = bounds.Min + ImVec2{ style.margin.left, style.margin.top };
         bounds.Max = bounds.Max - ImVec2{ style.margin.right, style.margin.bottom };
@@ -4875,16 +6182,16 @@ namespace glimmer
 
         if (res.geometry.Contains(io.mousepos))
         {
-            auto& state = context.GetState(id);
+            auto state = context.GetState(id);
 
             if (io.mouseWheel != 0.f)
                 res.event = WidgetEvent::Scrolled;
             else if (io.isLeftMouseDown())
             {
-                state.data.state |= WS_Pressed;
+                *state.flags |= WS_Pressed;
                 res.event = WidgetEvent::Pressed;
             }
-            else if (state.data.state & WS_Pressed)
+            else if (*state.flags & WS_Pressed)
             {
 
             }
@@ -4905,7 +6212,7 @@ namespace glimmer
     WidgetDrawResult Widget(int32_t id, WidgetType type, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto& context = GetContext();
-        assert((id & 0xffff) <= (int)context.states[type].size());
+        assert((id & 0xffff) <= context.states.size(type));
         WidgetDrawResult result;
         auto& renderer = context.GetRenderer();
         auto& platform = *Config.platform;
@@ -4919,6 +6226,9 @@ namespace glimmer
         auto io = Config.platform->CurrentIO();
         auto& nestedCtx = !context.nestedContextStack.empty() ? context.nestedContextStack.top() : 
             InvalidSource;
+        // Widgets added to a layout are timed when the layout renders them (RenderWidget)
+        GLIMMER_PROFILE_SCOPE(PP_Widget, type, nestedCtx.source != NestedContextSourceType::Layout || 
+            context.layouts.empty());
 
         if (WidgetContextData::CurrentItemGridContext != nullptr)
         {
@@ -4930,9 +6240,9 @@ namespace glimmer
         switch (type)
         {
         case WT_Label: {
-            auto& state = context.GetState(wid).state.label;
-            // CopyStyle(context.GetStyle(WS_Default), context.GetStyle(state.state));
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.label;
+            // CopyStyle(context.GetStyle(WS_Default), context.GetStyle(context.states.flags(wid)));
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
 
             if (nestedCtx.source == NestedContextSourceType::Layout && !context.layouts.empty())
             {
@@ -4959,9 +6269,9 @@ namespace glimmer
             break;
         }
         case WT_Button: {
-            auto& state = context.GetState(wid).state.button;
-            // CopyStyle(context.GetStyle(WS_Default), context.GetStyle(state.state));
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.button;
+            // CopyStyle(context.GetStyle(WS_Default), context.GetStyle(context.states.flags(wid)));
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
 
             if (nestedCtx.source == NestedContextSourceType::Layout && !context.layouts.empty())
             {
@@ -4987,11 +6297,11 @@ namespace glimmer
             break;
         }
         case WT_RadioButton: {
-            auto& state = context.GetState(wid).state.radio;
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.radio;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
             // CopyStyle(context.GetStyle(WS_Default), style);
             AddExtent(layoutItem, style, neighbors, { style.font.size, style.font.size }, maxxy);
-            auto bounds = RadioButtonBounds(state, layoutItem.margin);
+            auto bounds = RadioButtonBounds(context.states.flags(wid), layoutItem.margin);
 
             if (nestedCtx.source == NestedContextSourceType::Layout && !context.layouts.empty())
             {
@@ -5010,11 +6320,11 @@ namespace glimmer
             break;
         }
         case WT_ToggleButton: {
-            auto& state = context.GetState(wid).state.toggle;
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.toggle;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
             // CopyStyle(context.GetStyle(WS_Default), style);
             AddExtent(layoutItem, style, neighbors, { style.font.size, style.font.size }, maxxy);
-            auto [bounds, textsz] = ToggleButtonBounds(state, layoutItem.content, renderer);
+            auto [bounds, textsz] = ToggleButtonBounds(context.states.flags(wid), layoutItem.content, renderer);
 
             if (bounds.GetArea() != layoutItem.margin.GetArea())
                 layoutItem.margin = layoutItem.border = layoutItem.padding = layoutItem.content = bounds;
@@ -5039,11 +6349,11 @@ namespace glimmer
             break;
         }
         case WT_Checkbox: {
-            auto& state = context.GetState(wid).state.checkbox;
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.checkbox;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
             // CopyStyle(context.GetStyle(WS_Default), style);
             AddExtent(layoutItem, style, neighbors, { style.font.size, style.font.size }, maxxy);
-            auto bounds = CheckboxBounds(state, layoutItem.margin);
+            auto bounds = CheckboxBounds(context.states.flags(wid), layoutItem.margin);
 
             if (bounds.GetArea() != layoutItem.margin.GetArea())
             {
@@ -5072,8 +6382,8 @@ namespace glimmer
             break;
         }
         case WT_Spinner: {
-            auto& state = context.GetState(wid).state.spinner;
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.spinner;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
             // CopyStyle(context.GetStyle(WS_Default), style);
             AddExtent(layoutItem, style, neighbors, { 
                 0.f, style.font.size + style.margin.v() + style.border.v() + style.padding.v() }, maxxy);
@@ -5100,8 +6410,8 @@ namespace glimmer
             break;
         }
         case WT_Slider: {
-            auto& state = context.GetState(wid).state.slider;
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.slider;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
             // CopyStyle(context.GetStyle(WS_Default), style);
             auto deltav = style.margin.v() + style.border.v() + style.padding.v();
             auto deltah = style.margin.h() + style.border.h() + style.padding.h();
@@ -5142,9 +6452,9 @@ namespace glimmer
             break;
         }
         case WT_TextInput: {
-            auto& state = context.GetState(wid).state.input;
-            auto style = WidgetContextData::GetStyle(state.state);
-            //BREAK_IF(state.state & WS_Pressed);
+            auto& state = *context.GetState(wid).state.input;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
+            //BREAK_IF(context.states.flags(wid) & WS_Pressed);
             
             // CopyStyle(context.GetStyle(WS_Default), style);
             auto vdelta = style.margin.v() + style.padding.v() + style.border.v();
@@ -5170,8 +6480,8 @@ namespace glimmer
             break;
         }
         case WT_DropDown: {
-            auto& state = context.GetState(wid).state.dropdown;
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.dropdown;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
             
             // CopyStyle(context.GetStyle(WS_Default), style);
             auto vdelta = style.margin.v() + style.padding.v() + style.border.v();
@@ -5233,8 +6543,8 @@ namespace glimmer
             break;
         }
         case WT_ItemGrid: {
-            auto& state = context.GetState(wid).state.grid;
-            auto style = WidgetContextData::GetStyle(state.state);
+            auto& state = *context.GetState(wid).state.grid;
+            auto style = WidgetContextData::GetStyle(context.states.flags(wid));
             // CopyStyle(context.GetStyle(WS_Default), style);
             AddExtent(layoutItem, style, neighbors);
 
@@ -5331,15 +6641,14 @@ namespace glimmer
 
     int16_t GetNextCount(WidgetType type)
     {
+        AllocationTagScope tag{ AT_WidgetState };
         auto& context = GetContext();
         auto id = context.maxids[type];
         if (type == WT_SplitterRegion || type == WT_Charts) context.maxids[type]++;
         
-        if (id == context.states[type].size())
+        if (id == context.states.size(type))
         {
-            context.states[type].reserve(context.states[type].size() + 32);
-            for (auto idx = 0; idx < 32; ++idx)
-                context.states[type].emplace_back(WidgetConfigData{ type });
+            context.states.resize(type, id + 32);
             switch (type)
             {
             case WT_Checkbox: {
@@ -5373,7 +6682,7 @@ namespace glimmer
         return id;
     }
 
-    WidgetConfigData& GetWidgetConfig(WidgetType type, int16_t id)
+    WidgetConfigData GetWidgetConfig(WidgetType type, int16_t id)
     {
         auto& context = GetContext();
         int32_t wid = id;
@@ -5382,11 +6691,10 @@ namespace glimmer
         if (context.InsideFrame)
             context.tempids[type] = std::min(context.tempids[type], context.maxids[type]);
 
-        auto& state = context.GetState(wid);
-        return state;
+        return context.GetState(wid);
     }
 
-    WidgetConfigData& GetWidgetConfig(int32_t id)
+    WidgetConfigData GetWidgetConfig(int32_t id)
     {
         auto wtype = (WidgetType)(id >> 16);
         return GetWidgetConfig(wtype, (int16_t)(id & 0xffff));
@@ -8,8 +8,8 @@ namespace glimmer
     int32_t GetNextId(WidgetType type);
     int16_t GetNextCount(WidgetType type);
 
-    WidgetConfigData& GetWidgetConfig(WidgetType type, int16_t id);
-    WidgetConfigData& GetWidgetConfig(int32_t id);
+    WidgetConfigData GetWidgetConfig(WidgetType type, int16_t id);
+    WidgetConfigData GetWidgetConfig(int32_t id);
 
     WidgetDrawResult Label(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Button(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
@@ -58,6 +58,26 @@ namespace glimmer
     void PopulateItemGrid(bool byRows);
     WidgetDrawResult EndItemGrid(int totalRows);
 
+    // Sorts the grid's rows by the given columns (requires ItemGridState::sortkey), an empty list
+    // restores data order. Rows whose keys changed are re-positioned after InvalidateItemGridRows.
+    void SortItemGrid(int32_t id, const std::initializer_list<ItemGridSortColumn>& columns);
+
+    // Marks (logical) rows whose data changed. Cells of pinned rows (Configuration::pinnedRows) and
+    // COL_Pinned columns are recorded once and replayed while scrolling, these are recorded again.
+    void InvalidateItemGridRows(int32_t id, Span<const int32_t> rows);
+
+    // Filters the grid's rows by the keys of a column (requires ItemGridState::sortkey), a filter
+    // of type None removes the column's filter. Rows pass if they match all filters, or any of them
+    // after CombineItemGridFilters(id, true).
+    void SetItemGridFilter(int32_t id, int16_t col, const ItemGridFilter& filter);
+    void ClearItemGridFilters(int32_t id);
+    void CombineItemGridFilters(int32_t id, bool matchAny);
+
+    // Tree grids (ItemGridState::nodechildren): expands or collapses the node at a display row,
+    // and drops all loaded nodes so that the tree is loaded again from its roots on the next frame
+    void ToggleItemGridNode(int32_t id, int32_t row);
+    void ResetItemGridTree(int32_t id);
+
     bool StartPlot(std::string_view id, ImVec2 size = { FLT_MAX, FLT_MAX }, int32_t flags = 0);
     WidgetDrawResult EndPlot();
 }